@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <istream>
+
+#include "params.h"
+
+/** @brief Runs many simulations concurrently in a single process.
+ *
+ *  The BatchDriver reads a manifest describing a set of runs and executes
+ *  them on a pool of worker threads. Each run owns its own Params,
+ *  GeometryStructure, ProblemStructure and OutputStructure, so runs share
+ *  nothing except the process. A manifest contains one entry per line:
+ *
+ *  @verbatim
+    # Run a parameter file as-is
+    paramFiles/tauBenchmark/tauBenchmark01
+    # Sweep parameters over a list or an inclusive start:stop:step range.
+    # Multiple keys are varied in lockstep.
+    sweep paramFiles/solCXBenchmark/solCXBenchmark2 geometryParams/M=4,8,16 geometryParams/N=4,8,16
+    sweep exampleParameters problemParams/cfl=0.1:0.5:0.1
+    @endverbatim
+ *
+ *  Each run generated by a `sweep` entry writes its output into a
+ *  subdirectory of the parameter file's `outputPath`, named after the
+ *  overridden values, so that runs never share output files.
+ */
+class BatchDriver {
+  public:
+    /// A single run: a parameter file and the parameter values to override.
+    struct BatchRun {
+      std::string paramFile;
+      std::vector<std::pair<std::string, std::string> > overrides;
+      std::string label;
+    };
+
+    /** Construct a BatchDriver using **nThreads** worker threads. A value of
+     *  zero uses one thread per hardware thread.
+     */
+    BatchDriver (unsigned int nThreads = 0);
+
+    /// Read the runs listed in the manifest file **manifestFile**.
+    void load (const std::string manifestFile);
+    /// Read the runs listed in the manifest stream **manifestStream**.
+    void parse (std::istream &manifestStream);
+
+    /** Execute all runs, returning the number of runs which failed. Failures
+     *  are reported but do not interrupt the remaining runs.
+     */
+    int run();
+
+    const std::vector<BatchRun> &getRuns();
+
+    /** Expand a sweep value specification, either a comma-separated list
+     *  ("4,8,16") or an inclusive numeric range ("0.1:0.5:0.1"), into the
+     *  list of values it describes.
+     */
+    static std::vector<std::string> expandValues (const std::string &spec);
+
+    /** Apply the overrides of **batchRun** to the parameters read from its
+     *  parameter file and, for sweep runs, point the output path at a
+     *  subdirectory named after the run.
+     */
+    static void applyOverrides (const BatchRun &batchRun, Params &params);
+
+  private:
+    void executeRun (const BatchRun &batchRun);
+
+    unsigned int nThreads;
+    std::vector<BatchRun> runs;
+};
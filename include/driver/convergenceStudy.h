@@ -0,0 +1,100 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "geometry/index.h"
+
+/** @brief Runs a refinement ladder and tabulates the discretization error.
+ *
+ *  The ConvergenceStudy runs the problem described by a parameter file on a
+ *  sequence of grids, doubling M and N at each level, without writing any
+ *  field output. The L1, L2 and L-infinity errors of the velocity, pressure
+ *  and temperature fields are computed in-process, either against the
+ *  analytic solution (when the problem has one) or against the restriction
+ *  of the next finer level, along with the observed convergence rates and
+ *  Richardson-extrapolated error estimates.
+ *
+ *  Every level takes its own CFL-limited time steps, so the levels are run
+ *  to the problem's endTime, which is required, and endStep is ignored: a
+ *  common step count would compare the levels at different times.
+ *
+ *  Parameter specification:
+ *  Section/Subsection | Name | Type | Description
+ *  ------------------ | --------- | ---- | -----------
+ *  convergenceParams | levels | int | The number of refinement levels to run (*default 4*)
+ *  convergenceParams | reference | string | 'analytic' or 'finest' (*default 'analytic' when available*)
+ */
+class ConvergenceStudy {
+  public:
+    /// Error norms of a field on a single refinement level
+    struct ErrorNorms {
+      double l1;
+      double l2;
+      double lInf;
+    };
+
+    ConvergenceStudy (const std::string paramFile);
+
+    /// Run every level of the refinement ladder, concurrently.
+    void run();
+
+    /// Write the convergence table for all fields to **tableStream**.
+    void writeTable (std::ostream &tableStream);
+
+    /// Write the convergence table to the run's output directory and stdout.
+    void writeTable();
+
+    /** Area-weighted error norms of **values** against **reference**, each of
+     *  **size** entries on cells of area **cellArea**.
+     */
+    static ErrorNorms errorNorms (const double * values,
+                                  const double * reference,
+                                  const GridIndex size,
+                                  const double cellArea);
+
+    /** @name Fine-to-coarse restriction
+     *  Restrict a field on the (2M)x(2N) grid onto the MxN grid, for
+     *  cell-centered, u-offset and v-offset fields respectively.
+     *  @{
+     */
+    static void restrictCellField (const double * fine, double * coarse, const GridIndex M, const GridIndex N);
+    static void restrictUField    (const double * fine, double * coarse, const GridIndex M, const GridIndex N);
+    static void restrictVField    (const double * fine, double * coarse, const GridIndex M, const GridIndex N);
+    /** @} */
+
+  private:
+    /// The final state of the problem on a single refinement level
+    struct Level {
+      GridIndex M;
+      GridIndex N;
+      double hx;
+      double hy;
+      /// Face and center coordinates, which may be stretched
+      std::vector<double> xFaces;
+      std::vector<double> yFaces;
+      std::vector<double> xCenters;
+      std::vector<double> yCenters;
+      std::vector<double> stokes;
+      std::vector<double> temperature;
+    };
+
+    void runLevel (Level &level, const int refinement);
+    bool hasAnalyticSolution();
+    void analyticSolution (const Level &level, std::vector<double> &stokes);
+    void writeFieldTable (std::ostream &tableStream, const std::string fieldName, const int field);
+
+    std::string paramFile;
+
+    int nLevels;
+    std::string reference;
+
+    std::string forcingModel;
+    std::string boundaryModel;
+    std::string viscosityModel;
+    std::string outputPath;
+    std::string outputFilename;
+
+    std::vector<Level> levels;
+};
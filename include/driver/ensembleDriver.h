@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <istream>
+
+#include "driver/batchDriver.h"
+
+/** @brief Advances an ensemble of simulations in lockstep in one process.
+ *
+ *  The EnsembleDriver reads a manifest in the BatchDriver format and runs
+ *  all of its entries as members of one ensemble. The members must share
+ *  the grid and a constant viscosity field, and so the Stokes matrix, and
+ *  the stokesSolverParams (but for orderingCache and initialGuess); loading
+ *  members that differ in these throws. They may differ in anything else,
+ *  e.g. forcing, initial temperature, transport methods or end time. The Stokes system is assembled and
+ *  factored once and shared by every member, including the half-time
+ *  solves of frommMethod(). At each step the members due a Stokes solve are
+ *  solved together, with their right-hand sides packed into the columns of
+ *  one matrix.
+ *
+ *  @verbatim
+    # Five members differing in the buoyancy forcing
+    sweep exampleParameters problemParams/buoyancyModelParams/thermalExpansion=1:5:1
+    @endverbatim
+ */
+class EnsembleDriver {
+  public:
+    EnsembleDriver();
+
+    /// Read the members listed in the manifest file **manifestFile**.
+    void load (const std::string manifestFile);
+    /// Read the members listed in the manifest stream **manifestStream**.
+    void parse (std::istream &manifestStream);
+
+    /// Run every member to completion.
+    void run();
+
+    const std::vector<BatchDriver::BatchRun> &getMembers();
+
+  private:
+    std::vector<BatchDriver::BatchRun> members;
+};
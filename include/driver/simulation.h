@@ -0,0 +1,24 @@
+#pragma once
+
+#include "geometry/geometry.h"
+#include "problem/problem.h"
+#include "output/output.h"
+#include "params.h"
+
+/** @brief Runs a single simulation to completion.
+ *
+ *  Constructs the GeometryStructure, ProblemStructure and OutputStructure for
+ *  the parameters in **params** and runs the main timestepping loop until the
+ *  problem's end time or end step is reached. All state is owned by the call,
+ *  so several simulations may run concurrently on different threads.
+ */
+void runSimulation (Params &params);
+
+/** @brief Runs the main timestepping loop of an initialized problem.
+ *
+ *  Advances **problem** from its current state until its end time or end step
+ *  is reached, writing each timestep through **output**, and finishes with a
+ *  final Stokes solve so that the velocity and pressure match the final
+ *  temperature.
+ */
+void runTimestepLoop (ProblemStructure &problem, OutputStructure &output);
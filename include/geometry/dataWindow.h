@@ -5,6 +5,8 @@
 
 #include <Eigen/Dense>
 
+#include "geometry/index.h"
+
 namespace e = Eigen;
 
 /** @brief A data array wrapper class
@@ -38,10 +40,10 @@ class DataWindow {
       // Ensure we haven't gone out-of-bounds on memory. There may be cases
       // where we actually want to do that, but we can remove the assertion
       // if that actually happens.
-      assert(_row * __cols + _col < __cols * __rows);
+      assert(GridIndex(_row) * __cols + _col < GridIndex(__cols) * __rows);
 
       // Column-major memory layout per Eigen.
-      return __basePtr[_row * __cols + _col];
+      return __basePtr[GridIndex(_row) * __cols + _col];
     }
 
     /** @brief Displays the data array wrapped by DataWindow */
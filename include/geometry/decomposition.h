@@ -0,0 +1,174 @@
+#pragma once
+
+#include <vector>
+
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+#include "geometry/index.h"
+#include "geometry/scalar.h"
+
+/** @brief Two-dimensional block decomposition of the cell grid over MPI.
+ *
+ *  When built with MPI_ENABLED and run on several processes, the MxN cell
+ *  grid is split into a near-square grid of blocks, one per process. Each
+ *  process stores only its own block of the temperature, surrounded by a
+ *  one-cell ring (the halo) holding the edges of the neighboring blocks,
+ *  and the velocities on the faces of its cells. The decomposed transport
+ *  kernels (upwindMethod() and forwardEuler()) update the cells of their
+ *  own block. The halo exchange is non-blocking, so kernels update the
+ *  cells away from the block edges while it is in flight:
+ *
+ *  @verbatim
+    decomposition.beginHaloExchange (temperature);
+    // ... update the cells for which onBlockEdge() is false ...
+    decomposition.endHaloExchange (temperature);
+    // ... update the cells for which onBlockEdge() is true ...
+    @endverbatim
+ *
+ *  The Stokes solve and the output work on the whole grid on the first
+ *  process: the temperature is gathered there with gather(), and the
+ *  solved velocities handed back to the blocks with scatterFaces().
+ *
+ *  Without MPI (or on one process) the single block is the whole grid, it
+ *  has no halo, and the block storage is laid out like the global arrays
+ *  (cell (i, j) at i * N + j), so that GeometryStructure can use one array
+ *  for both. All communication is then a no-op.
+ */
+class Decomposition {
+  public:
+    Decomposition();
+
+    /// Split the MxN grid over the processes of MPI_COMM_WORLD.
+    void setup (const GridIndex M, const GridIndex N);
+
+    /// Whether the grid is split over more than one process.
+    bool isDistributed();
+    /// The rank of this process.
+    int getRank();
+    /// The number of processes.
+    int getSize();
+
+    /** @name Block Extent
+     *  The rows [rowBegin, rowEnd) and columns [colBegin, colEnd) of this
+     *  process' block.
+     *  @{
+     */
+    GridIndex getRowBegin();
+    GridIndex getRowEnd();
+    GridIndex getColBegin();
+    GridIndex getColEnd();
+    /** @} */
+
+    /// Whether cell (i, j) of the block reads halo cells of another block.
+    bool onBlockEdge (const GridIndex i, const GridIndex j) {
+      return (i == rowBegin   && neighbors[lower] >= 0) ||
+             (i == rowEnd - 1 && neighbors[upper] >= 0) ||
+             (j == colBegin   && neighbors[left]  >= 0) ||
+             (j == colEnd - 1 && neighbors[right] >= 0);
+    }
+
+    /** @name Block Storage
+     *  Offsets of cell (i, j) of the block or its halo, of the u-velocity
+     *  face (i, j) to the right of cell (i, j), and of the v-velocity face
+     *  (i, j) above it, in this process' storage. A block's u faces are
+     *  those of its rows between its columns and the neighboring ones, and
+     *  likewise for the v faces.
+     *  @{
+     */
+    GridIndex cell (const GridIndex i, const GridIndex j) {
+      return (i - rowBegin + halo) * (colEnd - colBegin + 2 * halo) + (j - colBegin + halo);
+    }
+    GridIndex uFace (const GridIndex i, const GridIndex j) {
+      return (i - rowBegin) * (uEnd - uBegin) + (j - uBegin);
+    }
+    GridIndex vFace (const GridIndex i, const GridIndex j) {
+      return (i - vBegin) * (colEnd - colBegin) + (j - colBegin);
+    }
+
+    /// The number of cells of the block and its halo.
+    GridIndex getCellCount();
+    /// The number of u-velocity faces of the block.
+    GridIndex getUFaceCount();
+    /// The number of v-velocity faces of the block.
+    GridIndex getVFaceCount();
+    /** @} */
+
+    /// Start sending the block edges of the **block** storage to the neighbors.
+    void beginHaloExchange (Real * block);
+    /// Wait for the neighbors' block edges and store them in the halo.
+    void endHaloExchange (Real * block);
+
+    /** Collect every process' **block** into the MxN **field** of the first
+     *  process. **field** is only used there.
+     */
+    void gather (const Real * block, Real * field);
+    /** Hand every process its faces **blockU** and **blockV** of the global
+     *  velocities **u** and **v** of the first process, laid out as in the
+     *  GeometryStructure Stokes data.
+     */
+    void scatterFaces (const double * u, const double * v, double * blockU, double * blockV);
+
+    /// Set **value** on every process to its value on the first process.
+    void broadcast (int &value);
+
+    /// The maximum of **value** over all processes.
+    double maxAll (const double value);
+
+    /// Whether this is the first process (or the only one).
+    static bool isRootProcess();
+
+    /// Split **n** rows or columns into **blocks** near-equal ranges.
+    static void blockRange (const GridIndex n, const int blocks, const int block,
+                            GridIndex &begin, GridIndex &end);
+
+  private:
+    enum Direction { lower, upper, left, right };
+
+    /// The rows [r0, r1) and columns [c0, c1) of the block of process **r**.
+    void blockExtent (const int r, GridIndex &r0, GridIndex &r1, GridIndex &c0, GridIndex &c1);
+
+    /// Copy block edge **direction** of **block** into **buffer**, or back.
+    void packEdge (const int direction, const Real * block, Real * buffer);
+    void unpackHalo (const int direction, const Real * buffer, Real * block);
+
+    GridIndex M;
+    GridIndex N;
+
+    int rank;
+    int size;
+
+    int rowBlocks;
+    int colBlocks;
+
+    GridIndex rowBegin;
+    GridIndex rowEnd;
+    GridIndex colBegin;
+    GridIndex colEnd;
+
+    /// Width of the halo, 1 when distributed and 0 otherwise
+    GridIndex halo;
+    /// The u-velocity face columns [uBegin, uEnd) of the block
+    GridIndex uBegin;
+    GridIndex uEnd;
+    /// The v-velocity face rows [vBegin, vEnd) of the block
+    GridIndex vBegin;
+    GridIndex vEnd;
+
+    /// Rank of the neighboring block in each direction, or -1
+    int neighbors[4];
+
+    /** @name Communication Buffers
+     *  @{
+     */
+    std::vector<Real> sendBuffers[4];
+    std::vector<Real> receiveBuffers[4];
+    /// Blocks packed row by row in rank order, on the first process
+    std::vector<Real> gatherBuffer;
+  #ifdef USE_MPI
+    MPI_Request requests[8];
+    int requestCount;
+  #endif
+    /** @} */
+};
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "geometry/index.h"
+#include "geometry/scalar.h"
+#include "geometry/decomposition.h"
 #include "params.h"
 
 /** \brief A simple wrapper class for geometry-specific data
@@ -15,9 +18,11 @@ class GeometryStructure {
     ~GeometryStructure();
 
     // The number of rows in the geometry
-    int getM();
+    GridIndex getM();
     // The number of columns in the geometry
-    int getN();
+    GridIndex getN();
+    // The number of compositional fields
+    int getK();
 
     // The full Stokes data array
     double * getStokesData();
@@ -47,15 +52,36 @@ class GeometryStructure {
     // The viscosity data array
     double * getViscosityData();
 
-    // The temperature data array
-    double * getTemperatureData();
+    // This process' block of the temperature data
+    Real * getTemperatureData();
+    // The temperature back buffer, written by transport stages
+    Real * getTemperatureBackData();
+    // Make the back buffer the current temperature data
+    void swapTemperatureBuffers();
+    // The whole temperature data array, on the first process
+    Real * getGatheredTemperatureData();
+
+    // This process' block of the u-direction velocity data
+    double * getBlockUVelocityData();
+    // This process' block of the v-direction velocity data
+    double * getBlockVVelocityData();
+
+    // The interleaved compositional field data array
+    Real * getCompositionData();
+    // The compositional field back buffer
+    Real * getCompositionBackData();
+    // Make the back buffer the current compositional field data
+    void swapCompositionBuffers();
 
     // The full temperature boundary data array
-    double * getTemperatureBoundaryData();
+    Real * getTemperatureBoundaryData();
     // The u-direction temperature boundary data array
-    double * getUTemperatureBoundaryData();
+    Real * getUTemperatureBoundaryData();
     // The v-direction temperature boundary data array
-    double * getVTemperatureBoundaryData();
+    Real * getVTemperatureBoundaryData();
+
+    // The block decomposition of the cell grid over MPI processes
+    Decomposition &getDecomposition();
 
   private:
     /** @defgroup GeoSizes Domain geometry sizes
@@ -63,9 +89,11 @@ class GeometryStructure {
      *  @{
      */
     /// Number of rows in the domain
-    int M;
+    GridIndex M;
     /// Number of columns in the domain
-    int N;
+    GridIndex N;
+    /// Number of compositional fields
+    int K;
 
     /** @} */
 
@@ -84,9 +112,23 @@ class GeometryStructure {
     /// Viscosity data
     double * viscosityData;
 
-    /// Domain-interior temperature data
-    double * temperatureData;
+    /// Domain-interior temperature data, of this process' block
+    Real * temperatureData;
+    /// Domain-interior temperature back buffer, of this process' block
+    Real * temperatureBackData;
+    /// The whole temperature, gathered onto the first process of a distributed run
+    Real * gatheredTemperatureData;
+    /// Velocities on the faces of this process' block, in a distributed run
+    double * blockVelocityData;
+
+    /// Interleaved compositional field data
+    Real * compositionData;
+    /// Compositional field back buffer
+    Real * compositionBackData;
     /// Domain-boundary temperature data
-    double * temperatureBoundaryData;
+    Real * temperatureBoundaryData;
     /** @} */
+
+    /// Block decomposition of the cell grid over MPI processes
+    Decomposition decomposition;
 };
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+#include <Eigen/Sparse>
+
+/** \file index.h
+ *  \brief Index type of the grid arrays and sparse matrices
+ *
+ *  The grid dimensions, and with them every array size and offset computed
+ *  from them, and the row and column indices of the sparse matrices are
+ *  GridIndex, which is std::int64_t when built with INDEX64_ENABLED and int
+ *  otherwise. With int the Stokes system overflows past 2^31 unknowns, a
+ *  grid of about 26000 x 26000 cells; below that the 32-bit indices keep
+ *  the index arrays of the sparse matrices and their factors half the size.
+ */
+#ifdef USE_INDEX64
+typedef std::int64_t GridIndex;
+#else
+typedef int GridIndex;
+#endif
+
+/// Sparse matrix of double with GridIndex row and column indices.
+typedef Eigen::SparseMatrix<double, Eigen::ColMajor, GridIndex> SparseMatrixXd;
+/// Triplet of a SparseMatrixXd.
+typedef Eigen::Triplet<double, GridIndex> TripletXd;
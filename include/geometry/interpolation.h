@@ -0,0 +1,69 @@
+#pragma once
+
+#include <algorithm>
+
+#include "geometry/dataWindow.h"
+#include "geometry/index.h"
+
+/** \file interpolation.h
+ *  \brief Interpolation of the staggered (MAC) velocity field
+ *
+ *  Shared by the semi-Lagrangian advection scheme and the tracer subsystem.
+ *  Positions outside the domain are clamped to its boundary.
+ */
+
+// Bilinear interpolation of the u velocity, located at x = j hx for
+// j = 0 .. N and y = (i + 1/2) hy for i = 0 .. M - 1.
+inline double interpolateUVelocity (DataWindow<double> &uVelocityWindow,
+                                    DataWindow<double> &uVelocityBoundaryWindow,
+                                    const GridIndex M, const GridIndex N,
+                                    const double hx, const double hy,
+                                    const double x, const double y) {
+  double fx = std::max (0.0, std::min (double (N), x / hx));
+  double fy = std::max (0.0, std::min (double (M - 1), y / hy - 0.5));
+  GridIndex j = std::min<GridIndex> (GridIndex (fx), N - 1);
+  GridIndex i = std::min<GridIndex> (GridIndex (fy), std::max<GridIndex> (M - 2, 0));
+  double tx = fx - j;
+  double ty = (M > 1) ? fy - i : 0;
+
+  double sample[2][2];
+  for (int di = 0; di < 2; ++di)
+    for (int dj = 0; dj < 2; ++dj) {
+      GridIndex row = std::min<GridIndex> (i + di, M - 1);
+      GridIndex face = j + dj;
+      sample[di][dj] = (face == 0) ? uVelocityBoundaryWindow (0, row) :
+                       (face == N) ? uVelocityBoundaryWindow (1, row) :
+                                     uVelocityWindow (face - 1, row);
+    }
+
+  return (1 - ty) * ((1 - tx) * sample[0][0] + tx * sample[0][1]) +
+         ty       * ((1 - tx) * sample[1][0] + tx * sample[1][1]);
+}
+
+// Bilinear interpolation of the v velocity, located at x = (j + 1/2) hx for
+// j = 0 .. N - 1 and y = i hy for i = 0 .. M.
+inline double interpolateVVelocity (DataWindow<double> &vVelocityWindow,
+                                    DataWindow<double> &vVelocityBoundaryWindow,
+                                    const GridIndex M, const GridIndex N,
+                                    const double hx, const double hy,
+                                    const double x, const double y) {
+  double fx = std::max (0.0, std::min (double (N - 1), x / hx - 0.5));
+  double fy = std::max (0.0, std::min (double (M), y / hy));
+  GridIndex j = std::min<GridIndex> (GridIndex (fx), std::max<GridIndex> (N - 2, 0));
+  GridIndex i = std::min<GridIndex> (GridIndex (fy), M - 1);
+  double tx = (N > 1) ? fx - j : 0;
+  double ty = fy - i;
+
+  double sample[2][2];
+  for (int di = 0; di < 2; ++di)
+    for (int dj = 0; dj < 2; ++dj) {
+      GridIndex column = std::min<GridIndex> (j + dj, N - 1);
+      GridIndex face = i + di;
+      sample[di][dj] = (face == 0) ? vVelocityBoundaryWindow (column, 0) :
+                       (face == M) ? vVelocityBoundaryWindow (column, 1) :
+                                     vVelocityWindow (column, face - 1);
+    }
+
+  return (1 - ty) * ((1 - tx) * sample[0][0] + tx * sample[0][1]) +
+         ty       * ((1 - tx) * sample[1][0] + tx * sample[1][1]);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <Eigen/Dense>
+
+/** \file scalar.h
+ *  \brief Scalar type of the transported fields
+ *
+ *  The temperature, its boundary values, the compositional fields and the
+ *  tracer properties are stored as Real, which is float when built with
+ *  SINGLE_PRECISION_ENABLED and double otherwise. The transport kernels are
+ *  bound by memory bandwidth, so single precision storage halves their
+ *  traffic. Velocity, pressure and every linear solve stay in double, and
+ *  arithmetic on Real values promotes to double wherever it is mixed with
+ *  the double coefficients, so sums and reductions accumulate in double.
+ */
+#ifdef USE_SINGLE_PRECISION
+typedef float Real;
+#else
+typedef double Real;
+#endif
+
+/// Dynamic column vector of Real, for Eigen::Map over transported fields.
+typedef Eigen::Matrix<Real, Eigen::Dynamic, 1> VectorXr;
@@ -8,37 +8,40 @@ namespace DenseForms {
   void makeStokesMatrix (Ref<MatrixXd> stokesMatrix,
                          const int M, 
                          const int N,
-                         const double h,
+                         const double hx,
+                         const double hy,
                          const double * viscosity);
 
   void makeLaplacianXBlock (Ref<MatrixXd> laplacian,
                             const int M, 
                             const int N, 
-                            const double h, 
+                            const double hx,
+                            const double hy,
                             const double * viscosity);
   void makeLaplacianYBlock (Ref<MatrixXd> laplacian,
                             const int M,
                             const int N,
-                            const double h,
+                            const double hx,
+                            const double hy,
                             const double * viscosity);
 
   void makeGradXBlock (Ref<MatrixXd> grad,
                        const int M,
                        const int N,
-                       const double h);
+                       const double hx);
   void makeGradYBlock (Ref<MatrixXd> grad,
                        const int M,
                        const int N,
-                       const double h);
+                       const double hy);
 
   void makeDivXBlock (Ref<MatrixXd> div,
                       const int M,
                       const int N,
-                      const double h);
+                      const double hx);
   void makeDivYBlock (Ref<MatrixXd> div,
                       const int M,
                       const int N,
-                      const double h);
+                      const double hy);
 
   void makeForcingMatrix (Ref<MatrixXd> forcingMatrix,
                           const int M,
@@ -47,28 +50,29 @@ namespace DenseForms {
   void makeBoundaryMatrix (Ref<MatrixXd> boundaryMatrix,
                            const int M,
                            const int N,
-                           const double h,
+                           const double hx,
+                           const double hy,
                            const double * viscosity);
 
   void makeBCLaplacianXBlock (Ref<MatrixXd> laplacianBC,
                               const int M,
                               const int N,
-                              const double h,
+                              const double hx,
                               const double * viscosity);
 
   void makeBCLaplacianYBlock (Ref<MatrixXd> laplacianBC,
                               const int M,
                               const int N,
-                              const double h,                                 
+                              const double hy,                                 
                               const double * viscosity);
 
   void makeBCDivXBlock (Ref<MatrixXd> divBC,
                         const int M,
                         const int N,
-                        const double h);
+                        const double hx);
 
   void makeBCDivYBlock (Ref<MatrixXd> divBC,
                         const int M,
                         const int N,
-                        const double h);
+                        const double hy);
 }
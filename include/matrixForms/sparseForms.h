@@ -1,107 +1,144 @@
 #pragma once
 
+#include <limits>
 #include <vector>
 
 #include <Eigen/Sparse>
 
+#include "geometry/index.h"
+
 using namespace Eigen;
 using namespace std;
 
+/** Assembly of the staggered Stokes system. The cells of the M x N grid
+ *  are dx[j] wide and dy[i] high, with dx of length N and dy of length M,
+ *  so that the grid may be stretched (see ProblemStructure).
+ */
 namespace SparseForms {
-  void makeStokesMatrix (SparseMatrix<double>& stokesMatrix,
-                         const int M,
-                         const int N,
-                         const double h,
-                         const double * viscosity);
-
-  void makeLaplacianXBlock (vector<Triplet<double> >& tripletList,
-                            const int M0,
-                            const int N0,
-                            const int M,
-                            const int N,
-                            const double h,
-                            const double * viscosity);
-
-  void makeLaplacianYBlock (vector<Triplet<double> >& tripletList,
-                            const int M0,
-                            const int N0,
-                            const int M,
-                            const int N,
-                            const double h,
-                            const double * viscosity);
-
-  void makeGradXBlock (vector<Triplet<double> >& tripletList,
-                       const int M0,
-                       const int N0,
-                       const int M,
-                       const int N,
-                       const double h);
-
-  void makeGradYBlock (vector<Triplet<double> >& tripletList,
-                       const int M0,
-                       const int N0,
-                       const int M,
-                       const int N,
-                       const double h);
-
-  void makeDivXBlock (vector<Triplet<double> >& tripletList,
-                      const int M0,
-                      const int N0,
-                      const int M,
-                      const int N,
-                      const double h);
-
-  void makeDivYBlock (vector<Triplet<double> >& tripletList,
-                      const int M0,
-                      const int N0,
-                      const int M,
-                      const int N,
-                      const double h);
-
-  void makeForcingMatrix (SparseMatrix<double>& forcingMatrix,
-                          const int M,
-                          const int N);
-
-  void makeBoundaryMatrix (SparseMatrix<double>& boundaryMatrix,
-                           const int N,
-                           const int M,
-                           const double h,
+  /** The rows [begin, end) of a matrix, by default all of them. The Stokes
+   *  blocks only push the triplets of these rows, so that each process of
+   *  a distributed solve assembles just the rows it owns.
+   */
+  struct RowRange {
+    RowRange() : begin (0), end (std::numeric_limits<GridIndex>::max()) {}
+    RowRange (const GridIndex begin, const GridIndex end) : begin (begin), end (end) {}
+
+    bool contains (const GridIndex row) const { return row >= begin && row < end; }
+
+    GridIndex begin;
+    GridIndex end;
+  };
+
+  /** Assemble the rows **rows** of the Stokes matrix into **stokesMatrix**,
+   *  whose row r holds row rows.begin + r. Size it to the number of rows
+   *  first.
+   */
+  void makeStokesMatrix (SparseMatrixXd& stokesMatrix,
+                         const GridIndex M,
+                         const GridIndex N,
+                         const double * dx,
+                         const double * dy,
+                         const double * viscosity,
+                         const RowRange &rows = RowRange());
+
+  void makeLaplacianXBlock (vector<TripletXd>& tripletList,
+                            const GridIndex M0,
+                            const GridIndex N0,
+                            const GridIndex M,
+                            const GridIndex N,
+                            const double * dx,
+                            const double * dy,
+                            const double * viscosity,
+                            const RowRange &rows = RowRange());
+
+  void makeLaplacianYBlock (vector<TripletXd>& tripletList,
+                            const GridIndex M0,
+                            const GridIndex N0,
+                            const GridIndex M,
+                            const GridIndex N,
+                            const double * dx,
+                            const double * dy,
+                            const double * viscosity,
+                            const RowRange &rows = RowRange());
+
+  void makeGradXBlock (vector<TripletXd>& tripletList,
+                       const GridIndex M0,
+                       const GridIndex N0,
+                       const GridIndex M,
+                       const GridIndex N,
+                       const double * dx,
+                       const RowRange &rows = RowRange());
+
+  void makeGradYBlock (vector<TripletXd>& tripletList,
+                       const GridIndex M0,
+                       const GridIndex N0,
+                       const GridIndex M,
+                       const GridIndex N,
+                       const double * dy,
+                       const RowRange &rows = RowRange());
+
+  void makeDivXBlock (vector<TripletXd>& tripletList,
+                      const GridIndex M0,
+                      const GridIndex N0,
+                      const GridIndex M,
+                      const GridIndex N,
+                      const double * dx,
+                      const RowRange &rows = RowRange());
+
+  void makeDivYBlock (vector<TripletXd>& tripletList,
+                      const GridIndex M0,
+                      const GridIndex N0,
+                      const GridIndex M,
+                      const GridIndex N,
+                      const double * dy,
+                      const RowRange &rows = RowRange());
+
+  void makeForcingMatrix (SparseMatrixXd& forcingMatrix,
+                          const GridIndex M,
+                          const GridIndex N);
+
+  void makeBoundaryMatrix (SparseMatrixXd& boundaryMatrix,
+                           const GridIndex N,
+                           const GridIndex M,
+                           const double * dx,
+                           const double * dy,
                            const double * viscosity);
 
-  void makeBCLaplacianXBlock (vector<Triplet<double> >& tripletList,
-                              const int M0,
-                              const int N0,
-                              const int M,
-                              const int N,
-                              const double h,
+  void makeBCLaplacianXBlock (vector<TripletXd>& tripletList,
+                              const GridIndex M0,
+                              const GridIndex N0,
+                              const GridIndex M,
+                              const GridIndex N,
+                              const double * dx,
                               const double * viscosity);
 
-  void makeBCLaplacianYBlock (vector<Triplet<double> >& tripletList,
-                              const int M0,
-                              const int N0,
-                              const int M,
-                              const int N,
-                              const double h,
+  void makeBCLaplacianYBlock (vector<TripletXd>& tripletList,
+                              const GridIndex M0,
+                              const GridIndex N0,
+                              const GridIndex M,
+                              const GridIndex N,
+                              const double * dy,
                               const double * viscosity);
 
-  void makeBCDivXBlock (vector<Triplet<double> >& tripletList,
-                        const int M0,
-                        const int N0,
-                        const int M,
-                        const int N,
-                        const double h);
-
-  void makeBCDivYBlock (vector<Triplet<double> >& tripletList,
-                        const int M0,
-                        const int N0,
-                        const int M,
-                        const int N,
-                        const double h);
-
-  void makeForwardEulerMatrix (SparseMatrix<double> matrix,
-                               const int M,
-                               const int N,
+  void makeBCDivXBlock (vector<TripletXd>& tripletList,
+                        const GridIndex M0,
+                        const GridIndex N0,
+                        const GridIndex M,
+                        const GridIndex N,
+                        const double * dx);
+
+  void makeBCDivYBlock (vector<TripletXd>& tripletList,
+                        const GridIndex M0,
+                        const GridIndex N0,
+                        const GridIndex M,
+                        const GridIndex N,
+                        const double * dy);
+
+  void makeForwardEulerMatrix (SparseMatrixXd matrix,
+                               const GridIndex M,
+                               const GridIndex N,
                                const double dt,
                                const double diffusivity,
-                               const double h);
+                               const double hx,
+                               const double hy);
 }
@@ -25,14 +25,26 @@ class OutputStructure {
     GeometryStructure &geometry;
     ProblemStructure  &problem;
 
-    int M;
-    int N;
+    GridIndex M;
+    GridIndex N;
 
+    /// Cell width and height
     double dx;
+    double dy;
+    /// Vertex coordinates of a stretched grid, formatted for the XDMF file
+    string xVertexList;
+    string yVertexList;
 
     string outputFormat;
     string outputPath;
     string outputFilename;
 
     std::ofstream problemXdmfFile;
+
+    // Cell-centered work arrays for the interpolated velocity output
+    double * interpolatedUVelocityData;
+    double * interpolatedVVelocityData;
+    double * velocityDivergenceData;
+    // Contiguous copy of one interleaved compositional field
+    Real * compositionOutputData;
 };
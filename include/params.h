@@ -81,6 +81,18 @@ public:
     }
   }
 
+  /**
+   * Stores `value` under `key` in the current parameter section, replacing
+   * any existing value. Used to override individual parameters of a parsed
+   * parameter file (e.g. for parameter sweeps).
+   */
+  template <typename T>
+  void setParam(
+          std::string key,
+          const T &value) {
+    treeBase->setParam(key, boost::lexical_cast<std::string>(value));
+  }
+
 protected:
   ParamTree *treeBase;
 };
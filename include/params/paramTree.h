@@ -31,6 +31,7 @@ class ParamTree {
     void delNode(std::string key);
 
     void addParam(std::string key, std::string value);
+    void setParam(std::string key, std::string value);
     void delParam(std::string key);
 
     ParamNode *rootNode;
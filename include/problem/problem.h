@@ -2,7 +2,20 @@
 
 #include <limits>
 #include <cmath>
+#include <memory>
+#include <vector>
 
+#include <Eigen/Sparse>
+#include <Eigen/Dense>
+
+#include "geometry/index.h"
+#include "solvers/spectralDiffusionSolver.h"
+#include "solvers/adiDiffusionSolver.h"
+#include "solvers/multirateUpwind.h"
+#include "solvers/rklDiffusionSolver.h"
+#include "solvers/stokesSolver.h"
+#include "refinement/patchHierarchy.h"
+#include "tracers/tracers.h"
 #include "params.h"
 
 using namespace std;
@@ -33,6 +46,18 @@ class ProblemStructure {
     void initializeTimestep();
     void initializeViscosity();
     void initializeTemperature();
+    /** Initialize the compositional fields, if any, according to the
+     *  problemParams compositionModel.
+     */
+    void initializeComposition();
+    /** Seed the tracers used by particleInCell() advection with the initial
+     *  temperature and compositional fields.
+     */
+    void initializeTracers();
+    /** Build the patch hierarchy used for advection when refinementParams
+     *  asks for more than one level.
+     */
+    void initializeRefinement();
     void initializeTemperatureBoundary();
     void initializeVelocityBoundary();
 
@@ -40,15 +65,59 @@ class ProblemStructure {
     void updateForcingTerms();
     void updateViscosity();
     void solveStokes();
+    /** Solve the Stokes equations of several problems sharing one Stokes
+     *  system (see shareStokesSystem()) with a single multiple right-hand
+     *  side solve.
+     */
+    static void solveStokes (const std::vector<ProblemStructure *> &problems);
+    /** Use the Stokes system and factorization of **source** from now on.
+     *  Both problems must have the same, constant, viscosity field and the
+     *  same Stokes solver settings.
+     */
+    void shareStokesSystem (ProblemStructure &source);
+    /** Whether the velocity field is due to be recomputed. When subcycling,
+     *  the velocity from the previous solveStokes() call is reused for
+     *  several advection/diffusion steps.
+     */
+    bool stokesSolveRequired();
+    /// Transport steps between Stokes solves, as last chosen when subcycling.
+    int getStokesSubsteps();
     void recalculateTimestep();
     void solveAdvectionDiffusion();
     bool advanceTimestep();
+    /** Gather the whole temperature field onto the first process (see
+     *  GeometryStructure::getGatheredTemperatureData()), for the buoyancy
+     *  forcing and the output. Collective over the processes of a
+     *  distributed run, and a no-op otherwise.
+     */
+    void gatherTemperature();
 
     // Advection methods
     void upwindMethod();
     void laxWendroff();
     void frommMethod();
     void frommVanLeer();
+    void semiLagrangian();
+    /** Advect all compositional fields with first order upwinding, reusing
+     *  each cell's face velocities and upwind directions for every field.
+     */
+    void upwindComposition();
+    /** Advect all compositional fields with flux-limited second order
+     *  fluxes through the given face velocities (see frommMethod).
+     */
+    void frommComposition (const double * uVelocity, const double * vVelocity);
+    /** Advect the temperature and compositional fields with upwind fluxes,
+     *  each cell taking local time steps of its own (see MultirateUpwind).
+     */
+    void multirateUpwind();
+    /** Advect the temperature and compositional fields on Lagrangian tracers
+     *  and project them back onto the grid.
+     */
+    void particleInCell();
+    /** Advect the temperature with upwindMethod or frommMethod fluxes on the
+     *  adaptively refined patch hierarchy, and project it back onto the grid.
+     */
+    void refinedAdvection();
 
     // Flux Limiters
     double minmod (double ub, double u, double uf) {
@@ -96,6 +165,8 @@ class ProblemStructure {
     void forwardEuler();
     void backwardEuler();
     void crankNicolson();
+    void alternatingDirectionImplicit();
+    void rungeKuttaLegendre();
 
     void outputPressure();
     void outputVelocity();
@@ -105,28 +176,91 @@ class ProblemStructure {
     void outputTemperature();
     void outputBoundaryTemperature();
 
-    double getH();
+    double getHx();
+    double getHy();
+    /// Whether the cells vary in size (see the Grid Spacing members).
+    bool isStretched();
+    /// Widths of the N columns of cells.
+    const std::vector<double> &getCellWidths();
+    /// Heights of the M rows of cells.
+    const std::vector<double> &getCellHeights();
+    /// x coordinates of the N + 1 vertical cell faces.
+    const std::vector<double> &getXFaces();
+    /// y coordinates of the M + 1 horizontal cell faces.
+    const std::vector<double> &getYFaces();
+    /// x coordinates of the N cell centers.
+    const std::vector<double> &getXCenters();
+    /// y coordinates of the M cell centers.
+    const std::vector<double> &getYCenters();
     double getTime();
     double getEndTime();
+    /// The current time step.
+    double getDeltaT();
     int getTimestepNumber();
+    /// Steps rejected and retried by the PI timestep controller so far.
+    int getRejectedSteps();
 
   private:
+    /** Place the cell faces, uniformly or stretched towards the walls
+     *  according to the 'xStretching' and 'yStretching' parameters.
+     */
+    void initializeGridSpacing (const double xStretching, const double yStretching);
+    void factorStokesSystem();
+    /// Right-hand side of the Stokes system for the current forcing terms.
+    Eigen::VectorXd stokesRightHandSide();
+    /** Initial guess for the iterative Stokes backends at **solveTime**:
+     *  empty (zero) if there is no previous solve to start from.
+     */
+    Eigen::VectorXd stokesInitialGuess (const double solveTime);
+    /// Post-process the Stokes solution written to the geometry.
+    void finishStokesSolve();
+    /// Advance the temperature and compositional fields by one step.
+    void solveTransportStep();
+    void solveAdvection();
+    void solveDiffusion();
+    /** The largest change of this process' block of the temperature from
+     *  **startTemperature**, relative to the largest temperature.
+     */
+    double relativeTemperatureChange (const VectorXr &startTemperature);
+
+    // Diffusion helpers
+    void diffusionNumbers (const double scale,
+                           std::vector<double> &left, std::vector<double> &right,
+                           std::vector<double> &bottom, std::vector<double> &top);
+    void scaleByCellAreas (SparseMatrixXd &lhs, Eigen::VectorXd &rhs);
+
+    // Spectral diffusion helpers
+    bool spectralDiffusionApplicable();
+    void addDiffusionBoundaryTerms (const double mu, Real * data);
+    void solveSpectralDiffusion (const double muX, const double muY, Real * data);
+
     Params            &params;
     GeometryStructure &geometry;
 
     string forcingModel;
     string temperatureModel;
+    string compositionModel;
     string viscosityModel;
     string boundaryModel;
     string advectionMethod;
     string fluxLimiter;
+    string semiLagrangianInterpolation;
+    string tracerIntegrator;
     string diffusionMethod;
+    string diffusionSolver;
+    string splittingMethod;
+    string subcyclingMode;
+    string timestepController;
     string outputFile;
 
-    int M;
-    int N;
+    GridIndex M;
+    GridIndex N;
 
     double cfl;
+    double semiLagrangianCourant;
+
+    int tracersPerSide;
+    int tracerSortInterval;
 
     double time;
     double endTime;
@@ -134,10 +268,140 @@ class ProblemStructure {
     int timestepNumber;
     int endStep;
 
+    /** @name Timestep Controller State
+     *  Gains and limits of the PI timestep controller, the error estimates of
+     *  the last two accepted steps (negative before the first) and the number
+     *  of steps rejected and retried so far.
+     *  @{
+     */
+    double controllerTolerance;
+    double controllerSafety;
+    double controllerIntegralGain;
+    double controllerProportionalGain;
+    double controllerMaxGrowth;
+    double controllerMinShrink;
+    double controllerRejectionRatio;
+    double stepError;
+    double previousError;
+    int rejectedSteps;
+    /** @} */
+
+    /** @name Stokes Subcycling State
+     *  Number of transport steps taken per Stokes solve, and the velocity of
+     *  the previous solve used to choose it adaptively.
+     *  @{
+     */
+    int stokesSubsteps;
+    int maxStokesSubsteps;
+    int stepsSinceStokes;
+    double velocityTolerance;
+    Eigen::VectorXd previousVelocity;
+    /** @} */
+
+    /** @name Stokes Initial Guess State
+     *  How the iterative Stokes backends are started ("zero", "previous" or
+     *  "extrapolated"), and the last two solutions and their times.
+     *  @{
+     */
+    string stokesInitialGuessMode;
+    bool stokesSolved;
+    double lastStokesTime;
+    double olderStokesTime;
+    Eigen::VectorXd lastStokesSolution;
+    Eigen::VectorXd olderStokesSolution;
+    /** @} */
+
+    /// Whether the gathered temperature is older than the processes' blocks
+    bool temperatureDistributed;
+
     double xExtent;
     double yExtent;
-    double h;
+    /// Width and height of the cells, or their means on a stretched grid
+    double hx;
+    double hy;
+
+    /** @name Grid Spacing
+     *  Widths of the N columns and heights of the M rows of cells, and the
+     *  coordinates of the cell faces and centers. On a uniform grid these
+     *  are hx, hy and their multiples.
+     *  @{
+     */
+    bool stretchedGrid;
+    std::vector<double> cellWidths;
+    std::vector<double> cellHeights;
+    std::vector<double> xFaces;
+    std::vector<double> yFaces;
+    std::vector<double> xCenters;
+    std::vector<double> yCenters;
+    /** @} */
 
     double viscosity;
     double diffusivity;
+
+    /** @name Stokes Solver State
+     *  The Stokes system and its factorization are kept per-instance rather
+     *  than in function-local statics so that several problems may be solved
+     *  side-by-side in one process (see BatchDriver). Members of an ensemble
+     *  share one instance (see shareStokesSystem()). Only the first process
+     *  of a distributed run builds the forcing and boundary matrices, and
+     *  with the petsc backend each process keeps only its own rows of the
+     *  Stokes matrix (see StokesSolver::ownedRows()).
+     *  @{
+     */
+    struct StokesSystem {
+      StokesSystem() : initialized (false) {}
+
+      bool initialized;
+    #ifndef USE_DENSE
+      SparseMatrixXd stokesMatrix;
+      SparseMatrixXd forcingMatrix;
+      SparseMatrixXd boundaryMatrix;
+      StokesSolver solver;
+    #else
+      Eigen::MatrixXd stokesMatrix;
+      Eigen::MatrixXd forcingMatrix;
+      Eigen::MatrixXd boundaryMatrix;
+      Eigen::PartialPivLU<Eigen::MatrixXd> solver;
+    #endif
+    };
+    std::shared_ptr<StokesSystem> stokes;
+    /** @} */
+
+    /// Direct solver for implicit diffusion steps on separable problems
+    SpectralDiffusionSolver spectralSolver;
+    /// Line solver state for alternatingDirectionImplicit()
+    ADIDiffusionSolver adiSolver;
+    /// Stage buffers for rungeKuttaLegendre()
+    RKLDiffusionSolver rklSolver;
+    /// Lagrangian tracers for particleInCell()
+    TracerStructure tracers;
+    /// Time step levels of multirateUpwind() (1 for a single global step)
+    int multirateLevels;
+    /// Face lists and levels for multirateUpwind()
+    MultirateUpwind multirateSolver;
+
+    /** @name Refinement State
+     *  Levels of the patch hierarchy used by refinedAdvection() (1 for none),
+     *  its patch size, the steps between regrids and the temperature jump
+     *  that marks a cell for refinement.
+     *  @{
+     */
+    int refinementLevels;
+    int refinementPatchSize;
+    int regridInterval;
+    double refinementThreshold;
+    PatchHierarchy hierarchy;
+    /** @} */
+
+    /** @name Fromm Method Work Arrays
+     *  Half-time data used by frommMethod(), allocated on first use.
+     *  @{
+     */
+    Eigen::VectorXd halfTimeTemperature;
+    Eigen::VectorXd halfTimeUOffsetTemperature;
+    Eigen::VectorXd halfTimeVOffsetTemperature;
+    Eigen::VectorXd halfTimeForcing;
+    Eigen::VectorXd halfTimeStokesSoln;
+    Eigen::VectorXd cellCenteredVelocity;
+    /** @} */
 };
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "geometry/index.h"
+#include "geometry/scalar.h"
+
+/** \brief Block-structured adaptive mesh refinement of the temperature transport
+ *
+ *  The PatchHierarchy class advects the temperature on a hierarchy of levels,
+ *  each refined by a factor of two over the one below (Berger and Colella,
+ *  1989). Level 0 is the MxN grid. Every finer level is tiled into
+ *  patchSize x patchSize blocks, and holds a patch on each block where the
+ *  temperature of the level below jumps by more than a threshold between
+ *  neighboring cells, within a buffer of the distance features travel before
+ *  the next regrid. Patches are nested at least two cells inside the level
+ *  below.
+ *
+ *  Each level takes two half-length steps per step of the level below. Its
+ *  ghost cells are copied from neighboring patches, or interpolated from the
+ *  level below (linearly with minmod slopes in space, linearly in time). The
+ *  face fluxes are first order upwind, or Fromm's second order scheme with an
+ *  optional slope limiter. After a level's steps, the fluxes it put through
+ *  the coarse-fine interface replace the coarse fluxes there (refluxing), and
+ *  its cell averages replace the cells beneath, so the total heat is
+ *  conserved. Level l + 1 is rebuilt every regridInterval steps of level l.
+ *
+ *  The face velocities of every level are interpolated from the staggered
+ *  velocity of level 0, linearly across the cells and constant along the
+ *  faces, so that a fine cell sees the divergence of its level 0 cell.
+ *  Faces on the domain walls carry no flux, as in upwindMethod(). Patches are
+ *  advanced in parallel with OpenMP when built with OPENMP_ENABLED.
+ */
+class PatchHierarchy {
+  public:
+    PatchHierarchy();
+
+    /** Set up **levels** levels (1 for the grid alone) over the MxN grid of
+     *  **hx** x **hy** cells, start level 0 from **temperature** and build the
+     *  finer levels. **scheme** is "upwind" or "fromm", and **limiter** is the
+     *  slope limiter of "fromm": "minmod", "superbee", "vanLeer" or "none".
+     */
+    void setup (const GridIndex M, const GridIndex N,
+                const double hx,
+                const double hy,
+                const int levels,
+                const int patchSize,
+                const int regridInterval,
+                const double threshold,
+                const std::string &scheme,
+                const std::string &limiter,
+                const Real * temperature);
+
+    /** Add the change the grid temperature has seen since the last call to
+     *  project() (e.g. from diffusion) to every level, constant over each
+     *  level 0 cell.
+     */
+    void applyGridChange (const Real * temperature);
+
+    /** Advance every level over **deltaT** through the staggered velocity
+     *  field, regridding as due.
+     */
+    void advance (const double deltaT,
+                  const double * uVelocity,
+                  const double * vVelocity,
+                  const double * uVelocityBoundary,
+                  const double * vVelocityBoundary);
+
+    /// Write level 0, which holds the averages of the finer levels, into **temperature**.
+    void project (Real * temperature);
+
+    /// The number of levels, including level 0.
+    int getLevelCount();
+    /// The number of patches on **level**.
+    GridIndex getPatchCount (const int level);
+    /// The number of cell updates taken by the last advance(), over all levels.
+    GridIndex getCellUpdates();
+    /// Whether cell (i, j) of **level** lies on one of its patches.
+    bool covers (const int level, const GridIndex i, const GridIndex j);
+    /// The temperature of cell (i, j) of **level**, which must cover it.
+    double getValue (const int level, const GridIndex i, const GridIndex j);
+
+  private:
+    enum Limiter { noLimiter, minmodLimiter, superbeeLimiter, vanLeerLimiter };
+
+    /** A patch of one level: a block of rows x cols cells starting at cell
+     *  (row, col) of its level, stored with two layers of ghost cells.
+     */
+    struct Patch {
+      GridIndex row;
+      GridIndex col;
+      GridIndex rows;
+      GridIndex cols;
+
+      /// The temperature, and the temperature at the start of the current step
+      std::vector<double> data;
+      std::vector<double> oldData;
+
+      /// Integrated fluxes through the rows x (cols + 1) vertical and (rows + 1) x cols horizontal faces
+      std::vector<double> xFlux;
+      std::vector<double> yFlux;
+
+      /** Fluxes through the left, right, bottom and top sides summed over
+       *  the steps of the current coarse step, per coarse face.
+       */
+      std::vector<double> fluxRegister[4];
+    };
+
+    struct Level {
+      GridIndex M;
+      GridIndex N;
+      double hx;
+      double hy;
+
+      /// Patch on each patchSize x patchSize tile, or -1
+      GridIndex tileRows;
+      GridIndex tileCols;
+      std::vector<int> tiles;
+      std::vector<Patch> patches;
+
+      /// Steps taken since the next level was built
+      int steps;
+      /// Current time, and the start and length of the current step
+      double time;
+      double stepStart;
+      double deltaT;
+    };
+
+    /// Index of the patch of **level** containing cell (i, j), or -1.
+    int patchAt (const int level, const GridIndex i, const GridIndex j);
+    /// Offset of cell (i, j) of the level in the data of **patch**.
+    GridIndex cellIndex (const Patch &patch, const GridIndex i, const GridIndex j);
+
+    /** Temperature of cell (i, j) of **level**, at the fraction **alpha** of
+     *  its current step.
+     */
+    double coarseValue (const int level, const GridIndex i, const GridIndex j, const double alpha);
+    /// Temperature of cell (i, j) of **level** interpolated from the level below.
+    double interpolate (const int level, const GridIndex i, const GridIndex j, const double alpha);
+
+    /// Normal velocity at vertical face j of row i of **level**.
+    double uFace (const int level, const GridIndex i, const GridIndex j);
+    /// Normal velocity at horizontal face i of column j of **level**.
+    double vFace (const int level, const GridIndex i, const GridIndex j);
+    /// Value of the upwind cell **upwind** reconstructed at a face, given its neighbors.
+    double faceValue (const double behind, const double upwind, const double ahead, const double courant);
+
+    /// Rebuild **level** and every finer level from the level below.
+    void regrid (const int level);
+    void fillGhosts (const int level);
+    void stepPatch (const int level, Patch &patch, const double deltaT);
+    void advanceLevel (const int level, const double deltaT);
+    /// Correct the coarse cells along the coarse-fine interface of **level**.
+    void reflux (const int level);
+    /// Replace the cells beneath the patches of **level** by their averages.
+    void averageDown (const int level);
+
+    GridIndex M;
+    GridIndex N;
+    int patchSize;
+    int regridInterval;
+    double threshold;
+    bool secondOrder;
+    Limiter limiter;
+
+    std::vector<Level> levels;
+    GridIndex cellUpdates;
+
+    /// Level 0 velocity of the current advance()
+    const double * uVelocity;
+    const double * vVelocity;
+    const double * uVelocityBoundary;
+    const double * vVelocityBoundary;
+};
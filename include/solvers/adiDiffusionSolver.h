@@ -0,0 +1,78 @@
+#pragma once
+
+#include <Eigen/Dense>
+
+#include "geometry/index.h"
+
+/** @brief Alternating-direction implicit (Peaceman-Rachford) diffusion.
+ *
+ *  Advances \f$ T_t = \kappa \nabla^2 T \f$ on the MxN cell-centered grid by
+ *  two half steps, each implicit in one direction and explicit in the other,
+ *  with insulated (Neumann) left and right boundaries and prescribed
+ *  (Dirichlet) lower and upper boundary temperatures. Each half step is a set
+ *  of independent tridiagonal systems sharing one matrix, so the Thomas
+ *  factors are computed once per \f$ (\mu_x, \mu_y) \f$ and the systems are
+ *  swept together, with the line index innermost so the sweeps vectorize.
+ *  Lines are split into blocks across OpenMP threads when built with
+ *  OPENMP_ENABLED.
+ */
+class ADIDiffusionSolver {
+  public:
+    ADIDiffusionSolver();
+
+    /// Prepare the work buffer for an MxN grid.
+    void setup (const GridIndex M, const GridIndex N);
+
+    /// The number of rows the solver was set up for (0 before setup()).
+    GridIndex getM();
+    /// The number of columns the solver was set up for (0 before setup()).
+    GridIndex getN();
+
+    /** Advance **temperature** in place by one step with
+     *  \f$ \mu_x = \kappa \Delta{t} / 2 h_x^2 \f$ and
+     *  \f$ \mu_y = \kappa \Delta{t} / 2 h_y^2 \f$, using the (N, 2) window
+     *  of lower and upper boundary temperatures **boundary**.
+     */
+    void step (const double muX, const double muY, double * temperature, const double * boundary);
+    /// Single precision step, carried out in double on internal copies.
+    void step (const double muX, const double muY, float * temperature, const float * boundary);
+
+    /** @name Batched Thomas algorithm
+     *  Factor the constant tridiagonal matrix with off-diagonals \f$ -\mu \f$
+     *  and diagonal **diagonal**, and solve **lines** systems of length
+     *  **n** stored interleaved as data[k * lines + line].
+     *  @{
+     */
+    static void factor (const double mu,
+                        const Eigen::VectorXd &diagonal,
+                        Eigen::VectorXd &inverseDiagonal,
+                        Eigen::VectorXd &upper);
+    static void solveLines (const double mu,
+                            const Eigen::VectorXd &inverseDiagonal,
+                            const Eigen::VectorXd &upper,
+                            double * data,
+                            const int n,
+                            const int lines);
+    /** @} */
+
+  private:
+    GridIndex M;
+    GridIndex N;
+
+    /// Values of mu the factors below were computed for
+    double factoredMuX;
+    double factoredMuY;
+
+    /// Thomas factors of the x (length N) and y (length M) systems
+    Eigen::VectorXd xInverseDiagonal;
+    Eigen::VectorXd xUpper;
+    Eigen::VectorXd yInverseDiagonal;
+    Eigen::VectorXd yUpper;
+
+    /// Intermediate temperature, stored transposed (NxM)
+    Eigen::VectorXd transposedTemperature;
+
+    /// Double precision copies of single precision temperature and boundary
+    Eigen::VectorXd workTemperature;
+    Eigen::VectorXd workBoundary;
+};
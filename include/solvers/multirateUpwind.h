@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+
+#include "geometry/index.h"
+#include "geometry/scalar.h"
+
+/** @brief Upwind advection with local (multirate) time steps.
+ *
+ *  Advances the cell-centered temperature and K interleaved compositional
+ *  fields of the MxN grid through the staggered velocity field, with each
+ *  cell taking only the steps its own velocity requires. For a step
+ *  \f$ \Delta{t} \f$, cell c is put on the lowest level k < levels for which
+ *  \f[ \frac {\Delta{t}} {2^k} \left( \frac {|u|} {h_x} + \frac {|v|} {h_y} \right)_c \le \sigma \f]
+ *  where \f$ \sigma \f$ is the CFL number, and takes 2^k steps of
+ *  \f$ \Delta{t} / 2^k \f$. Each face is on the finer level of its two
+ *  cells. Faces are swept once per step of their level, and the upwind flux
+ *  through each is taken from one cell and given to the other, while each
+ *  cell applies what it gains and loses only at the end of its own step. The
+ *  update is then conservative and positive across level boundaries and
+ *  keeps a constant field constant (Osher and Sanders, 1983). Faces on the
+ *  walls carry no flux, as in upwindMethod().
+ *
+ *  With levels = 1 this is upwindMethod(). With more levels, a step up to
+ *  2^(levels - 1) times the global CFL limit costs about one update per cell
+ *  in slow regions rather than 2^(levels - 1).
+ */
+class MultirateUpwind {
+  public:
+    MultirateUpwind();
+
+    /** Prepare for an MxN grid of cells **dx**[j] wide and **dy**[i] high,
+     *  with up to **levels** time step levels.
+     */
+    void setup (const GridIndex M, const GridIndex N,
+                const double * dx,
+                const double * dy,
+                const int levels);
+
+    /// The number of rows the solver was set up for (0 before setup()).
+    GridIndex getM();
+    /// The number of columns the solver was set up for (0 before setup()).
+    GridIndex getN();
+
+    /** Advance **temperature** and the K interleaved fields of
+     *  **composition** over **deltaT** through the interior face velocities
+     *  **uVelocity** and **vVelocity**. **deltaT** must not exceed
+     *  2^(levels - 1) times the step allowed by **cfl** in the fastest cell,
+     *  whose level is otherwise capped at levels - 1.
+     */
+    void step (const double deltaT,
+               const double cfl,
+               const double * uVelocity,
+               const double * vVelocity,
+               Real * temperature,
+               Real * composition,
+               const int K);
+
+    /** Cell updates taken by the last step(): 2^k for each cell on level k,
+     *  against M N 2^(levels - 1) with a single level at the finest step.
+     */
+    GridIndex getCellUpdates();
+    /// The level of each cell in the last step().
+    const int * getLevelData();
+
+  private:
+    /// Assign the cells and faces to levels for a step of **deltaT**.
+    void assignLevels (const double deltaT,
+                       const double cfl,
+                       const double * uVelocity,
+                       const double * vVelocity);
+
+    /// Advance the values of **field**, strided by **stride**, over the step.
+    void advanceField (const double deltaT, Real * field, const int stride);
+
+    GridIndex M;
+    GridIndex N;
+    int levels;
+    GridIndex cellUpdates;
+
+    std::vector<double> dx;
+    std::vector<double> dy;
+    std::vector<double> cellAreas;
+    std::vector<int> cellLevels;
+    /// The cells on each level
+    std::vector<std::vector<GridIndex> > levelCells;
+    /// Changes to each cell gathered over its current step
+    std::vector<double> changes;
+
+    /** @name Face Lists
+     *  The faces of each level, oriented with the flow: the upwind and
+     *  downwind cell and the volume flux \f$ |u| h \f$ through the face.
+     *  @{
+     */
+    std::vector<std::vector<GridIndex> > sources;
+    std::vector<std::vector<GridIndex> > targets;
+    std::vector<std::vector<double> > rates;
+    /** @} */
+
+    /// Amounts moved through the faces of each level swept in the current substep
+    std::vector<std::vector<double> > amounts;
+};
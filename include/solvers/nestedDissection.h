@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+
+#include <Eigen/Sparse>
+
+#include "geometry/index.h"
+
+/** @brief Geometric nested dissection ordering of the staggered Stokes system.
+ *
+ *  Orders the unknowns of the M x N Stokes system of SparseForms from their
+ *  positions on the staggered grid, without building or partitioning the
+ *  graph of the matrix. The grid is split across its longer side by a
+ *  separator two cells wide, starting at a line of velocity faces, wide
+ *  enough that neither the matrix A nor A^T A (whose pattern SparseLU
+ *  factors symbolically) couples the two halves. The halves are ordered
+ *  recursively before the separator, which bounds the fill of an M x N
+ *  grid by O(MN log MN).
+ *
+ *  Used like the symmetric orderings of Eigen, e.g. by StokesSolver.
+ */
+class NestedDissectionOrdering {
+  public:
+    typedef Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, GridIndex> Permutation;
+
+    NestedDissectionOrdering (const GridIndex M, const GridIndex N);
+
+    /** Compute the ordering of **matrix**, which must be the M x N Stokes
+     *  matrix. As with AMDOrdering, **ordering** maps each position to the
+     *  unknown eliminated there.
+     */
+    void operator() (const SparseMatrixXd &matrix, Permutation &ordering);
+
+  private:
+    /// Append the unknowns of **unknowns** to **order**, dissecting them recursively.
+    void dissect (std::vector<GridIndex> &unknowns, std::vector<GridIndex> &order);
+
+    GridIndex M;
+    GridIndex N;
+
+    /** Positions of the unknowns on a grid of half cells: cell (i, j) is
+     *  centered on (2j + 1, 2i + 1).
+     *  @{
+     */
+    std::vector<int> x;
+    std::vector<int> y;
+    /** @} */
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+
+#include <boost/cstdint.hpp>
+#include <Eigen/Sparse>
+
+#include "geometry/index.h"
+
+/** @brief On-disk cache of fill-reducing orderings.
+ *
+ *  Runs of a parameter sweep often rebuild the same Stokes matrix. The
+ *  column ordering computed for its factorization depends only on the
+ *  matrix' sparsity pattern, so it is stored in **directory** under a hash
+ *  of the pattern (its dimensions and nonzero positions, and hence M and N)
+ *  and of the ordering method. Cache files are read
+ *  through a read-only memory mapping. An empty directory disables the
+ *  cache.
+ */
+class OrderingCache {
+  public:
+    typedef Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, GridIndex> Permutation;
+
+    OrderingCache();
+
+    /// Set the cache directory, creating it if necessary.
+    void setDirectory (const std::string &directory);
+    /// Whether a cache directory has been set.
+    bool enabled();
+
+    /// Key of the sparsity pattern of **matrix** ordered with **method**.
+    static boost::uint64_t key (const SparseMatrixXd &matrix,
+                                const std::string &method);
+
+    /** Load the ordering stored under **key** into **ordering**. Returns
+     *  false if there is no valid entry of size **size**.
+     */
+    bool load (const boost::uint64_t key, const GridIndex size, Permutation &ordering);
+    /** Store **ordering** under **key**. A failed write is reported and
+     *  otherwise ignored.
+     */
+    void store (const boost::uint64_t key, const Permutation &ordering);
+
+  private:
+    /// Cache file holding the entry for **key**.
+    std::string path (const boost::uint64_t key);
+
+    std::string directory;
+};
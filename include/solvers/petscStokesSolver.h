@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Eigen/Sparse>
+#include <Eigen/Dense>
+
+#include "geometry/index.h"
+
+#ifdef USE_PETSC
+#include <petscksp.h>
+#endif
+
+/** @brief Distributed iterative solver for the staggered Stokes system.
+ *
+ *  Available when built with PETSC_ENABLED. The rows of the Stokes system
+ *  are split evenly over the processes of PETSC_COMM_WORLD (see
+ *  ownedRows()); each process assembles only its own rows with SparseForms
+ *  and copies them into a PETSc AIJ matrix, which is solved with FGMRES
+ *  preconditioned by a full block factorization of the velocity/pressure
+ *  saddle point (PCFIELDSPLIT with a Schur complement). The velocity block
+ *  is approximated by algebraic multigrid (GAMG) and the Schur complement
+ *  by the "selfp" approximation. The constant pressure mode is declared as
+ *  the null space of the system and of the Schur complement.
+ *
+ *  All of these defaults can be changed through the PETSc options database
+ *  under the "stokes_" prefix, e.g. on the command line:
+ *  @verbatim
+    mpirun -np 16 ./mc-mini params -stokes_ksp_monitor -stokes_fieldsplit_velocity_pc_type hypre
+    @endverbatim
+ *
+ *  The right-hand sides and initial guesses are read on the first process
+ *  and scattered to the owners of their rows, and the solutions gathered
+ *  back onto the first process, in the layout of the GeometryStructure
+ *  Stokes data, which hands the other processes the velocities of their
+ *  blocks (see Decomposition::scatterFaces()).
+ */
+class PetscStokesSolver {
+  public:
+    PetscStokesSolver();
+    ~PetscStokesSolver();
+
+    /// Whether mc-mini was built with PETSc.
+    static bool available();
+
+    /** Set the relative residual at which the iteration stops and the
+     *  maximum number of iterations per solve.
+     */
+    void setup (const double tolerance, const int maxIterations);
+
+    /** Split a system of **size** unknowns over the processes, returning
+     *  the rows [**rowBegin**, **rowEnd**) owned by this one. Collective;
+     *  call before each compute().
+     */
+    void ownedRows (const GridIndex size, GridIndex &rowBegin, GridIndex &rowEnd);
+
+    /** Copy **rows**, this process' rows of the system, whose last
+     *  **pressureSize** unknowns are the pressure, and set up the
+     *  preconditioner. Collective.
+     */
+    void compute (const SparseMatrixXd &rows, const GridIndex pressureSize);
+
+    /** Solve for every column of **rhs**, starting from the matching
+     *  column of **guess**, or from zero if it is empty. Collective; only
+     *  the arguments of the first process are read, and only its
+     *  **solution** is filled in.
+     */
+    void solve (const Eigen::MatrixXd &rhs, const Eigen::MatrixXd &guess, Eigen::MatrixXd &solution);
+
+    /// Krylov iterations taken by the last solve(), over all columns.
+    int getIterations();
+
+  private:
+    /// Release the PETSc objects of the last compute().
+    void destroy();
+
+    double tolerance;
+    int maxIterations;
+    int iterations;
+
+  #ifdef USE_PETSC
+    /// The rows [rowBegin, rowEnd) of the system owned by this process
+    PetscInt rowBegin;
+    PetscInt rowEnd;
+    PetscInt size;
+
+    Mat matrix;
+    KSP ksp;
+    IS velocityRows;
+    IS pressureRows;
+    MatNullSpace nullSpace;
+
+    Vec rhsVector;
+    Vec solutionVector;
+    /// The whole right-hand side or solution, on the first process only
+    Vec rootVector;
+    /// Between solutionVector (or rhsVector) and rootVector
+    VecScatter scatter;
+  #endif
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Eigen/Dense>
+
+#include "geometry/index.h"
+
+/** @brief Second-order Runge-Kutta-Legendre (RKL2) super-time-stepping.
+ *
+ *  Advances \f$ T_t = \kappa \nabla^2 T \f$ on the MxN cell-centered grid by
+ *  one step of s explicit stages (Meyer, Balsara and Aslam, 2014), with
+ *  insulated (Neumann) left and right boundaries and prescribed (Dirichlet)
+ *  lower and upper boundary temperatures. The stage count is chosen from the
+ *  ratio of the step to the forward Euler limit
+ *  \f$ 1 / 2 \kappa (h_x^{-2} + h_y^{-2}) \f$, so any step is stable while
+ *  costing only \f$ O(\sqrt{\Delta{t}}) \f$ stencil applications. The five-point stencil is applied matrix-free, fused with
+ *  the stage update, and threaded over rows with OpenMP when built with
+ *  OPENMP_ENABLED.
+ */
+class RKLDiffusionSolver {
+  public:
+    RKLDiffusionSolver();
+
+    /// Prepare the stage buffers for an MxN grid.
+    void setup (const GridIndex M, const GridIndex N);
+
+    /// The number of rows the solver was set up for (0 before setup()).
+    GridIndex getM();
+    /// The number of columns the solver was set up for (0 before setup()).
+    GridIndex getN();
+
+    /** Advance **temperature** by **deltaT** and write the result into
+     *  **result**, using the (N, 2) window of lower and upper boundary
+     *  temperatures **boundary**. Returns the number of stages taken.
+     */
+    int step (const double deltaT,
+              const double diffusivity,
+              const double hx,
+              const double hy,
+              const double * temperature,
+              const double * boundary,
+              double * result);
+    /// Single precision step, carried out in double on internal copies.
+    int step (const double deltaT,
+              const double diffusivity,
+              const double hx,
+              const double hy,
+              const float * temperature,
+              const float * boundary,
+              float * result);
+
+    /** The smallest stage count s >= 2 for which RKL2 is stable with a step
+     *  **ratio** times the forward Euler limit, i.e. (s^2 + s - 2) / 4 >= ratio.
+     */
+    static int stageCount (const double ratio);
+
+  private:
+    /** Write \f$ a Y + b Z + c T + d \, L(Y) + e \, L(T) \f$ into **out**,
+     *  where \f$ L \f$ is the five-point stencil with its x and y second
+     *  differences scaled by \f$ \kappa \Delta{t} / h_x^2 \f$ and
+     *  \f$ \kappa \Delta{t} / h_y^2 \f$ and \f$ L(T) \f$ is given precomputed
+     *  as **lT**. Z may be null when b is zero.
+     */
+    void stage (const double a, const double * Y,
+                const double b, const double * Z,
+                const double c, const double * T,
+                const double d,
+                const double e, const double * lT,
+                const double * boundary,
+                double * out);
+
+    GridIndex M;
+    GridIndex N;
+
+    /// Stencil scales \f$ \kappa \Delta{t} / h_x^2 \f$ and \f$ \kappa \Delta{t} / h_y^2 \f$ of the current step
+    double xScale;
+    double yScale;
+
+    /// The stencil applied to the initial temperature
+    Eigen::VectorXd initialStencil;
+    /// Two stage buffers; the third is the caller's result array
+    Eigen::VectorXd stageBuffers;
+
+    /// Double precision copies of single precision input and result
+    Eigen::VectorXd workTemperature;
+    Eigen::VectorXd workBoundary;
+    Eigen::VectorXd workResult;
+};
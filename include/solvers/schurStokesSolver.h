@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Eigen/Sparse>
+#include <Eigen/Dense>
+
+#include "geometry/index.h"
+
+/** @brief Block solver for the staggered Stokes system.
+ *
+ *  The Stokes matrix of SparseForms is the saddle point
+ *  @verbatim
+    | K    G | | u |   | f |
+    | -G^T 0 | | p | = | g |
+    @endverbatim
+ *  with the viscous block K and the gradient G. Instead of factoring the
+ *  whole indefinite system, only K is factored, and the pressure is found
+ *  from the Schur complement system
+ *  \f[ G^T K^{-1} G \, p = g + G^T K^{-1} f \f]
+ *  before the velocity is recovered from \f$ K u = f - G p \f$.
+ *
+ *  With a constant viscosity K is symmetric positive definite: it is
+ *  factored with a sparse Cholesky decomposition and the Schur complement
+ *  system is solved with conjugate gradients. With a variable viscosity the
+ *  rows of K are scaled by different viscosities, so K is factored with
+ *  SparseLU and the Schur complement system solved with BiCGSTAB instead.
+ *  Either way the iteration is preconditioned with the lumped pressure mass
+ *  matrix scaled by the inverse cell viscosity; the viscosity of each cell
+ *  is taken from the diagonal of K on its faces. The pressure is kept at
+ *  zero mean, as it is only determined up to a constant.
+ */
+class SchurStokesSolver {
+  public:
+    SchurStokesSolver();
+
+    /** Set the relative residual at which the iteration stops and the
+     *  maximum number of iterations per solve.
+     */
+    void setup (const double tolerance, const int maxIterations);
+
+    /// Split **matrix**, whose last **pressureSize** unknowns are the pressure, and factor K.
+    void compute (const SparseMatrixXd &matrix, const GridIndex pressureSize);
+
+    /** Solve for every column of **rhs**, starting from the pressure in
+     *  the matching column of **guess**, or from zero if it is empty.
+     */
+    void solve (const Eigen::MatrixXd &rhs, const Eigen::MatrixXd &guess, Eigen::MatrixXd &solution);
+
+    /// Iterations taken by the last solve(), over all columns.
+    int getIterations();
+    /// Whether K was symmetric, and so solved with Cholesky and CG.
+    bool symmetricVelocityBlock();
+
+  private:
+    /// Apply the Schur complement to **pressure**.
+    Eigen::VectorXd applySchur (const Eigen::VectorXd &pressure);
+    /// Apply the inverse of K to **velocity**.
+    Eigen::VectorXd solveVelocity (const Eigen::VectorXd &velocity);
+    /// Apply the preconditioner to **residual**, keeping the result at zero mean.
+    Eigen::VectorXd precondition (const Eigen::VectorXd &residual);
+
+    /// Solve the Schur complement system for **pressure** with conjugate gradients.
+    void conjugateGradient (const Eigen::VectorXd &rhs, Eigen::VectorXd &pressure);
+    /// Solve the Schur complement system for **pressure** with BiCGSTAB.
+    void biconjugateGradientStabilized (const Eigen::VectorXd &rhs, Eigen::VectorXd &pressure);
+
+    double tolerance;
+    int maxIterations;
+    int iterations;
+
+    SparseMatrixXd velocityBlock;
+    SparseMatrixXd gradient;
+    SparseMatrixXd divergence;
+    /// Cell viscosity, the inverse of the scaled pressure mass matrix
+    Eigen::VectorXd pressureScaling;
+
+    bool symmetric;
+    Eigen::SimplicialLLT<SparseMatrixXd > choleskySolver;
+    Eigen::SparseLU<SparseMatrixXd, Eigen::COLAMDOrdering<GridIndex> > luSolver;
+};
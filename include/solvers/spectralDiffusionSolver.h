@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <complex>
+
+#include <Eigen/Dense>
+#include <unsupported/Eigen/FFT>
+
+#include "geometry/index.h"
+
+/** @brief Direct solver for implicit diffusion steps on the uniform grid.
+ *
+ *  Solves \f$ (I + \mu_x L_x + \mu_y L_y) T = b \f$ on the MxN cell-centered
+ *  grid, where \f$ L_x \f$ and \f$ L_y \f$ are the negated second
+ *  differences in x and y, with insulated (Neumann) left and right boundaries
+ *  and prescribed (Dirichlet) lower and upper boundaries, as assembled by
+ *  backwardEuler() and crankNicolson().
+ *
+ *  The operator is diagonalized by a DCT-II in x and a DST-I in y, so the
+ *  solve costs \f$ O(MN \log MN) \f$ and needs no factorization. Both
+ *  transforms are computed with Eigen's FFT module on even/odd extensions
+ *  of each row and column.
+ */
+class SpectralDiffusionSolver {
+  public:
+    SpectralDiffusionSolver();
+
+    /// Prepare the transforms and eigenvalues for an MxN grid.
+    void setup (const GridIndex M, const GridIndex N);
+
+    /// The number of rows the solver was set up for (0 before setup()).
+    GridIndex getM();
+    /// The number of columns the solver was set up for (0 before setup()).
+    GridIndex getN();
+
+    /** Overwrite the MxN right-hand side **data** with the solution of
+     *  \f$ (I + \mu_x L_x + \mu_y L_y) T = b \f$.
+     */
+    void solve (const double muX, const double muY, double * data);
+    /// Single precision solve, carried out in double on an internal copy.
+    void solve (const double muX, const double muY, float * data);
+
+  private:
+    /// In-place DCT-II of a row of N values.
+    void forwardCosineTransform (double * row);
+    /// In-place inverse of forwardCosineTransform().
+    void inverseCosineTransform (double * row);
+    /// In-place (unnormalized) DST-I of a column of M values with stride N.
+    void sineTransform (double * column);
+
+    GridIndex M;
+    GridIndex N;
+
+    Eigen::FFT<double> fft;
+
+    /// Eigenvalues of the x and y second-difference operators
+    Eigen::VectorXd xEigenvalues;
+    Eigen::VectorXd yEigenvalues;
+
+    /// Phase factors \f$ e^{-i \pi k / 2N} \f$ of the DCT-II
+    std::vector<std::complex<double> > xTwiddle;
+
+    /// Extended sequences and their spectra for the row and column FFTs
+    std::vector<std::complex<double> > xBuffer;
+    std::vector<std::complex<double> > xSpectrum;
+    std::vector<std::complex<double> > yBuffer;
+    std::vector<std::complex<double> > ySpectrum;
+
+    /// Double precision copy of single precision data
+    Eigen::VectorXd work;
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <Eigen/Sparse>
+#include <Eigen/Dense>
+
+#include "geometry/index.h"
+#include "solvers/orderingCache.h"
+
+class PetscStokesSolver;
+class SchurStokesSolver;
+
+/** @brief Sparse direct solver for the staggered Stokes system.
+ *
+ *  In "double" precision the system is factored and solved with SparseLU.
+ *  In "mixed" precision a single precision copy of the matrix is factored
+ *  instead, which halves the memory of the factors and speeds up both the
+ *  factorization and the triangular solves. The single precision solution
+ *  is then improved by iterative refinement: the residual is computed in
+ *  double precision and the correction solved with the single precision
+ *  factors until the relative residual falls below the refinement
+ *  tolerance. If the residual stops decreasing (e.g. for the large
+ *  viscosity contrasts of solCXBenchmark) the system is factored in double
+ *  precision and that factorization is used until the next compute().
+ *
+ *  The fill-reducing ordering is computed separately and applied to the
+ *  matrix before factoring, so that it can be shared by both precisions and
+ *  kept in an OrderingCache across runs. By default the columns are ordered
+ *  with COLAMD; the symmetric orderings "amd", "metis" (when built with
+ *  METIS_ENABLED) and "nestedDissection" (see NestedDissectionOrdering)
+ *  permute rows and columns alike.
+ *
+ *  With the "schur" backend only the velocity block is factored, and the
+ *  pressure found iteratively (see SchurStokesSolver). With the "petsc"
+ *  backend each MPI process assembles its share of the rows of the system
+ *  (see ownedRows()), which a PetscStokesSolver solves iteratively over all
+ *  of them. Both iterate to the same relative residual tolerance.
+ */
+class StokesSolver {
+  public:
+    StokesSolver();
+    ~StokesSolver();
+
+    /** Set the factorization precision, "double" or "mixed", the relative
+     *  residual at which refinement stops and the maximum number of
+     *  refinement iterations per solve.
+     */
+    void setup (const std::string &precision,
+                const double tolerance,
+                const int maxRefinements);
+
+    /** Keep column orderings in **directory** across runs (see
+     *  OrderingCache). An empty directory disables the cache.
+     */
+    void setOrderingCache (const std::string &directory);
+
+    /** Order the system with **method**, "colamd", "amd", "metis" or
+     *  "nestedDissection", for the M x N grid **M**, **N**.
+     */
+    void setOrdering (const std::string &method, const GridIndex M, const GridIndex N);
+
+    /** Solve with **backend**, "eigen" (the sparse LU above), "schur" (see
+     *  SchurStokesSolver) or "petsc" (see PetscStokesSolver), taking at most
+     *  **maxIterations** iterations per solve with the iterative backends.
+     *  The last **pressureSize** unknowns of the system are the pressure.
+     *  Call after setup().
+     */
+    void setBackend (const std::string &backend, const GridIndex pressureSize, const int maxIterations);
+
+    /** The rows [**rowBegin**, **rowEnd**) of a system of **size** unknowns
+     *  that this process assembles for compute(): all of them, but with the
+     *  "petsc" backend, which splits them over the MPI processes. Call
+     *  before each compute(), on every process with the "petsc" backend.
+     */
+    void ownedRows (const GridIndex size, GridIndex &rowBegin, GridIndex &rowEnd);
+
+    /** Factor **matrix**, the rows given by ownedRows(). The matrix is
+     *  referenced, not copied, by the refinement in solve() and must
+     *  outlive the factorization.
+     */
+    void compute (const SparseMatrixXd &matrix);
+
+    /// Solve the factored system for the right-hand side **rhs**.
+    Eigen::VectorXd solve (const Eigen::VectorXd &rhs);
+    /** Solve the factored system for every column of **rhs** at once,
+     *  sharing the factorization and the triangular sweeps between them.
+     */
+    void solve (const Eigen::MatrixXd &rhs, Eigen::MatrixXd &solution);
+    /** Solve as above, starting the iterative backends from the columns of
+     *  **guess** (e.g. the previous solution). An empty guess starts them
+     *  from zero; the sparse LU ignores it.
+     */
+    Eigen::VectorXd solve (const Eigen::VectorXd &rhs, const Eigen::VectorXd &guess);
+    void solve (const Eigen::MatrixXd &rhs, const Eigen::MatrixXd &guess, Eigen::MatrixXd &solution);
+
+    /** Whether **other** solves the same way: the same precision,
+     *  refinement, ordering method, backend and iteration limit. The
+     *  ordering cache is not compared.
+     */
+    bool sameSettings (const StokesSolver &other) const;
+
+    /// The factorization precision.
+    const std::string &getPrecision();
+    /// The backend, "eigen", "schur" or "petsc".
+    const std::string &getBackend();
+    /// Refinement iterations taken by the last solve(), over all columns.
+    int getRefinementIterations();
+    /// Iterations taken by the last solve() of the iterative backends, over all columns.
+    int getIterations();
+    /// Whether mixed precision refinement stalled and fell back to double.
+    bool usedFallback();
+    /// Whether the ordering used by the last compute() came from the cache.
+    bool orderingFromCache();
+    /// Nonzeros of the L and U factors of the last factorization, nnz(L+U), or 0 with the iterative backends.
+    long factorNonZeros();
+
+  private:
+    /// Load or compute the column ordering of the referenced matrix.
+    void computeOrdering();
+    /// Factor the referenced matrix in double precision.
+    void factorDouble();
+    /// The referenced matrix, permuted by the ordering.
+    SparseMatrixXd orderedMatrix();
+    /// Permute the rows of **rhs** to match orderedMatrix().
+    Eigen::MatrixXd orderedRhs (const Eigen::MatrixXd &rhs);
+
+    std::string precision;
+    double tolerance;
+    int maxRefinements;
+
+    std::string backend;
+    GridIndex pressureSize;
+    int maxIterations;
+    std::unique_ptr<SchurStokesSolver> schurSolver;
+    std::unique_ptr<PetscStokesSolver> petscSolver;
+
+    const SparseMatrixXd * matrix;
+
+    OrderingCache cache;
+    std::string orderingMethod;
+    GridIndex gridM;
+    GridIndex gridN;
+    /** The factored matrices are matrix * ordering^-1 for COLAMD, and
+     *  ordering * matrix * ordering^-1 for the symmetric orderings.
+     */
+    OrderingCache::Permutation ordering;
+    bool symmetricOrdering;
+    bool cachedOrdering;
+
+    Eigen::SparseLU<SparseMatrixXd, Eigen::NaturalOrdering<GridIndex> > doubleSolver;
+    Eigen::SparseLU<Eigen::SparseMatrix<float, Eigen::ColMajor, GridIndex>,  Eigen::NaturalOrdering<GridIndex> > singleSolver;
+
+    bool doubleFactored;
+    int refinementIterations;
+};
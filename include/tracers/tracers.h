@@ -0,0 +1,122 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "geometry/index.h"
+#include "geometry/scalar.h"
+
+/** \brief Lagrangian tracers carrying temperature and composition
+ *
+ *  The TracerStructure class holds a cloud of passive tracers (markers) in
+ *  structure-of-arrays form: positions, temperature and the K compositional
+ *  fields each live in their own contiguous array, so the advection and
+ *  projection loops stream through memory. Tracers are moved through the
+ *  staggered velocity field with a second or fourth order Runge-Kutta
+ *  integrator and their values are averaged back onto the cells, which
+ *  avoids the numerical diffusion of the grid-based advection schemes.
+ *
+ *  After every step the tracers are binned by cell with a counting sort of
+ *  their indices. Every few steps the arrays themselves are permuted into
+ *  cell order so that tracers sharing a cell stay adjacent in memory. The
+ *  advection and projection loops are threaded with OpenMP when built with
+ *  OPENMP_ENABLED.
+ */
+class TracerStructure {
+  public:
+    TracerStructure();
+
+    /** Seed **tracersPerSide** x **tracersPerSide** evenly spaced tracers in
+     *  each cell of the MxN grid of **hx** x **hy** cells, each taking the
+     *  temperature and K interleaved compositions of its cell. The tracer
+     *  arrays are reordered every **sortInterval** calls to bin().
+     */
+    void seed (const GridIndex M, const GridIndex N, const int K,
+               const double hx,
+               const double hy,
+               const int tracersPerSide,
+               const int sortInterval,
+               const Real * temperature,
+               const Real * composition);
+
+    /** Move every tracer over **deltaT** through the staggered velocity
+     *  field with the integrator "rungeKutta2" (midpoint) or "rungeKutta4".
+     *  Tracers are kept inside the domain.
+     */
+    void advect (const std::string &integrator,
+                 const double deltaT,
+                 double * uVelocity,
+                 double * vVelocity,
+                 double * uVelocityBoundary,
+                 double * vVelocityBoundary);
+
+    /** Bin the tracers by cell, and every sortInterval calls permute the
+     *  tracer arrays into cell order.
+     */
+    void bin();
+
+    /** Add the change the grid temperature has seen since the last call to
+     *  project() (e.g. from diffusion) to the tracers in each cell.
+     */
+    void applyGridChange (const Real * temperature);
+
+    /** Average the tracers in each cell into **temperature** and the K
+     *  interleaved fields of **composition**. Cells without tracers keep
+     *  their values. Requires an up-to-date bin().
+     */
+    void project (Real * temperature, Real * composition);
+
+    /// The number of tracers.
+    GridIndex getTracerCount();
+    /// The tracer x coordinates.
+    const double * getXData();
+    /// The tracer y coordinates.
+    const double * getYData();
+    /// The tracer temperatures.
+    const Real * getTemperatureData();
+    /// Compositional field f of every tracer.
+    const Real * getCompositionData (const int f);
+    /// The index of the first tracer of each cell in the binned order.
+    const GridIndex * getCellStartData();
+
+  private:
+    /// Cell containing the point (x, y).
+    GridIndex cellIndex (const double x, const double y);
+
+    GridIndex M;
+    GridIndex N;
+    int K;
+    double hx;
+    double hy;
+    GridIndex tracerCount;
+
+    int sortInterval;
+    int binsSinceSort;
+
+    /** @name Tracer Data
+     *  One array per tracer property; compositional field f of tracer p is
+     *  composition[f * tracerCount + p].
+     *  @{
+     */
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<Real> temperature;
+    std::vector<Real> composition;
+    /** @} */
+
+    /** @name Binning Data
+     *  The cell of each tracer, the offsets of each cell's tracers in
+     *  binnedOrder, and tracer indices ordered by cell.
+     *  @{
+     */
+    std::vector<GridIndex> cell;
+    std::vector<GridIndex> cellStart;
+    std::vector<GridIndex> binnedOrder;
+    /** @} */
+
+    /// The grid temperature written by the last project()
+    std::vector<Real> projectedTemperature;
+
+    /// Scratch space used to permute the tracer arrays
+    std::vector<double> scratch;
+};
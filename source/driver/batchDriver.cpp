@@ -0,0 +1,230 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "debug/exception.h"
+#include "params/paramParser.h"
+#include "driver/simulation.h"
+#include "driver/batchDriver.h"
+#include "params.h"
+
+// Serializes reports from the worker threads.
+static std::mutex reportMutex;
+
+BatchDriver::BatchDriver (unsigned int nThreads) :
+    nThreads (nThreads) {
+  if (this->nThreads == 0)
+    this->nThreads = std::max (1u, std::thread::hardware_concurrency());
+}
+
+void BatchDriver::load (const std::string manifestFile) {
+  std::ifstream manifestStream (manifestFile);
+
+  if (manifestStream.fail()) {
+    THROW_WITH_TRACE(RuntimeError() <<
+            errmsg_info("Failed to open batch manifest '" + manifestFile + "'."));
+  }
+
+  parse (manifestStream);
+}
+
+void BatchDriver::parse (std::istream &manifestStream) {
+  std::string lineBuf;
+
+  while (getline (manifestStream, lineBuf)) {
+    std::istringstream lineStream (lineBuf);
+    std::vector<std::string> tokens;
+    std::string token;
+
+    while (lineStream >> token)
+      tokens.push_back (token);
+
+    if (tokens.empty() || tokens[0][0] == '#')
+      continue;
+
+    if (tokens[0] != "sweep") {
+      // A bare parameter file is run exactly as written.
+      BatchRun batchRun;
+      batchRun.paramFile = tokens[0];
+      batchRun.label     = tokens[0];
+      runs.push_back (batchRun);
+      continue;
+    }
+
+    if (tokens.size() < 3) {
+      THROW_WITH_TRACE(InvalidArgument() <<
+              errmsg_info("Malformed sweep entry: '" + lineBuf + "'."));
+    }
+
+    // Expand each 'section/key=values' specification. All keys of an entry
+    // are varied in lockstep, so their value lists must be the same length.
+    std::vector<std::string> keys;
+    std::vector<std::vector<std::string> > values;
+    for (size_t k = 2; k < tokens.size(); ++k) {
+      size_t split = tokens[k].find ('=');
+      if (split == std::string::npos) {
+        THROW_WITH_TRACE(InvalidArgument() <<
+                errmsg_info("Malformed sweep parameter: '" + tokens[k] + "'."));
+      }
+      keys.push_back (tokens[k].substr (0, split));
+      values.push_back (expandValues (tokens[k].substr (split + 1)));
+
+      if (values.back().size() != values.front().size()) {
+        THROW_WITH_TRACE(InvalidArgument() <<
+                errmsg_info("Sweep parameters have differing numbers of values: '" + lineBuf + "'."));
+      }
+    }
+
+    for (size_t v = 0; v < values.front().size(); ++v) {
+      BatchRun batchRun;
+      batchRun.paramFile = tokens[1];
+
+      for (size_t k = 0; k < keys.size(); ++k) {
+        batchRun.overrides.push_back (std::make_pair (keys[k], values[k][v]));
+
+        std::string keyName = keys[k].substr (keys[k].find_last_of ('/') + 1);
+        batchRun.label += (k == 0 ? "" : "_") + keyName + "-" + values[k][v];
+      }
+
+      runs.push_back (batchRun);
+    }
+  }
+}
+
+std::vector<std::string> BatchDriver::expandValues (const std::string &spec) {
+  std::vector<std::string> values;
+
+  if (spec.find (':') == std::string::npos) {
+    // Comma-separated list of values
+    std::istringstream specStream (spec);
+    std::string value;
+    while (getline (specStream, value, ','))
+      if (value != "")
+        values.push_back (value);
+  } else {
+    // Inclusive start:stop:step range
+    std::istringstream specStream (spec);
+    std::string startString, stopString, stepString;
+    getline (specStream, startString, ':');
+    getline (specStream, stopString,  ':');
+    getline (specStream, stepString);
+
+    double start, stop, step;
+    try {
+      start = boost::lexical_cast<double> (startString);
+      stop  = boost::lexical_cast<double> (stopString);
+      step  = boost::lexical_cast<double> (stepString);
+    } catch (boost::bad_lexical_cast &) {
+      THROW_WITH_TRACE(InvalidArgument() <<
+              errmsg_info("Malformed parameter range: '" + spec + "'."));
+    }
+
+    if (!(step > 0) || stop < start) {
+      THROW_WITH_TRACE(InvalidArgument() <<
+              errmsg_info("Empty parameter range: '" + spec + "'."));
+    }
+
+    int nValues = std::floor ((stop - start) / step + 1E-09) + 1;
+    for (int k = 0; k < nValues; ++k) {
+      std::ostringstream value;
+      value << start + k * step;
+      values.push_back (value.str());
+    }
+  }
+
+  if (values.empty()) {
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("Empty parameter specification: '" + spec + "'."));
+  }
+
+  return values;
+}
+
+const std::vector<BatchDriver::BatchRun> &BatchDriver::getRuns() {
+  return runs;
+}
+
+int BatchDriver::run() {
+  std::atomic<size_t> nextRun (0);
+  std::atomic<int>    nFailed (0);
+
+  unsigned int nWorkers = std::min<size_t> (nThreads, runs.size());
+
+  std::cout << "<Running " << runs.size() << " batch runs on "
+            << nWorkers << " threads>" << std::endl;
+
+  // Each worker repeatedly claims the next unstarted run until none remain.
+  auto worker = [&]() {
+    size_t runIndex;
+    while ((runIndex = nextRun++) < runs.size()) {
+      try {
+        executeRun (runs[runIndex]);
+
+        std::lock_guard<std::mutex> lock (reportMutex);
+        std::cout << "<Batch run " << runIndex + 1 << "/" << runs.size()
+                  << " (" << runs[runIndex].label << ") finished>" << std::endl;
+      } catch (std::exception &e) {
+        nFailed++;
+
+        std::lock_guard<std::mutex> lock (reportMutex);
+        std::cerr << "<Batch run " << runIndex + 1 << "/" << runs.size()
+                  << " (" << runs[runIndex].label << ") failed>" << std::endl
+                  << boost::diagnostic_information (e);
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned int t = 0; t < nWorkers; ++t)
+    workers.push_back (std::thread (worker));
+  for (auto &thread : workers)
+    thread.join();
+
+  return nFailed;
+}
+
+void BatchDriver::applyOverrides (const BatchRun &batchRun, Params &params) {
+  if (!batchRun.overrides.empty()) {
+    for (auto &entry : batchRun.overrides) {
+      // Walk down the 'section/subsection/key' path to the parameter.
+      std::vector<std::string> path;
+      std::istringstream pathStream (entry.first);
+      std::string section;
+      while (getline (pathStream, section, '/'))
+        path.push_back (section);
+
+      for (size_t s = 0; s + 1 < path.size(); ++s)
+        params.push (path[s]);
+      params.setParam<std::string> (path.back(), entry.second);
+      for (size_t s = 0; s + 1 < path.size(); ++s)
+        params.pop();
+    }
+
+    // Give every generated run its own output directory.
+    std::string outputPath;
+    params.push ("outputParams"); {
+      params.queryParam<std::string> ("outputPath", outputPath, ".");
+      params.setParam<std::string> ("outputPath", outputPath + "/" + batchRun.label);
+
+      params.pop();
+    }
+  }
+}
+
+void BatchDriver::executeRun (const BatchRun &batchRun) {
+  ParamParser pp;
+  pp.load (batchRun.paramFile);
+  Params params = pp.getParams();
+
+  applyOverrides (batchRun, params);
+
+  runSimulation (params);
+}
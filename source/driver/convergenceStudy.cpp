@@ -0,0 +1,355 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include <cmath>
+#include <limits>
+
+#include <boost/filesystem.hpp>
+
+#include "debug/exception.h"
+#include "geometry/dataWindow.h"
+#include "geometry/geometry.h"
+#include "problem/problem.h"
+#include "output/output.h"
+#include "params/paramParser.h"
+#include "driver/simulation.h"
+#include "driver/convergenceStudy.h"
+#include "params.h"
+
+ConvergenceStudy::ConvergenceStudy (const std::string paramFile) :
+    paramFile (paramFile) {
+  ParamParser pp;
+  pp.load (paramFile);
+  Params params = pp.getParams();
+
+  double viscosityScale;
+  double endTime;
+
+  params.push ("problemParams"); {
+    params.queryParam<double> ("endTime", endTime, std::numeric_limits<int>::max());
+    params.queryParam<std::string> ("forcingModel",   forcingModel,   "tauBenchmark");
+    params.queryParam<std::string> ("boundaryModel",  boundaryModel,  "tauBenchmark");
+    params.queryParam<std::string> ("viscosityModel", viscosityModel, "constant");
+
+    params.tryPush ("initialViscosity"); {
+      params.queryParam<double> ("viscosityScale", viscosityScale, 1.0);
+
+      params.pop();
+    }
+    params.pop();
+  }
+
+  // The Tau benchmark is only an exact solution for unit viscosity.
+  if (viscosityModel == "constant" && viscosityScale != 1.0)
+    viscosityModel = "scaled";
+
+  params.tryPush ("convergenceParams"); {
+    params.queryParam<int> ("levels", nLevels, 4);
+    params.queryParam<std::string> (
+            "reference",
+            reference,
+            hasAnalyticSolution() ? "analytic" : "finest");
+
+    params.pop();
+  }
+
+  params.push ("outputParams"); {
+    params.queryParam<std::string> ("outputPath",     outputPath,     ".");
+    params.queryParam<std::string> ("outputFilename", outputFilename, "output");
+
+    params.pop();
+  }
+
+  if (reference == "analytic" && !hasAnalyticSolution()) {
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("No analytic solution is available for forcing model '" + forcingModel + "'."));
+  } else if (reference != "analytic" && reference != "finest") {
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("Unexpected convergence reference: '" + reference + "'."));
+  }
+
+  // Each level takes its own CFL-limited steps, so only a common end time
+  // (and not a step count) compares the levels at the same physical time.
+  if (endTime >= std::numeric_limits<int>::max()) {
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("A convergence study requires an endTime common to all levels."));
+  }
+
+  if (nLevels < ((reference == "finest") ? 3 : 2)) {
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("Too few refinement levels for a convergence study."));
+  }
+}
+
+bool ConvergenceStudy::hasAnalyticSolution() {
+  return forcingModel  == "tauBenchmark" &&
+         boundaryModel == "tauBenchmark" &&
+         viscosityModel == "constant";
+}
+
+void ConvergenceStudy::run() {
+  levels.resize (nLevels);
+
+  // The levels are independent, so they are all run at once.
+  std::vector<std::thread> workers;
+  std::vector<std::exception_ptr> failures (nLevels);
+  for (int l = 0; l < nLevels; ++l) {
+    workers.push_back (std::thread ([this, l, &failures]() {
+      try {
+        runLevel (levels[l], l);
+      } catch (...) {
+        failures[l] = std::current_exception();
+      }
+    }));
+  }
+  for (auto &worker : workers)
+    worker.join();
+
+  for (auto &failure : failures)
+    if (failure)
+      std::rethrow_exception (failure);
+}
+
+void ConvergenceStudy::runLevel (Level &level, const int refinement) {
+  ParamParser pp;
+  pp.load (paramFile);
+  Params params = pp.getParams();
+
+  // Refine the base grid, run every level to the common end time and
+  // suppress all field output.
+  GridIndex M, N;
+  params.push ("geometryParams"); {
+    params.getParam<GridIndex> ("M", M);
+    params.getParam<GridIndex> ("N", N);
+    params.setParam<GridIndex> ("M", M << refinement);
+    params.setParam<GridIndex> ("N", N << refinement);
+
+    params.pop();
+  }
+  params.push ("problemParams"); {
+    params.setParam<int> ("endStep", std::numeric_limits<int>::max());
+
+    params.pop();
+  }
+  params.push ("outputParams"); {
+    params.setParam<std::string> ("outputFormat", "none");
+
+    params.pop();
+  }
+
+  GeometryStructure geometry (params);
+  ProblemStructure  problem  (params, geometry);
+  OutputStructure   output   (params, geometry, problem);
+
+  problem.initializeProblem();
+  runTimestepLoop (problem, output);
+
+  level.M = geometry.getM();
+  level.N = geometry.getN();
+  level.hx = problem.getHx();
+  level.hy = problem.getHy();
+  level.xFaces   = problem.getXFaces();
+  level.yFaces   = problem.getYFaces();
+  level.xCenters = problem.getXCenters();
+  level.yCenters = problem.getYCenters();
+
+  GridIndex stokesSize = 3 * level.M * level.N - level.M - level.N;
+  level.stokes.assign (geometry.getStokesData(), geometry.getStokesData() + stokesSize);
+  level.temperature.assign (geometry.getTemperatureData(),
+                            geometry.getTemperatureData() + level.M * level.N);
+}
+
+// Exact solution of the Tau (1991) benchmark: u = cos(x) sin(y),
+// v = -sin(x) cos(y), p = sin(x) sin(y) with the mean pressure removed.
+void ConvergenceStudy::analyticSolution (const Level &level, std::vector<double> &stokes) {
+  const GridIndex M = level.M;
+  const GridIndex N = level.N;
+  const std::vector<double> &x  = level.xFaces;
+  const std::vector<double> &y  = level.yFaces;
+  const std::vector<double> &xc = level.xCenters;
+  const std::vector<double> &yc = level.yCenters;
+
+  stokes.resize (3 * M * N - M - N);
+  DataWindow<double> uWindow (stokes.data(), N - 1, M);
+  DataWindow<double> vWindow (stokes.data() + M * (N - 1), N, M - 1);
+  DataWindow<double> pWindow (stokes.data() + 2 * M * N - M - N, N, M);
+
+  for (GridIndex i = 0; i < M; ++i)
+    for (GridIndex j = 0; j < N - 1; ++j)
+      uWindow (j, i) = cos (x[j + 1]) * sin (yc[i]);
+
+  for (GridIndex i = 0; i < M - 1; ++i)
+    for (GridIndex j = 0; j < N; ++j)
+      vWindow (j, i) = -sin (xc[j]) * cos (y[i + 1]);
+
+  double pressureMean = 0;
+  for (GridIndex i = 0; i < M; ++i)
+    for (GridIndex j = 0; j < N; ++j) {
+      pWindow (j, i) = sin (xc[j]) * sin (yc[i]);
+      pressureMean += pWindow (j, i);
+    }
+  pressureMean /= M * N;
+
+  for (GridIndex i = 0; i < M; ++i)
+    for (GridIndex j = 0; j < N; ++j)
+      pWindow (j, i) -= pressureMean;
+}
+
+ConvergenceStudy::ErrorNorms ConvergenceStudy::errorNorms (const double * values,
+                                                           const double * reference,
+                                                           const GridIndex size,
+                                                           const double cellArea) {
+  ErrorNorms norms = {0, 0, 0};
+
+  for (GridIndex k = 0; k < size; ++k) {
+    double error = std::abs (values[k] - reference[k]);
+    norms.l1   += error * cellArea;
+    norms.l2   += error * error * cellArea;
+    norms.lInf  = std::max (norms.lInf, error);
+  }
+  norms.l2 = std::sqrt (norms.l2);
+
+  return norms;
+}
+
+void ConvergenceStudy::restrictCellField (const double * fine, double * coarse, const GridIndex M, const GridIndex N) {
+  DataWindow<const double> fineWindow (fine, 2 * N, 2 * M);
+  DataWindow<double> coarseWindow (coarse, N, M);
+
+  for (GridIndex i = 0; i < M; ++i)
+    for (GridIndex j = 0; j < N; ++j)
+      coarseWindow (j, i) = (fineWindow (2 * j, 2 * i)     + fineWindow (2 * j + 1, 2 * i) +
+                             fineWindow (2 * j, 2 * i + 1) + fineWindow (2 * j + 1, 2 * i + 1)) / 4;
+}
+
+void ConvergenceStudy::restrictUField (const double * fine, double * coarse, const GridIndex M, const GridIndex N) {
+  DataWindow<const double> fineWindow (fine, 2 * N - 1, 2 * M);
+  DataWindow<double> coarseWindow (coarse, N - 1, M);
+
+  // Coarse u-edges coincide with every other fine u-edge column.
+  for (GridIndex i = 0; i < M; ++i)
+    for (GridIndex j = 0; j < N - 1; ++j)
+      coarseWindow (j, i) = (fineWindow (2 * j + 1, 2 * i) + fineWindow (2 * j + 1, 2 * i + 1)) / 2;
+}
+
+void ConvergenceStudy::restrictVField (const double * fine, double * coarse, const GridIndex M, const GridIndex N) {
+  DataWindow<const double> fineWindow (fine, 2 * N, 2 * M - 1);
+  DataWindow<double> coarseWindow (coarse, N, M - 1);
+
+  // Coarse v-edges coincide with every other fine v-edge row.
+  for (GridIndex i = 0; i < M - 1; ++i)
+    for (GridIndex j = 0; j < N; ++j)
+      coarseWindow (j, i) = (fineWindow (2 * j, 2 * i + 1) + fineWindow (2 * j + 1, 2 * i + 1)) / 2;
+}
+
+void ConvergenceStudy::writeFieldTable (std::ostream &tableStream,
+                                        const std::string fieldName,
+                                        const int field) {
+  // Offsets and sizes of the field within a level's data
+  auto fieldOffset = [field](const Level &level) -> GridIndex {
+    const GridIndex M = level.M, N = level.N;
+    return (field == 0) ? 0 :
+           (field == 1) ? M * (N - 1) :
+           (field == 2) ? 2 * M * N - M - N : 0;
+  };
+  auto fieldSize = [field](const Level &level) -> GridIndex {
+    const GridIndex M = level.M, N = level.N;
+    return (field == 0) ? M * (N - 1) :
+           (field == 1) ? (M - 1) * N : M * N;
+  };
+  auto fieldData = [field, fieldOffset](const Level &level) -> const double * {
+    return (field == 3) ? level.temperature.data() : level.stokes.data() + fieldOffset (level);
+  };
+
+  std::vector<ErrorNorms> errors;
+  std::vector<double> referenceData;
+
+  int nErrors = (reference == "finest") ? nLevels - 1 : nLevels;
+  for (int l = 0; l < nErrors; ++l) {
+    const Level &level = levels[l];
+
+    if (reference == "analytic") {
+      analyticSolution (level, referenceData);
+      referenceData.erase (referenceData.begin(), referenceData.begin() + fieldOffset (level));
+    } else {
+      referenceData.resize (fieldSize (level));
+      const double * fine = fieldData (levels[l + 1]);
+      if (field == 0)
+        restrictUField (fine, referenceData.data(), level.M, level.N);
+      else if (field == 1)
+        restrictVField (fine, referenceData.data(), level.M, level.N);
+      else
+        restrictCellField (fine, referenceData.data(), level.M, level.N);
+    }
+
+    errors.push_back (errorNorms (fieldData (level), referenceData.data(),
+                                  fieldSize (level), level.hx * level.hy));
+  }
+
+  auto rate = [](double coarse, double fine) -> double {
+    return (coarse > 0 && fine > 0) ? std::log2 (coarse / fine) : 0;
+  };
+
+  tableStream << "# " << fieldName << " error against the "
+              << ((reference == "analytic") ? "analytic solution" : "next finer level") << std::endl;
+  tableStream << "# M\tN\tL1\t\trate\tL2\t\trate\tLInf\t\trate";
+  if (reference == "finest")
+    tableStream << "\tL2 (Richardson)";
+  tableStream << std::endl;
+
+  for (int l = 0; l < nErrors; ++l) {
+    tableStream << levels[l].M << "\t" << levels[l].N << std::scientific << std::setprecision (4);
+
+    double norms[3] = {errors[l].l1, errors[l].l2, errors[l].lInf};
+    for (int n = 0; n < 3; ++n) {
+      tableStream << "\t" << norms[n] << "\t";
+      if (l == 0) {
+        tableStream << "-";
+      } else {
+        double previousNorms[3] = {errors[l - 1].l1, errors[l - 1].l2, errors[l - 1].lInf};
+        tableStream << std::fixed << std::setprecision (2) << rate (previousNorms[n], norms[n])
+                    << std::scientific << std::setprecision (4);
+      }
+    }
+
+    if (reference == "finest") {
+      // Against the next finer level, e ~ C h^p (1 - 2^-p); Richardson
+      // extrapolation with the observed order p recovers the error against
+      // the exact solution.
+      double p = (l + 1 < nErrors) ? rate (errors[l].l2, errors[l + 1].l2) :
+                 (l > 0)           ? rate (errors[l - 1].l2, errors[l].l2) : 0;
+      if (p > 0)
+        tableStream << "\t" << errors[l].l2 * pow (2, p) / (pow (2, p) - 1);
+      else
+        tableStream << "\t-";
+    }
+    tableStream << std::defaultfloat << std::endl;
+  }
+  tableStream << std::endl;
+}
+
+void ConvergenceStudy::writeTable (std::ostream &tableStream) {
+  writeFieldTable (tableStream, "UVelocity", 0);
+  writeFieldTable (tableStream, "VVelocity", 1);
+  writeFieldTable (tableStream, "Pressure",  2);
+  // There is no analytic temperature solution for the benchmark problems.
+  if (reference == "finest")
+    writeFieldTable (tableStream, "Temperature", 3);
+}
+
+void ConvergenceStudy::writeTable() {
+  boost::system::error_code ec;
+  boost::filesystem::create_directories (outputPath, ec);
+  if (ec) {
+    THROW_WITH_TRACE(RuntimeError() <<
+            errmsg_info("Couldn't create directory '" + outputPath + "'."));
+  }
+
+  std::string tableFile = outputPath + "/" + outputFilename + "-convergence.txt";
+  std::ofstream tableStream (tableFile);
+  writeTable (tableStream);
+  writeTable (std::cout);
+
+  std::cout << "<Wrote convergence table to \"" << tableFile << "\">" << std::endl;
+}
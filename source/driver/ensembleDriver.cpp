@@ -0,0 +1,116 @@
+#include <iostream>
+#include <memory>
+
+#include "debug/exception.h"
+#include "geometry/geometry.h"
+#include "problem/problem.h"
+#include "output/output.h"
+#include "params/paramParser.h"
+#include "driver/batchDriver.h"
+#include "driver/ensembleDriver.h"
+#include "params.h"
+
+/// The state of a single ensemble member
+struct EnsembleMember {
+  EnsembleMember (Params &p, const std::string &label) :
+      label    (label),
+      params   (p),
+      geometry (params),
+      problem  (params, geometry),
+      output   (params, geometry, problem) {}
+
+  std::string       label;
+  Params            params;
+  GeometryStructure geometry;
+  ProblemStructure  problem;
+  OutputStructure   output;
+};
+
+// Solve the Stokes equations of every member in one batched solve.
+static void solveStokes (const std::vector<EnsembleMember *> &members) {
+  std::vector<ProblemStructure *> problems;
+  for (auto member : members)
+    problems.push_back (&member->problem);
+
+  ProblemStructure::solveStokes (problems);
+}
+
+EnsembleDriver::EnsembleDriver() {}
+
+void EnsembleDriver::load (const std::string manifestFile) {
+  BatchDriver batch;
+  batch.load (manifestFile);
+  members = batch.getRuns();
+}
+
+void EnsembleDriver::parse (std::istream &manifestStream) {
+  BatchDriver batch;
+  batch.parse (manifestStream);
+  members = batch.getRuns();
+}
+
+const std::vector<BatchDriver::BatchRun> &EnsembleDriver::getMembers() {
+  return members;
+}
+
+void EnsembleDriver::run() {
+  if (members.empty()) {
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("The ensemble manifest lists no members."));
+  }
+
+  std::vector<std::unique_ptr<EnsembleMember> > ensemble;
+  for (auto &member : members) {
+    ParamParser pp;
+    pp.load (member.paramFile);
+    Params &params = pp.getParams();
+    BatchDriver::applyOverrides (member, params);
+
+    ensemble.push_back (std::unique_ptr<EnsembleMember> (new EnsembleMember (params, member.label)));
+    ensemble.back()->problem.initializeProblem();
+
+    // Every member uses the Stokes system, and solver, of the first.
+    if (ensemble.size() > 1)
+      ensemble.back()->problem.shareStokesSystem (ensemble.front()->problem);
+  }
+
+  std::cout << "<Running an ensemble of " << ensemble.size() << " members>" << std::endl;
+
+  std::vector<EnsembleMember *> active;
+  for (auto &member : ensemble)
+    active.push_back (member.get());
+
+  // The main loop of runTimestepLoop(), with the Stokes solves of all
+  // members due one gathered into a single solve.
+  while (!active.empty()) {
+    std::vector<EnsembleMember *> solving;
+    for (auto member : active) {
+      if (member->problem.stokesSolveRequired()) {
+        member->problem.updateForcingTerms();
+        solving.push_back (member);
+      }
+    }
+    solveStokes (solving);
+
+    for (auto member : active) {
+      member->problem.recalculateTimestep();
+      member->output.outputData (member->problem.getTimestepNumber());
+      member->problem.solveAdvectionDiffusion();
+      std::cout << "<" << member->label << "> Timestep: " << member->problem.getTimestepNumber()
+                << ": t=" << member->problem.getTime() << std::endl;
+    }
+
+    std::vector<EnsembleMember *> running, finished;
+    for (auto member : active)
+      (member->problem.advanceTimestep() ? running : finished).push_back (member);
+
+    // Finished members end with a final Stokes solve, as in runTimestepLoop().
+    for (auto member : finished)
+      member->problem.updateForcingTerms();
+    solveStokes (finished);
+    for (auto member : finished)
+      member->output.outputData (member->problem.getTimestepNumber());
+
+    active.swap (running);
+  }
+}
@@ -0,0 +1,49 @@
+#include <iostream>
+
+#include "geometry/geometry.h"
+#include "problem/problem.h"
+#include "output/output.h"
+#include "driver/simulation.h"
+#include "params.h"
+
+void runSimulation (Params &params) {
+  // Initialize geometry parameters.
+  GeometryStructure geometry (params);
+  ProblemStructure  problem  (params, geometry);
+  // Initialize parameters related to output structure.
+  OutputStructure   output   (params, geometry, problem);
+
+  // Initialize the initial data for the problem to be solved.
+  problem.initializeProblem();
+
+  runTimestepLoop (problem, output);
+}
+
+void runTimestepLoop (ProblemStructure &problem, OutputStructure &output) {
+  // Main loop where computations are made and data is output for each timestep of the problem.
+  do {
+    // 1-2. Update the forcing terms and solve the Stokes equations, unless
+    //      the current velocity is being reused for several
+    //      advection-diffusion substeps.
+    if (problem.stokesSolveRequired()) {
+      problem.updateForcingTerms();
+      problem.solveStokes();
+    }
+    // 3. Recalculate time step.
+    problem.recalculateTimestep();
+    // 4. Output the solution data.
+    output.outputData (problem.getTimestepNumber());
+    // 5. Solve advection-diffusion equation.
+    problem.solveAdvectionDiffusion();
+    // 6. Output which time step is being computed.
+    if (Decomposition::isRootProcess())
+      std::cout << "Timestep: " << problem.getTimestepNumber() << ": t=" << problem.getTime() << std::endl;
+  } while (problem.advanceTimestep()); // Loop termination criterion: problem.getTimestepNumber() = end_timestep.
+
+  // Update forcing terms
+  problem.updateForcingTerms();
+  // Solve the Stokes equations.
+  problem.solveStokes();
+  // Output the solution data.
+  output.outputData (problem.getTimestepNumber());
+}
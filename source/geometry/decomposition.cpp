@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <vector>
+
+#include "debug/exception.h"
+#include "geometry/decomposition.h"
+
+using namespace std;
+
+#ifdef USE_MPI
+// The MPI datatype of Real.
+static MPI_Datatype realType() {
+  return (sizeof (Real) == sizeof (float)) ? MPI_FLOAT : MPI_DOUBLE;
+}
+
+// Whether MPI is up, so that unit tests and non-MPI drivers run serially.
+static bool mpiRunning() {
+  int initialized, finalized;
+  MPI_Initialized (&initialized);
+  MPI_Finalized (&finalized);
+  return initialized && !finalized;
+}
+#endif
+
+Decomposition::Decomposition() :
+    M (0),
+    N (0),
+    rank (0),
+    size (1),
+    rowBlocks (1),
+    colBlocks (1),
+    rowBegin (0),
+    rowEnd (0),
+    colBegin (0),
+    colEnd (0),
+    halo (0),
+    uBegin (0),
+    uEnd (0),
+    vBegin (0),
+    vEnd (0) {
+  fill (neighbors, neighbors + 4, -1);
+}
+
+void Decomposition::setup (const GridIndex M, const GridIndex N) {
+  this->M = M;
+  this->N = N;
+
+  rank = 0;
+  size = 1;
+  #ifdef USE_MPI
+  if (mpiRunning()) {
+    MPI_Comm_rank (MPI_COMM_WORLD, &rank);
+    MPI_Comm_size (MPI_COMM_WORLD, &size);
+  }
+  #endif
+
+  // Near-square blocks, with more of them along the longer side.
+  int dims[2] = {0, 0};
+  #ifdef USE_MPI
+  if (size > 1)
+    MPI_Dims_create (size, 2, dims);
+  else
+  #endif
+    dims[0] = dims[1] = 1;
+  rowBlocks = (M >= N) ? dims[0] : dims[1];
+  colBlocks = (M >= N) ? dims[1] : dims[0];
+
+  if (rowBlocks > M || colBlocks > N)
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("The grid is too small to give every process a block."));
+
+  const int blockRow = rank / colBlocks, blockCol = rank % colBlocks;
+  blockRange (M, rowBlocks, blockRow, rowBegin, rowEnd);
+  blockRange (N, colBlocks, blockCol, colBegin, colEnd);
+
+  neighbors[lower] = (blockRow > 0)             ? rank - colBlocks : -1;
+  neighbors[upper] = (blockRow < rowBlocks - 1) ? rank + colBlocks : -1;
+  neighbors[left]  = (blockCol > 0)             ? rank - 1         : -1;
+  neighbors[right] = (blockCol < colBlocks - 1) ? rank + 1         : -1;
+
+  // The faces between a block and its neighbors are stored by both.
+  halo   = (size > 1) ? 1 : 0;
+  uBegin = max (colBegin - 1, GridIndex (0));
+  uEnd   = min (colEnd, N - 1);
+  vBegin = max (rowBegin - 1, GridIndex (0));
+  vEnd   = min (rowEnd, M - 1);
+
+  for (int d = 0; d < 4; ++d) {
+    GridIndex length = (d == lower || d == upper) ? colEnd - colBegin : rowEnd - rowBegin;
+    sendBuffers[d].resize (neighbors[d] >= 0 ? length : 0);
+    receiveBuffers[d].resize (neighbors[d] >= 0 ? length : 0);
+  }
+  gatherBuffer.resize ((size > 1 && rank == 0) ? M * N : 0);
+}
+
+bool Decomposition::isDistributed() {
+  return size > 1;
+}
+
+int Decomposition::getRank() {
+  return rank;
+}
+
+int Decomposition::getSize() {
+  return size;
+}
+
+GridIndex Decomposition::getRowBegin() {
+  return rowBegin;
+}
+
+GridIndex Decomposition::getRowEnd() {
+  return rowEnd;
+}
+
+GridIndex Decomposition::getColBegin() {
+  return colBegin;
+}
+
+GridIndex Decomposition::getColEnd() {
+  return colEnd;
+}
+
+GridIndex Decomposition::getCellCount() {
+  return (rowEnd - rowBegin + 2 * halo) * (colEnd - colBegin + 2 * halo);
+}
+
+GridIndex Decomposition::getUFaceCount() {
+  return (rowEnd - rowBegin) * (uEnd - uBegin);
+}
+
+GridIndex Decomposition::getVFaceCount() {
+  return (vEnd - vBegin) * (colEnd - colBegin);
+}
+
+void Decomposition::beginHaloExchange (Real * block) {
+  #ifdef USE_MPI
+  if (!isDistributed())
+    return;
+
+  // A message travelling in direction d is tagged d, so the halo from the
+  // neighbor in direction d arrives with the opposite tag (d ^ 1).
+  requestCount = 0;
+  for (int d = 0; d < 4; ++d) {
+    if (neighbors[d] < 0)
+      continue;
+
+    MPI_Irecv (receiveBuffers[d].data(), int (receiveBuffers[d].size()), realType(),
+               neighbors[d], d ^ 1, MPI_COMM_WORLD, &requests[requestCount++]);
+
+    packEdge (d, block, sendBuffers[d].data());
+    MPI_Isend (sendBuffers[d].data(), int (sendBuffers[d].size()), realType(),
+               neighbors[d], d, MPI_COMM_WORLD, &requests[requestCount++]);
+  }
+  #endif
+}
+
+void Decomposition::endHaloExchange (Real * block) {
+  #ifdef USE_MPI
+  if (!isDistributed())
+    return;
+
+  MPI_Waitall (requestCount, requests, MPI_STATUSES_IGNORE);
+
+  for (int d = 0; d < 4; ++d)
+    if (neighbors[d] >= 0)
+      unpackHalo (d, receiveBuffers[d].data(), block);
+  #endif
+}
+
+void Decomposition::gather (const Real * block, Real * field) {
+  if (!isDistributed()) {
+    if (field != block)
+      copy (block, block + M * N, field);
+    return;
+  }
+
+  #ifdef USE_MPI
+  // Blocks are sent packed row by row, and unpacked in rank order. MPI
+  // counts and displacements are int, which limits the grid to 2^31 cells.
+  vector<int> counts (size), offsets (size);
+  for (int r = 0, offset = 0; r < size; ++r) {
+    GridIndex r0, r1, c0, c1;
+    blockExtent (r, r0, r1, c0, c1);
+    counts[r]  = int ((r1 - r0) * (c1 - c0));
+    offsets[r] = offset;
+    offset    += counts[r];
+  }
+
+  vector<Real> packed (counts[rank]);
+  GridIndex k = 0;
+  for (GridIndex i = rowBegin; i < rowEnd; ++i)
+    for (GridIndex j = colBegin; j < colEnd; ++j)
+      packed[k++] = block[cell (i, j)];
+
+  MPI_Gatherv (packed.data(), counts[rank], realType(),
+               gatherBuffer.data(), counts.data(), offsets.data(), realType(),
+               0, MPI_COMM_WORLD);
+
+  if (rank != 0)
+    return;
+
+  for (int r = 0; r < size; ++r) {
+    GridIndex r0, r1, c0, c1;
+    blockExtent (r, r0, r1, c0, c1);
+
+    const Real * source = gatherBuffer.data() + offsets[r];
+    for (GridIndex i = r0; i < r1; ++i)
+      for (GridIndex j = c0; j < c1; ++j)
+        field[i * N + j] = *source++;
+  }
+  #endif
+}
+
+void Decomposition::scatterFaces (const double * u, const double * v, double * blockU, double * blockV) {
+  if (!isDistributed()) {
+    if (blockU != u)
+      copy (u, u + M * (N - 1), blockU);
+    if (blockV != v)
+      copy (v, v + (M - 1) * N, blockV);
+    return;
+  }
+
+  #ifdef USE_MPI
+  // The first process packs every block's u faces, then every block's v
+  // faces, and sends each process its two ranges.
+  vector<int> uCounts (size), uOffsets (size), vCounts (size), vOffsets (size);
+  vector<double> packed;
+  int offset = 0;
+  for (int r = 0; r < size; ++r) {
+    GridIndex r0, r1, c0, c1;
+    blockExtent (r, r0, r1, c0, c1);
+    const GridIndex u0 = max (c0 - 1, GridIndex (0)), u1 = min (c1, N - 1);
+
+    uCounts[r]  = int ((r1 - r0) * (u1 - u0));
+    uOffsets[r] = offset;
+    offset     += uCounts[r];
+    if (rank == 0)
+      for (GridIndex i = r0; i < r1; ++i)
+        packed.insert (packed.end(), u + i * (N - 1) + u0, u + i * (N - 1) + u1);
+  }
+  for (int r = 0; r < size; ++r) {
+    GridIndex r0, r1, c0, c1;
+    blockExtent (r, r0, r1, c0, c1);
+    const GridIndex v0 = max (r0 - 1, GridIndex (0)), v1 = min (r1, M - 1);
+
+    vCounts[r]  = int ((v1 - v0) * (c1 - c0));
+    vOffsets[r] = offset;
+    offset     += vCounts[r];
+    if (rank == 0)
+      for (GridIndex i = v0; i < v1; ++i)
+        packed.insert (packed.end(), v + i * N + c0, v + i * N + c1);
+  }
+
+  MPI_Scatterv (packed.data(), uCounts.data(), uOffsets.data(), MPI_DOUBLE,
+                blockU, uCounts[rank], MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  MPI_Scatterv (packed.data(), vCounts.data(), vOffsets.data(), MPI_DOUBLE,
+                blockV, vCounts[rank], MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  #endif
+}
+
+void Decomposition::broadcast (int &value) {
+  #ifdef USE_MPI
+  if (isDistributed())
+    MPI_Bcast (&value, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  #endif
+}
+
+double Decomposition::maxAll (const double value) {
+  double result = value;
+  #ifdef USE_MPI
+  if (isDistributed())
+    MPI_Allreduce (&value, &result, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  #endif
+  return result;
+}
+
+bool Decomposition::isRootProcess() {
+  int rank = 0;
+  #ifdef USE_MPI
+  if (mpiRunning())
+    MPI_Comm_rank (MPI_COMM_WORLD, &rank);
+  #endif
+  return rank == 0;
+}
+
+void Decomposition::blockRange (const GridIndex n, const int blocks, const int block,
+                                GridIndex &begin, GridIndex &end) {
+  begin = (std::int64_t (n) * block) / blocks;
+  end   = (std::int64_t (n) * (block + 1)) / blocks;
+}
+
+void Decomposition::blockExtent (const int r, GridIndex &r0, GridIndex &r1, GridIndex &c0, GridIndex &c1) {
+  blockRange (M, rowBlocks, r / colBlocks, r0, r1);
+  blockRange (N, colBlocks, r % colBlocks, c0, c1);
+}
+
+void Decomposition::packEdge (const int direction, const Real * block, Real * buffer) {
+  switch (direction) {
+    case lower:
+    case upper: {
+      const Real * row = block + cell ((direction == lower) ? rowBegin : rowEnd - 1, colBegin);
+      copy (row, row + (colEnd - colBegin), buffer);
+      break;
+    }
+    case left:
+    case right: {
+      const GridIndex j = (direction == left) ? colBegin : colEnd - 1;
+      for (GridIndex i = rowBegin; i < rowEnd; ++i)
+        *buffer++ = block[cell (i, j)];
+      break;
+    }
+  }
+}
+
+void Decomposition::unpackHalo (const int direction, const Real * buffer, Real * block) {
+  switch (direction) {
+    case lower:
+    case upper: {
+      Real * row = block + cell ((direction == lower) ? rowBegin - 1 : rowEnd, colBegin);
+      copy (buffer, buffer + (colEnd - colBegin), row);
+      break;
+    }
+    case left:
+    case right: {
+      const GridIndex j = (direction == left) ? colBegin - 1 : colEnd;
+      for (GridIndex i = rowBegin; i < rowEnd; ++i)
+        block[cell (i, j)] = *buffer++;
+      break;
+    }
+  }
+}
@@ -1,3 +1,5 @@
+#include <utility>
+
 #include "geometry/geometry.h"
 #include "params.h"
 
@@ -11,14 +13,17 @@
  *  ------------------ | --------- | ---- | -----------
  *  geometryParams | M | int | The number of rows in the underlying representation of the problem domain (*required*)
  *  geometryParams | N | int | The number of columns in the underlying representation of the problem domain (*required*)
+ *  geometryParams | compositionFields | int | The number of advected compositional fields (*default 0*)
  */
 GeometryStructure::GeometryStructure (Params &params) {
   // Grab the parameters from the required 'geometryParams' section
   params.push("geometryParams"); {
     // Read the number of rows (M)
-    params.getParam<int>("M", M);
+    params.getParam<GridIndex>("M", M);
     // Read the number of columns (N)
-    params.getParam<int>("N", N);
+    params.getParam<GridIndex>("N", N);
+    // Read the number of compositional fields (K)
+    params.queryParam<int>("compositionFields", K, 0);
 
     params.pop();
   }
@@ -42,17 +47,37 @@ GeometryStructure::GeometryStructure (Params &params) {
                              \----------------------------------------------------------------------/
       @endverbatim
    */
-  stokesData = new double[M * (N - 1) + (M - 1) * N + M * N];
+  decomposition.setup (M, N);
+
+  /** In a run distributed over several MPI processes (see Decomposition)
+   *  every process stores only its block of the temperature and the
+   *  velocities on the faces of its cells. The Stokes solution, the forcing
+   *  and the gathered temperature are stored on the first process alone,
+   *  which solves the Stokes system and writes the output. The viscosity
+   *  and the boundary values are small enough to be kept everywhere.
+   */
+  const bool distributed = decomposition.isDistributed();
+  const bool root        = (decomposition.getRank() == 0);
+
+  stokesData = root ? new double[M * (N - 1) + (M - 1) * N + M * N] : NULL;
 
   velocityBoundaryData = new double[M *  2 + 2 * N];
 
-  forcingData = new double[M * (N - 1) + (M - 1) * N];
+  forcingData = root ? new double[M * (N - 1) + (M - 1) * N] : NULL;
 
   viscosityData = new double[(M + 1) * (N + 1)];
 
-  temperatureData = new double[M * N];
+  temperatureData = new Real[decomposition.getCellCount()];
+  temperatureBackData = new Real[decomposition.getCellCount()];
+  gatheredTemperatureData = (distributed && root) ? new Real[M * N] : NULL;
+  blockVelocityData = distributed ?
+                      new double[decomposition.getUFaceCount() + decomposition.getVFaceCount()] :
+                      NULL;
+
+  compositionData = new Real[M * N * K];
+  compositionBackData = new Real[M * N * K];
 
-  temperatureBoundaryData = new double[M * 2 + 2 * N];
+  temperatureBoundaryData = new Real[M * 2 + 2 * N];
 }
 
 /** @brief Deconstructs the GeometryStructure by deallocating all managed
@@ -64,19 +89,29 @@ GeometryStructure::~GeometryStructure() {
   delete[] forcingData;
   delete[] viscosityData;
   delete[] temperatureData;
+  delete[] temperatureBackData;
+  delete[] gatheredTemperatureData;
+  delete[] blockVelocityData;
+  delete[] compositionData;
+  delete[] compositionBackData;
   delete[] temperatureBoundaryData;
 }
 
 /// @brief Returns the number of rows in the problem domain
-int GeometryStructure::getM() {
+GridIndex GeometryStructure::getM() {
   return M;
 }
 
 /// @brief Returns the number of columns in the problem domain
-int GeometryStructure::getN() {
+GridIndex GeometryStructure::getN() {
   return N;
 }
 
+/// @brief Returns the number of compositional fields
+int GeometryStructure::getK() {
+  return K;
+}
+
 /** @brief Returns a pointer to the Stokes data
  *
  *  The **stokesData** variable contains the pointer to the U/V directional
@@ -101,6 +136,9 @@ int GeometryStructure::getN() {
     | U VELOCITY  | V VELOCITY  | PRESSURE |
     +-------------+-------------+----------+
     @endverbatim
+ *
+ *  In a distributed run the Stokes data is only stored on the first
+ *  process, and this and the pointers into it are NULL on the others.
  */
 double * GeometryStructure::getStokesData() {
   return stokesData;
@@ -118,12 +156,36 @@ double * GeometryStructure::getUVelocityData() {
 
 /// Returns a pointer to the v-directional velocity region of the Stokes data
 double * GeometryStructure::getVVelocityData() {
-  return stokesData + M * (N - 1);
+  return stokesData ? stokesData + M * (N - 1) : NULL;
 }
 
 /// Returns a pointer to the pressure region of the Stokes data
 double * GeometryStructure::getPressureData() {
-  return stokesData + M * (N - 1) + (M - 1) * N;
+  return stokesData ? stokesData + M * (N - 1) + (M - 1) * N : NULL;
+}
+
+/** @brief Returns a pointer to this process' block of the u-directional
+ *         velocity.
+ *
+ *  The faces are laid out as described by Decomposition::uFace(). Without
+ *  a distributed run this is the u-directional velocity region of the
+ *  Stokes data.
+ */
+double * GeometryStructure::getBlockUVelocityData() {
+  return blockVelocityData ? blockVelocityData : getUVelocityData();
+}
+
+/** @brief Returns a pointer to this process' block of the v-directional
+ *         velocity.
+ *
+ *  The faces are laid out as described by Decomposition::vFace(). Without
+ *  a distributed run this is the v-directional velocity region of the
+ *  Stokes data.
+ */
+double * GeometryStructure::getBlockVVelocityData() {
+  return blockVelocityData ?
+         blockVelocityData + decomposition.getUFaceCount() :
+         getVVelocityData();
 }
 
 /** @brief Returns a pointer to the domain-boundary velocity data.
@@ -195,6 +257,9 @@ double * GeometryStructure::getVVelocityBoundaryData() {
     |  U FORCING  |  V FORCING  |
     +-------------+-------------+
     @endverbatim
+ *
+ *  Like the Stokes data, it is only stored on the first process of a
+ *  distributed run.
  */
 double * GeometryStructure::getForcingData() {
   return forcingData;
@@ -215,7 +280,7 @@ double * GeometryStructure::getUForcingData() {
  *  data pointer.
  */
 double * GeometryStructure::getVForcingData() {
-  return forcingData + M * (N - 1);
+  return forcingData ? forcingData + M * (N - 1) : NULL;
 }
 
 /** @brief Returns a pointer to the viscosity data.
@@ -269,11 +334,74 @@ double * GeometryStructure::getViscosityData() {
     | TEMPERATURE |
     +-------------+
     @endverbatim
+ *
+ *  In a distributed run this is only the process' block and its halo,
+ *  laid out as described by Decomposition::cell(); the whole field is
+ *  gathered with ProblemStructure::gatherTemperature().
  */
-double * GeometryStructure::getTemperatureData() {
+Real * GeometryStructure::getTemperatureData() {
   return temperatureData;
 }
 
+/** @brief Returns a pointer to the temperature back buffer.
+ *
+ *  The back buffer has the same layout as the temperature data. Transport
+ *  stages read the current temperature from getTemperatureData(), write the
+ *  updated temperature into the back buffer, and then call
+ *  swapTemperatureBuffers() to make it current. Its contents are undefined
+ *  between stages.
+ */
+Real * GeometryStructure::getTemperatureBackData() {
+  return temperatureBackData;
+}
+
+/** @brief Exchanges the temperature data and temperature back buffer.
+ *
+ *  Only the pointers are exchanged, so pointers previously returned by
+ *  getTemperatureData() refer to the back buffer afterwards.
+ */
+void GeometryStructure::swapTemperatureBuffers() {
+  std::swap (temperatureData, temperatureBackData);
+}
+
+/** @brief Returns a pointer to the whole temperature data.
+ *
+ *  In a distributed run this is a separate MxN array, filled by
+ *  ProblemStructure::gatherTemperature() on the first process and NULL on
+ *  the others. Otherwise it is the temperature data itself.
+ */
+Real * GeometryStructure::getGatheredTemperatureData() {
+  return decomposition.isDistributed() ? gatheredTemperatureData : temperatureData;
+}
+
+/** @brief Returns a pointer to the compositional field data.
+ *
+ *  The **compositionData** variable contains the K compositional fields,
+ *  which are cell-centered like the temperature. The fields are interleaved
+ *  so that the values of all fields in a cell are contiguous, letting the
+ *  advection kernels apply each face's flux to every field in one pass:
+ *
+ *  @verbatim
+      K           K                 K
+    +-----------+-----------+     +-------------------+
+    | CELL(0,0) | CELL(0,1) | ... | CELL(M - 1,N - 1) |
+    +-----------+-----------+     +-------------------+
+    @endverbatim
+ */
+Real * GeometryStructure::getCompositionData() {
+  return compositionData;
+}
+
+/// @brief Returns a pointer to the compositional field back buffer.
+Real * GeometryStructure::getCompositionBackData() {
+  return compositionBackData;
+}
+
+/// @brief Exchanges the compositional field data and back buffer.
+void GeometryStructure::swapCompositionBuffers() {
+  std::swap (compositionData, compositionBackData);
+}
+
 /** @brief Returns a pointer to the domain-boundary temperature data.
  *
  *  The **temperatureBoundaryData** member variable contains the pointer to the
@@ -292,7 +420,7 @@ double * GeometryStructure::getTemperatureData() {
         t   t   t   t
     @endverbatim
  */
-double * GeometryStructure::getTemperatureBoundaryData() {
+Real * GeometryStructure::getTemperatureBoundaryData() {
   return temperatureBoundaryData;
 }
 
@@ -301,7 +429,7 @@ double * GeometryStructure::getTemperatureBoundaryData() {
  *  The pointer is calculated using an offset of \f$0\f$ from the temperature
  *  boundary data pointer.
  */
-double * GeometryStructure::getUTemperatureBoundaryData() {
+Real * GeometryStructure::getUTemperatureBoundaryData() {
   return temperatureBoundaryData;
 }
 
@@ -310,6 +438,14 @@ double * GeometryStructure::getUTemperatureBoundaryData() {
  *  The pointer is calculated using an offset of \f$2 * M\f$ from the
  *  temperature boundary data pointer.
  */
-double * GeometryStructure::getVTemperatureBoundaryData() {
+Real * GeometryStructure::getVTemperatureBoundaryData() {
   return temperatureBoundaryData + M * 2;
 }
+
+/** @brief Returns the block decomposition of the cell grid.
+ *
+ *  Without MPI, or on a single process, the only block is the whole grid.
+ */
+Decomposition &GeometryStructure::getDecomposition() {
+  return decomposition;
+}
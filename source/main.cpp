@@ -1,29 +1,121 @@
 // Necessary for output in the command line.
 #include <iostream>
+#include <cstdlib>
 
 // Necessary for displaying exception information
 #include <boost/exception/diagnostic_information.hpp>
+#include <boost/lexical_cast.hpp>
+
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+#ifdef USE_PETSC
+#include <petscsys.h>
+#endif
 
 // Exceptions and related typedefs
 #include "debug/exception.h"
-// Functions and data structures related to the geometry of the problem.
-#include "geometry/geometry.h"
-// Functions and data structures related to the implementation of numerical methods.
-#include "problem/problem.h"
-// Functions and data structures related to the output of the solution data.
-#include "output/output.h"
+// Functions related to running a single simulation.
+#include "driver/simulation.h"
+// Functions and data structures related to running batches of simulations.
+#include "driver/batchDriver.h"
+// Functions and data structures related to running ensembles in lockstep.
+#include "driver/ensembleDriver.h"
+// Functions and data structures related to running convergence studies.
+#include "driver/convergenceStudy.h"
 // Functions and data structures related to the parser of parameter files.
 #include "params/paramParser.h"
 
+#ifdef USE_MPI
+// Keeps MPI initialized for the lifetime of main().
+struct MPISession {
+  MPISession (int &argc, char ** &argv) { MPI_Init (&argc, &argv); }
+  ~MPISession() { MPI_Finalize(); }
+};
+#endif
+
+#ifdef USE_PETSC
+// Keeps PETSc initialized for the lifetime of main(). Its options (e.g.
+// -stokes_ksp_monitor) are read from the command line.
+struct PetscSession {
+  PetscSession (int &argc, char ** &argv) { PetscInitialize (&argc, &argv, NULL, NULL); }
+  ~PetscSession() { PetscFinalize(); }
+};
+#endif
+
 int main(int argc, char ** argv) {
   // Install the segfault handler with backtrace
   signal(SIGSEGV, handler);
 
+  #ifdef USE_MPI
+  MPISession mpi (argc, argv);
+  int processes;
+  MPI_Comm_size (MPI_COMM_WORLD, &processes);
+  #endif
+  #ifdef USE_PETSC
+  PetscSession petsc (argc, argv);
+  #endif
+
   try {
-    // The valid command line usage is "./mc-mini <parameter file>". Otherwise, throw an exception.
+    // The valid command line usages are "./mc-mini <parameter file>",
+    // "./mc-mini --batch <manifest file> [--threads <n>]",
+    // "./mc-mini --ensemble <manifest file>" and
+    // "./mc-mini --convergence <parameter file>". Otherwise, throw an exception.
     if (argc == 1) {
       THROW_WITH_TRACE(InvalidArgument() <<
-              errmsg_info("usage: " + static_cast<std::string>(argv[0]) + " <parameter file>."));
+              errmsg_info("usage: " + static_cast<std::string>(argv[0]) + " <parameter file> | " +
+                          "--batch <manifest file> [--threads <n>] | --ensemble <manifest file> | " +
+                          "--convergence <parameter file>."));
+    }
+
+    #ifdef USE_MPI
+    // Only single simulations are decomposed over the processes.
+    if (processes > 1 && static_cast<std::string>(argv[1]).compare (0, 2, "--") == 0) {
+      THROW_WITH_TRACE(InvalidArgument() <<
+              errmsg_info("'" + static_cast<std::string>(argv[1]) + "' runs on a single MPI process only."));
+    }
+    #endif
+
+    if (static_cast<std::string>(argv[1]) == "--convergence") {
+      if (argc != 3) {
+        THROW_WITH_TRACE(InvalidArgument() <<
+                errmsg_info("usage: " + static_cast<std::string>(argv[0]) + " --convergence <parameter file>."));
+      }
+
+      // Run the refinement ladder and tabulate the errors in-process.
+      ConvergenceStudy study (static_cast<std::string>(argv[2]));
+      study.run();
+      study.writeTable();
+
+      return EXIT_SUCCESS;
+    }
+
+    if (static_cast<std::string>(argv[1]) == "--batch") {
+      if (argc != 3 && !(argc == 5 && static_cast<std::string>(argv[3]) == "--threads")) {
+        THROW_WITH_TRACE(InvalidArgument() <<
+                errmsg_info("usage: " + static_cast<std::string>(argv[0]) + " --batch <manifest file> [--threads <n>]."));
+      }
+
+      // Run every entry of the manifest on a pool of worker threads.
+      BatchDriver batch ((argc == 5) ? boost::lexical_cast<unsigned int>(argv[4]) : 0);
+      batch.load (static_cast<std::string>(argv[2]));
+
+      return (batch.run() == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (static_cast<std::string>(argv[1]) == "--ensemble") {
+      if (argc != 3) {
+        THROW_WITH_TRACE(InvalidArgument() <<
+                errmsg_info("usage: " + static_cast<std::string>(argv[0]) + " --ensemble <manifest file>."));
+      }
+
+      // Advance every entry of the manifest in lockstep on one Stokes factorization.
+      EnsembleDriver ensemble;
+      ensemble.load (static_cast<std::string>(argv[2]));
+      ensemble.run();
+
+      return EXIT_SUCCESS;
     }
 
     // Initialize the parser with the specified parameter file.
@@ -33,37 +125,8 @@ int main(int argc, char ** argv) {
     // Get the parameter values from the parser
     Params params = pp.getParams();
 
-    // Initialize geometry parameters.
-    GeometryStructure geometry (params);
-    ProblemStructure  problem  (params, geometry);
-    // Initialize parameters related to output structure.
-    OutputStructure   output   (params, geometry, problem);
-
-    // Initialize the initial data for the problem to be solved.
-    problem.initializeProblem();
-
-    // Main loop where computations are made and data is output for each timestep of the problem.
-    do {
-      // 1. Solve Stokes equations.
-      problem.solveStokes();
-      // 2. Initialize the right hand side (forcing terms).
-      problem.updateForcingTerms();
-      // 3. Recalculate time step.
-      problem.recalculateTimestep();
-      // 4. Output the solution data.
-      output.outputData (problem.getTimestepNumber());
-      // 5. Solve advection-diffusion equation.
-      problem.solveAdvectionDiffusion();
-      // 6. Output which time step is being computed.
-      std::cout << "Timestep: " << problem.getTimestepNumber() << ": t=" << problem.getTime() << std::endl;
-    } while (problem.advanceTimestep()); // Loop termination criterion: problem.getTimestepNumber() = end_timestep.
-
-    // Solve the Stokes equations.
-    problem.solveStokes();
-    // Update forcing terms
-    problem.updateForcingTerms();
-    // Output the solution data.
-    output.outputData (problem.getTimestepNumber());
+    // Run the simulation described by the parameters.
+    runSimulation (params);
   } catch (std::exception& e) {
     std::cerr << boost::diagnostic_information(e);
   }
@@ -13,19 +13,20 @@ namespace DenseForms {
   void makeStokesMatrix (Ref<MatrixXd> stokesMatrix,
                          const int M,
                          const int N,
-                         const double h,
+                         const double hx,
+                         const double hy,
                          const double * viscosityData) {
     #ifdef DEBUG
       cout << "<Creating " << 3 * M * N - M - N << "x" << 3 * M * N - M - N << " stokesMatrix>" << endl << endl;
     #endif
     stokesMatrix = MatrixXd::Zero (3 * M * N - M - N, 3 * M * N - M - N);
 
-    makeLaplacianXBlock (stokesMatrix.block (0,                 0,                 M * (N - 1), M * (N - 1)), M, N, h, viscosityData);
-    makeLaplacianYBlock (stokesMatrix.block (M * (N - 1),       M * (N - 1),       (M - 1) * N, (M - 1) * N), M, N, h, viscosityData);
-    makeGradXBlock      (stokesMatrix.block (0,                 2 * M * N - M - N, M * (N - 1), M * N),       M, N, h);
-    makeGradYBlock      (stokesMatrix.block (M * (N - 1),       2 * M * N - M - N, (M - 1) * N, M * N),       M, N, h);
-    makeDivXBlock       (stokesMatrix.block (2 * M * N - M - N, 0,                  M * N,      M * (N - 1)), M, N, h);
-    makeDivYBlock       (stokesMatrix.block (2 * M * N - M - N, M * (N - 1),        M * N,      (M - 1) * N), M, N, h);
+    makeLaplacianXBlock (stokesMatrix.block (0,                 0,                 M * (N - 1), M * (N - 1)), M, N, hx, hy, viscosityData);
+    makeLaplacianYBlock (stokesMatrix.block (M * (N - 1),       M * (N - 1),       (M - 1) * N, (M - 1) * N), M, N, hx, hy, viscosityData);
+    makeGradXBlock      (stokesMatrix.block (0,                 2 * M * N - M - N, M * (N - 1), M * N),       M, N, hx);
+    makeGradYBlock      (stokesMatrix.block (M * (N - 1),       2 * M * N - M - N, (M - 1) * N, M * N),       M, N, hy);
+    makeDivXBlock       (stokesMatrix.block (2 * M * N - M - N, 0,                  M * N,      M * (N - 1)), M, N, hx);
+    makeDivYBlock       (stokesMatrix.block (2 * M * N - M - N, M * (N - 1),        M * N,      (M - 1) * N), M, N, hy);
   
     #ifdef DEBUG
       cout << endl;
@@ -35,7 +36,8 @@ namespace DenseForms {
   void makeLaplacianXBlock (Ref<MatrixXd> laplacian,
                             const int M,
                             const int N,
-                            const double h,
+                            const double hx,
+                            const double hy,
                             const double * viscosityData) {
     #ifdef DEBUG 
       cout << "<Creating " << M * (N - 1) << "x" << M * (N - 1) << " LaplacianXBlock>" << endl;
@@ -49,19 +51,19 @@ namespace DenseForms {
         // First and last rows are non-standard because the laplacian would sample points which
         // do not exist in our gridding.
         if (i == 0 || i == (M - 1))
-          laplacian (i * (N - 1) + j, i       * (N - 1) + j)       =  viscosity * 5 / (h * h);
+          laplacian (i * (N - 1) + j, i       * (N - 1) + j)       =  viscosity * (2 / (hx * hx) + 3 / (hy * hy));
         else
-          laplacian (i * (N - 1) + j, i       * (N - 1) + j)       =  viscosity * 4 / (h * h);
+          laplacian (i * (N - 1) + j, i       * (N - 1) + j)       =  viscosity * (2 / (hx * hx) + 2 / (hy * hy));
         // First and last rows are missing a neighbor in one of two directions
         if (i > 0)
-          laplacian (i * (N - 1) + j, (i - 1) * (N - 1) + j)       = -viscosity / (h * h);
+          laplacian (i * (N - 1) + j, (i - 1) * (N - 1) + j)       = -viscosity / (hy * hy);
         if (i < (M - 1))
-          laplacian (i * (N - 1) + j, (i + 1) * (N - 1) + j)       = -viscosity / (h * h);
+          laplacian (i * (N - 1) + j, (i + 1) * (N - 1) + j)       = -viscosity / (hy * hy);
         // First and last elements of each row are missing a neighbor in one of two directions
         if (j > 0)
-          laplacian (i * (N - 1) + j, i       * (N - 1) + (j - 1)) = -viscosity / (h * h);
+          laplacian (i * (N - 1) + j, i       * (N - 1) + (j - 1)) = -viscosity / (hx * hx);
         if (j < N - 2)
-          laplacian (i * (N - 1) + j, i       * (N - 1) + (j + 1)) = -viscosity / (h * h);
+          laplacian (i * (N - 1) + j, i       * (N - 1) + (j + 1)) = -viscosity / (hx * hx);
       }
     }
   }
@@ -69,7 +71,8 @@ namespace DenseForms {
   void makeLaplacianYBlock (Ref<MatrixXd> laplacian,
                             const int M,
                             const int N,
-                            const double h,
+                            const double hx,
+                            const double hy,
                             const double * viscosityData) {
     #ifdef DEBUG
       cout << "<Creating " << (M - 1) * N << "x" << (M - 1) * N << " LaplacianYBlock>" << endl;
@@ -83,21 +86,21 @@ namespace DenseForms {
         // The first and last elements of each row are non-standard because the four-point
         // laplacian relies upon points not included in our gridding
         if ((j == 0) || (j == (N - 1)))
-          laplacian (i * N + j, i       * N + j)       =  viscosity * 5 / (h * h);
+          laplacian (i * N + j, i       * N + j)       =  viscosity * (3 / (hx * hx) + 2 / (hy * hy));
         else
-          laplacian (i * N + j, i       * N + j)       =  viscosity * 4 / (h * h);
+          laplacian (i * N + j, i       * N + j)       =  viscosity * (2 / (hx * hx) + 2 / (hy * hy));
 
         // First and last elements of each row are missing a neighbor in one of two directions
         if (j > 0)
-          laplacian (i * N + j, i       * N + (j - 1)) = -viscosity / (h * h);
+          laplacian (i * N + j, i       * N + (j - 1)) = -viscosity / (hx * hx);
         if (j < (N - 1))
-          laplacian (i * N + j, i       * N + (j + 1)) = -viscosity / (h * h);
+          laplacian (i * N + j, i       * N + (j + 1)) = -viscosity / (hx * hx);
 
         // Elements of the first and last rows are missing a neighbor in one of two directions
         if (i > 0)
-          laplacian (i * N + j, (i - 1) * N + j)       = -viscosity / (h * h);
+          laplacian (i * N + j, (i - 1) * N + j)       = -viscosity / (hy * hy);
         if (i < (M - 2))
-          laplacian (i * N + j, (i + 1) * N + j)       = -viscosity / (h * h);
+          laplacian (i * N + j, (i + 1) * N + j)       = -viscosity / (hy * hy);
       }
     }
   }
@@ -105,15 +108,15 @@ namespace DenseForms {
   void makeGradXBlock (Ref<MatrixXd> grad,
                        const int M,
                        const int N,
-                       const double h) {
+                       const double hx) {
     #ifdef DEBUG
       cout << "<Creating " << M * (N - 1) << "x" << M * N << " GradXBLock>" << endl;
     #endif
     
     for (int i = 0; i < M; ++i) {
       for (int j = 0; j < (N - 1); ++j) {
-        grad (i * (N - 1) + j, i * N + j)       = -1 / h;
-        grad (i * (N - 1) + j, i * N + (j + 1)) =  1 / h;
+        grad (i * (N - 1) + j, i * N + j)       = -1 / hx;
+        grad (i * (N - 1) + j, i * N + (j + 1)) =  1 / hx;
       }
     }
   }
@@ -121,29 +124,29 @@ namespace DenseForms {
   void makeGradYBlock (Ref<MatrixXd> grad,
                        const int M,
                        const int N,
-                       const double h) {
+                       const double hy) {
     #ifdef DEBUG
       cout << "<Creating " << (M - 1) * N << "x" << M * N << " GradYBlock>" << endl;
     #endif
 
     for (int i = 0; i < (M - 1) * N; ++i) {
-      grad (i, i)     = -1 / h;
-      grad (i, i + N) =  1 / h;
+      grad (i, i)     = -1 / hy;
+      grad (i, i + N) =  1 / hy;
     }
   }
 
   void makeDivXBlock (Ref<MatrixXd> div,
                       const int M,
                       const int N,
-                      const double h) {
+                      const double hx) {
     #ifdef DEBUG
       cout << "<Creating " << M * N << "x" << M * (N - 1) << " DivXBLock>" << endl;
     #endif
 
     for (int i = 0; i < M; ++i) {
       for (int j = 0; j < (N - 1); ++j) {
-        div (i * N + j,       i * (N - 1) + j) =  1 / h;
-        div (i * N + (j + 1), i * (N - 1) + j) = -1 / h;
+        div (i * N + j,       i * (N - 1) + j) =  1 / hx;
+        div (i * N + (j + 1), i * (N - 1) + j) = -1 / hx;
       }
     }
   }
@@ -151,14 +154,14 @@ namespace DenseForms {
   void makeDivYBlock (Ref<MatrixXd> div,
                       const int M,
                       const int N,
-                      const double h) {
+                      const double hy) {
     #ifdef DEBUG 
       cout << "<Creating " << M * N << "x" << (M - 1) * N << " DivYBlock>" << endl;
     #endif
    
     for (int i = 0; i < (M - 1) * N; ++i) {
-      div (i,     i) =  1 / h;
-      div (i + N, i) = -1 / h;
+      div (i,     i) =  1 / hy;
+      div (i + N, i) = -1 / hy;
     }
   }
 
@@ -182,7 +185,8 @@ namespace DenseForms {
   void makeBoundaryMatrix (Ref<MatrixXd> boundaryMatrix,
                            const int M,
                            const int N,
-                           const double h,
+                           const double hx,
+                           const double hy,
                            const double * viscosityData) {
     #ifdef DEBUG 
       cout << "<Creating " << 3 * M * N - M - N << "x" << 2 * M + 2 * N << " BoundaryMatrix>" << endl;
@@ -190,16 +194,16 @@ namespace DenseForms {
     
     boundaryMatrix = MatrixXd::Zero (3 * M * N - M - N, 2 * M + 2 * N);
 
-    makeBCLaplacianXBlock (boundaryMatrix.block (0,                 0,     M * (N - 1), 2 * M), M, N, h, viscosityData);
-    makeBCLaplacianYBlock (boundaryMatrix.block (M * (N - 1),       2 * M, (M - 1) * N, 2 * N), M, N, h, viscosityData);
-    makeBCDivXBlock       (boundaryMatrix.block (2 * M * N - M - N, 0,     M * N,       2 * M), M, N, h);
-    makeBCDivYBlock       (boundaryMatrix.block (2 * M * N - M - N, 2 * M, M * N,       2 * N), M, N, h);
+    makeBCLaplacianXBlock (boundaryMatrix.block (0,                 0,     M * (N - 1), 2 * M), M, N, hx, viscosityData);
+    makeBCLaplacianYBlock (boundaryMatrix.block (M * (N - 1),       2 * M, (M - 1) * N, 2 * N), M, N, hy, viscosityData);
+    makeBCDivXBlock       (boundaryMatrix.block (2 * M * N - M - N, 0,     M * N,       2 * M), M, N, hx);
+    makeBCDivYBlock       (boundaryMatrix.block (2 * M * N - M - N, 2 * M, M * N,       2 * N), M, N, hy);
   }
 
   void makeBCLaplacianXBlock (Ref<MatrixXd> laplacianBC,
                               const int M,
                               const int N,
-                              const double h,
+                              const double hx,
                               const double * viscosityData) {
     #ifdef DEBUG 
       cout << "<Creating " << M * (N - 1) << "x" << 2 * M << " BCLaplacianXBlock>" << endl;
@@ -209,7 +213,7 @@ namespace DenseForms {
     for (int i = 0; i < M; ++i) {
       for (int j = 0; j < 2; ++j) {
         double viscosity = (viscosityWindow (j * N, i) + viscosityWindow (j * N, i + 1)) / 2;
-        laplacianBC (i * (N - 1) + j * (N - 2), i * 2 + j) = viscosity / (h * h);
+        laplacianBC (i * (N - 1) + j * (N - 2), i * 2 + j) = viscosity / (hx * hx);
       }
     }
   }
@@ -217,7 +221,7 @@ namespace DenseForms {
   void makeBCLaplacianYBlock (Ref<MatrixXd> laplacianBC,
                               const int M,
                               const int N,
-                              const double h,
+                              const double hy,
                               const double * viscosityData) {
     #ifdef DEBUG 
       cout << "<Creating " << (M - 1) * N << "x" << 2 * N << " BCLaplacianYBlock>" << endl;
@@ -227,7 +231,7 @@ namespace DenseForms {
     for (int i = 0; i < 2; ++i) {
       for (int j = 0; j < N; ++j) {
         double viscosity = (viscosityWindow (j, i * M) + viscosityWindow (j + 1, i * M)) / 2;
-        laplacianBC (i * (M - 2) * N + j, i * N + j) = viscosity / (h * h);
+        laplacianBC (i * (M - 2) * N + j, i * N + j) = viscosity / (hy * hy);
       }
     }
   }
@@ -235,28 +239,28 @@ namespace DenseForms {
   void makeBCDivXBlock (Ref<MatrixXd> divBC,
                         const int M,
                         const int N,
-                        const double h) {
+                        const double hx) {
     #ifdef DEBUG 
       cout << "<Creating " << M * N << "x" << 2 * M << " BCDivXBlock>" << endl;
     #endif
   
     for (int i = 0; i < M; ++i) {
-      divBC (i *       N,     i * 2)     =  1 / h;
-      divBC ((i + 1) * N - 1, i * 2 + 1) = -1 / h;
+      divBC (i *       N,     i * 2)     =  1 / hx;
+      divBC ((i + 1) * N - 1, i * 2 + 1) = -1 / hx;
     }
   }
 
   void makeBCDivYBlock (Ref<MatrixXd> divBC,
                         const int M,
                         const int N,
-                        const double h) {
+                        const double hy) {
     #ifdef DEBUG 
       cout << "<Creating " << M * N << "x" << 2 * N << " BCDivYBlock>" << endl;
     #endif  
 
     for (int i = 0; i < N; ++i) {
-      divBC (              i,     i) =  1 / h;
-      divBC ((M - 1) * N + i, N + i) = -1 / h;
+      divBC (              i,     i) =  1 / hy;
+      divBC ((M - 1) * N + i, N + i) = -1 / hy;
     }
   }
 }
@@ -9,214 +9,300 @@
 using namespace Eigen;
 
 namespace SparseForms {
-  void makeStokesMatrix (SparseMatrix<double>& stokesMatrix,
-                         const int M,
-                         const int N,
-                         const double h,
-                         const double * viscosityData) {
+  /* The range [iBegin, iEnd) of the outer loop of a block, whose iteration
+   * i writes the rows M0 + i * rowLength up to M0 + (i + 1) * rowLength,
+   * that meets **rows**. */
+  static void outerRange (const RowRange &rows,
+                          const GridIndex M0,
+                          const GridIndex rowLength,
+                          const GridIndex count,
+                          GridIndex &iBegin,
+                          GridIndex &iEnd) {
+    iBegin = iEnd = 0;
+    if (rowLength == 0)
+      return;
+
+    const GridIndex first = max (rows.begin - M0, GridIndex (0));
+    const GridIndex last  = max (min (rows.end - M0, count * rowLength), GridIndex (0));
+    iBegin = min (first / rowLength, count);
+    iEnd   = max ((last + rowLength - 1) / rowLength, iBegin);
+  }
+
+  void makeStokesMatrix (SparseMatrixXd& stokesMatrix,
+                         const GridIndex M,
+                         const GridIndex N,
+                         const double * dx,
+                         const double * dy,
+                         const double * viscosityData,
+                         const RowRange &rows) {
     #ifdef DEBUG 
       cout << "<Creating " << 3 * M * N - M - N << "x" << 3 * M * N - M - N << " stokesMatrix>" << endl;
     #endif
 
-    vector<Triplet<double> > tripletList;
+    vector<TripletXd> tripletList;
 
-    makeLaplacianXBlock (tripletList, 0,                 0,                 M, N, h, viscosityData);
-    makeLaplacianYBlock (tripletList, M * (N - 1),       M * (N - 1),       M, N, h, viscosityData);
-    makeGradXBlock      (tripletList, 0,                 2 * M * N - M - N, M, N, h);
-    makeGradYBlock      (tripletList, M * (N - 1),       2 * M * N - M - N, M, N, h);
-    makeDivXBlock       (tripletList, 2 * M * N - M - N, 0,                 M, N, h);
-    makeDivYBlock       (tripletList, 2 * M * N - M - N, M * (N - 1),       M, N, h);
-    
+    makeLaplacianXBlock (tripletList, 0,                 0,                 M, N, dx, dy, viscosityData, rows);
+    makeLaplacianYBlock (tripletList, M * (N - 1),       M * (N - 1),       M, N, dx, dy, viscosityData, rows);
+    makeGradXBlock      (tripletList, 0,                 2 * M * N - M - N, M, N, dx, rows);
+    makeGradYBlock      (tripletList, M * (N - 1),       2 * M * N - M - N, M, N, dy, rows);
+    makeDivXBlock       (tripletList, 2 * M * N - M - N, 0,                 M, N, dx, rows);
+    makeDivYBlock       (tripletList, 2 * M * N - M - N, M * (N - 1),       M, N, dy, rows);
+
+    if (rows.begin != 0)
+      for (TripletXd &triplet : tripletList)
+        triplet = TripletXd (triplet.row() - rows.begin, triplet.col(), triplet.value());
     stokesMatrix.setFromTriplets (tripletList.begin(), tripletList.end());
     #ifdef DEBUG
       cout << endl;
     #endif
   }
 
-  void makeLaplacianXBlock (vector<Triplet<double> >& tripletList,
-                            const int M0,
-                            const int N0,
-                            const int M,
-                            const int N,
-                            const double h,
-                            const double * viscosityData) {
+  void makeLaplacianXBlock (vector<TripletXd>& tripletList,
+                            const GridIndex M0,
+                            const GridIndex N0,
+                            const GridIndex M,
+                            const GridIndex N,
+                            const double * dx,
+                            const double * dy,
+                            const double * viscosityData,
+                            const RowRange &rows) {
     #ifdef DEBUG 
       cout << "<Creating " << M * (N - 1) << "x" << M * (N - 1) << " LaplacianXBlock>" << endl;
     #endif
 
+    GridIndex iBegin, iEnd;
+    outerRange (rows, M0, N - 1, M, iBegin, iEnd);
+
     DataWindow<const double> viscosityWindow (viscosityData, N + 1, M + 1);
-    for (int i = 0; i < M; ++i) {
+    for (GridIndex i = iBegin; i < iEnd; ++i) {
       for (int j = 0; j < (N - 1); ++j) {
+        if (!rows.contains (M0 + i * (N - 1) + j))
+          continue;
+
         double viscosity = (viscosityWindow (j + 1, i) + viscosityWindow (j + 1, i + 1)) / 2;
-        
+
+        // The control volume of the face between columns j and j + 1 is
+        // wx wide; each neighbor is weighted by the inverse of its distance
+        // times that width (or the row height).
+        double wx = (dx[j] + dx[j + 1]) / 2;
+        double leftWeight  = 1 / (wx * dx[j]);
+        double rightWeight = 1 / (wx * dx[j + 1]);
+        double lowerWeight = (i > 0)       ? 1 / (dy[i] * ((dy[i - 1] + dy[i]) / 2)) : 0;
+        double upperWeight = (i < (M - 1)) ? 1 / (dy[i] * ((dy[i] + dy[i + 1]) / 2)) : 0;
+
         // First and last rows are non-standard because the laplacian would sample points which
-        // do not exist in our gridding. 
-        if (i == 0 || i == (M - 1))
-          tripletList.push_back (
-              Triplet<double> (M0 + i * (N - 1) + j, 
-                               N0 + i * (N - 1) + j, 
-                               viscosity * 5 / (h * h)));
-        else
-          tripletList.push_back (
-              Triplet<double> (M0 + i * (N - 1) + j, 
-                               N0 + i * (N - 1) + j, 
-                               viscosity * 4 / (h * h)));
+        // do not exist in our gridding: the no-slip wall lies half a row away.
+        double wallWeight = 0;
+        if (i == 0)
+          wallWeight += 2 / (dy[0] * dy[0]);
+        if (i == (M - 1))
+          wallWeight += 2 / (dy[M - 1] * dy[M - 1]);
+
+        tripletList.push_back (
+            TripletXd (M0 + i * (N - 1) + j,
+                       N0 + i * (N - 1) + j,
+                       viscosity * ((leftWeight + rightWeight) + (lowerWeight + upperWeight + wallWeight))));
 
         // First and last rows are missing a neighbor in one of two directions
         if (i > 0)
           tripletList.push_back (
-              Triplet<double> (M0 + i       * (N - 1) + j, 
+              TripletXd (M0 + i       * (N - 1) + j, 
                                N0 + (i - 1) * (N - 1) + j, 
-                               -viscosity / (h * h)));
+                               -viscosity * lowerWeight));
         if (i < (M - 1))
           tripletList.push_back (
-              Triplet<double> (M0 + i       * (N - 1) + j, 
+              TripletXd (M0 + i       * (N - 1) + j, 
                                N0 + (i + 1) * (N - 1) + j, 
-                               -viscosity / (h * h)));
+                               -viscosity * upperWeight));
 
         // First and last elements of each row are missing a neighbor in one of two directions 
         if (j > 0)
           tripletList.push_back (
-              Triplet<double> (M0 + i * (N - 1) + j, 
+              TripletXd (M0 + i * (N - 1) + j, 
                                N0 + i * (N - 1) + j - 1, 
-                               -viscosity / (h * h)));
+                               -viscosity * leftWeight));
         if (j < (N - 2))
           tripletList.push_back (
-              Triplet<double> (M0 + i * (N - 1) + j, 
+              TripletXd (M0 + i * (N - 1) + j, 
                                N0 + i * (N - 1) + j + 1, 
-                               -viscosity / (h * h)));
+                               -viscosity * rightWeight));
       }
     }
   }
 
-  void makeLaplacianYBlock (vector<Triplet<double> >& tripletList,
-                            const int M0,
-                            const int N0,
-                            const int M,
-                            const int N,
-                            const double h,
-                            const double * viscosityData) {
+  void makeLaplacianYBlock (vector<TripletXd>& tripletList,
+                            const GridIndex M0,
+                            const GridIndex N0,
+                            const GridIndex M,
+                            const GridIndex N,
+                            const double * dx,
+                            const double * dy,
+                            const double * viscosityData,
+                            const RowRange &rows) {
     #ifdef DEBUG
       cout << "<Creating " << (M - 1) * N << "x" << (M - 1) * N << " LaplacianYBlock>" << endl;
     #endif
 
+    GridIndex iBegin, iEnd;
+    outerRange (rows, M0, N, M - 1, iBegin, iEnd);
+
     DataWindow<const double> viscosityWindow (viscosityData, N + 1, M + 1);
-    for (int i = 0; i < (M - 1); ++i) {
+    for (GridIndex i = iBegin; i < iEnd; ++i) {
       for (int j = 0; j < N; ++j) {
+        if (!rows.contains (M0 + i * N + j))
+          continue;
+
         double viscosity = (viscosityWindow (j, i + 1) + viscosityWindow (j + 1, i + 1)) / 2;
-        
+
+        // As in makeLaplacianXBlock(), with the control volume of the face
+        // between rows i and i + 1 wy high.
+        double wy = (dy[i] + dy[i + 1]) / 2;
+        double lowerWeight = 1 / (wy * dy[i]);
+        double upperWeight = 1 / (wy * dy[i + 1]);
+        double leftWeight  = (j > 0)       ? 1 / (dx[j] * ((dx[j - 1] + dx[j]) / 2)) : 0;
+        double rightWeight = (j < (N - 1)) ? 1 / (dx[j] * ((dx[j] + dx[j + 1]) / 2)) : 0;
+
         // The first and last elements of each row are non-standard because the four-point
         // laplacian relies upon points not included in our gridding
-        if ((j == 0) || (j == (N - 1)))
-          tripletList.push_back (Triplet<double> (M0 + i * N + j,
-                                                  N0 + i * N + j,
-                                                  viscosity * 5 / (h * h)));
-        else
-          tripletList.push_back (Triplet<double> (M0 + i * N + j,
-                                                  N0 + i * N + j,
-                                                  viscosity * 4 / (h * h)));
+        double wallWeight = 0;
+        if (j == 0)
+          wallWeight += 2 / (dx[0] * dx[0]);
+        if (j == (N - 1))
+          wallWeight += 2 / (dx[N - 1] * dx[N - 1]);
+
+        tripletList.push_back (TripletXd (M0 + i * N + j,
+                                          N0 + i * N + j,
+                                          viscosity * ((leftWeight + rightWeight + wallWeight) + (lowerWeight + upperWeight))));
 
         // First and last elements of each row are missing a neighbor in one of two directions
         if (j > 0)
-          tripletList.push_back (Triplet<double> (M0 + i * N + j,
+          tripletList.push_back (TripletXd (M0 + i * N + j,
                                                   N0 + i * N + (j - 1),
-                                                  -viscosity / (h * h)));
+                                                  -viscosity * leftWeight));
         if (j < (N - 1))
-          tripletList.push_back (Triplet<double> (M0 + i * N + j,
+          tripletList.push_back (TripletXd (M0 + i * N + j,
                                                   N0 + i * N + (j + 1),
-                                                  -viscosity / (h * h)));
+                                                  -viscosity * rightWeight));
 
         // Elements of the first and last rows are missing a neighbor in one of two directions
         if (i > 0)
-          tripletList.push_back (Triplet<double> (M0 + i       * N + j,
+          tripletList.push_back (TripletXd (M0 + i       * N + j,
                                                   N0 + (i - 1) * N + j,
-                                                  -viscosity / (h * h)));
+                                                  -viscosity * lowerWeight));
         if (i < (M - 2))
-          tripletList.push_back (Triplet<double> (M0 + i       * N + j,
+          tripletList.push_back (TripletXd (M0 + i       * N + j,
                                                   N0 + (i + 1) * N + j,
-                                                  -viscosity / (h * h)));
+                                                  -viscosity * upperWeight));
       }
     }
   }
 
-  void makeGradXBlock (vector<Triplet<double> >& tripletList,
-                       const int M0,
-                       const int N0,
-                       const int M,
-                       const int N,
-                       const double h) {
+  void makeGradXBlock (vector<TripletXd>& tripletList,
+                       const GridIndex M0,
+                       const GridIndex N0,
+                       const GridIndex M,
+                       const GridIndex N,
+                       const double * dx,
+                       const RowRange &rows) {
     #ifdef DEBUG
       cout << "<Creating " << M * (N - 1) << "x" << M * N << " GradXBlock>" << endl;
     #endif
 
-    for (int i = 0; i < M; ++i) {
+    GridIndex iBegin, iEnd;
+    outerRange (rows, M0, N - 1, M, iBegin, iEnd);
+
+    for (GridIndex i = iBegin; i < iEnd; ++i) {
       for (int j = 0; j < (N - 1); ++j) {
-        tripletList.push_back (Triplet<double> (M0 + i * (N - 1) + j, N0 + i * N + j,     -1 / h));
-        tripletList.push_back (Triplet<double> (M0 + i * (N - 1) + j, N0 + i * N + (j + 1),  1 / h));
+        if (!rows.contains (M0 + i * (N - 1) + j))
+          continue;
+
+        // The centers either side of the face are wx apart
+        double wx = (dx[j] + dx[j + 1]) / 2;
+        tripletList.push_back (TripletXd (M0 + i * (N - 1) + j, N0 + i * N + j,     -1 / wx));
+        tripletList.push_back (TripletXd (M0 + i * (N - 1) + j, N0 + i * N + (j + 1),  1 / wx));
       }
     }
   }
 
-  void makeGradYBlock (vector<Triplet<double> >& tripletList,
-                       const int M0,
-                       const int N0,
-                       const int M,
-                       const int N,
-                       const double h) {
+  void makeGradYBlock (vector<TripletXd>& tripletList,
+                       const GridIndex M0,
+                       const GridIndex N0,
+                       const GridIndex M,
+                       const GridIndex N,
+                       const double * dy,
+                       const RowRange &rows) {
     #ifdef DEBUG
       cout << "<Creating " << (M - 1) * N << "x" << M * N << " GradYBlock>" << endl;
     #endif
 
-    for (int i = 0; i < (M - 1) * N; ++i) {
-      tripletList.push_back (Triplet<double> (M0 + i, N0 + i,     -1 / h));
-      tripletList.push_back (Triplet<double> (M0 + i, N0 + N + i,  1 / h));
+    GridIndex iBegin, iEnd;
+    outerRange (rows, M0, 1, (M - 1) * N, iBegin, iEnd);
+
+    for (GridIndex i = iBegin; i < iEnd; ++i) {
+      double wy = (dy[i / N] + dy[i / N + 1]) / 2;
+      tripletList.push_back (TripletXd (M0 + i, N0 + i,     -1 / wy));
+      tripletList.push_back (TripletXd (M0 + i, N0 + N + i,  1 / wy));
     }
   }
 
-  void makeDivXBlock (vector<Triplet<double> >& tripletList,
-                      const int M0,
-                      const int N0,
-                      const int M,
-                      const int N,
-                      const double h) {
+  void makeDivXBlock (vector<TripletXd>& tripletList,
+                      const GridIndex M0,
+                      const GridIndex N0,
+                      const GridIndex M,
+                      const GridIndex N,
+                      const double * dx,
+                      const RowRange &rows) {
     #ifdef DEBUG 
       cout << "<Creating " << M * N << "x" << (M - 1) * N << " DivXBlock>" << endl;
     #endif
 
-    for (int i = 0; i < M; ++i) {
+    GridIndex iBegin, iEnd;
+    outerRange (rows, M0, N, M, iBegin, iEnd);
+
+    // Each face meets the cells either side, which may be owned apart.
+    for (GridIndex i = iBegin; i < iEnd; ++i) {
       for (int x = 0; x < (N - 1); ++x) {
-        tripletList.push_back (Triplet<double> (M0 + i * N + x,     N0 + i * (N - 1) + x,  1 / h));
-        tripletList.push_back (Triplet<double> (M0 + i * N + 1 + x, N0 + i * (N - 1) + x, -1 / h));
+        if (rows.contains (M0 + i * N + x))
+          tripletList.push_back (TripletXd (M0 + i * N + x,     N0 + i * (N - 1) + x,  1 / dx[x]));
+        if (rows.contains (M0 + i * N + 1 + x))
+          tripletList.push_back (TripletXd (M0 + i * N + 1 + x, N0 + i * (N - 1) + x, -1 / dx[x + 1]));
       }
     }
   }
 
-  void makeDivYBlock (vector<Triplet<double> >& tripletList,
-                      const int M0,
-                      const int N0,
-                      const int M,
-                      const int N,
-                      const double h) {
+  void makeDivYBlock (vector<TripletXd>& tripletList,
+                      const GridIndex M0,
+                      const GridIndex N0,
+                      const GridIndex M,
+                      const GridIndex N,
+                      const double * dy,
+                      const RowRange &rows) {
     #ifdef DEBUG
       cout << "<Creating " << M * N << "x" << (M - 1) * N << " DivYBlock>" << endl;
     #endif
 
-    for (int i = 0; i < (M - 1) * N; ++i) {
-      tripletList.push_back (Triplet<double> (M0 + i,     N0 + i,  1 / h));
-      tripletList.push_back (Triplet<double> (M0 + i + N, N0 + i, -1 / h));
+    // Face i writes the rows of the cells below and above it, N apart.
+    GridIndex iBegin, iEnd;
+    outerRange (RowRange (rows.begin - N, rows.end), M0, 1, (M - 1) * N, iBegin, iEnd);
+
+    for (GridIndex i = iBegin; i < iEnd; ++i) {
+      if (rows.contains (M0 + i))
+        tripletList.push_back (TripletXd (M0 + i,     N0 + i,  1 / dy[i / N]));
+      if (rows.contains (M0 + i + N))
+        tripletList.push_back (TripletXd (M0 + i + N, N0 + i, -1 / dy[i / N + 1]));
     }
   }
 
-  void makeForcingMatrix (SparseMatrix<double>& forcingMatrix,
-                          const int M,
-                          const int N) {
+  void makeForcingMatrix (SparseMatrixXd& forcingMatrix,
+                          const GridIndex M,
+                          const GridIndex N) {
     #ifdef DEBUG
       cout << "<Creating " << 3 * M * N - M - N << "x" << 2 * M * N - M - N << " ForcingMatrix>" << endl;
     #endif
-    vector<Triplet<double> > tripletList;
+    vector<TripletXd> tripletList;
 
-    for (int i = 0; i < 2 * M * N - M - N; ++i)
-      tripletList.push_back (Triplet<double> (i, i, 1));
+    for (GridIndex i = 0; i < 2 * M * N - M - N; ++i)
+      tripletList.push_back (TripletXd (i, i, 1));
   
     forcingMatrix.setFromTriplets (tripletList.begin (), tripletList.end ());
     
@@ -225,21 +311,22 @@ namespace SparseForms {
     #endif
   }
 
-  void makeBoundaryMatrix (SparseMatrix<double>& boundaryMatrix,
-                           const int M,
-                           const int N,
-                           const double h,
+  void makeBoundaryMatrix (SparseMatrixXd& boundaryMatrix,
+                           const GridIndex M,
+                           const GridIndex N,
+                           const double * dx,
+                           const double * dy,
                            const double * viscosityData) {
     #ifdef DEBUG 
       cout << "<Creating " << 3 * M * N - M - N << "x" << 2 * M + 2 * N << " BoundaryMatrix>" << endl;
     #endif
 
-    vector<Triplet<double> > tripletList;
+    vector<TripletXd> tripletList;
 
-    makeBCLaplacianXBlock (tripletList, 0,                 0,     M, N, h, viscosityData);
-    makeBCLaplacianYBlock (tripletList, M * (N - 1),       2 * M, M, N, h, viscosityData);
-    makeBCDivXBlock       (tripletList, 2 * M * N - M - N, 0,     M, N, h);
-    makeBCDivYBlock       (tripletList, 2 * M * N - M - N, 2 * M, M, N, h);
+    makeBCLaplacianXBlock (tripletList, 0,                 0,     M, N, dx, viscosityData);
+    makeBCLaplacianYBlock (tripletList, M * (N - 1),       2 * M, M, N, dy, viscosityData);
+    makeBCDivXBlock       (tripletList, 2 * M * N - M - N, 0,     M, N, dx);
+    makeBCDivYBlock       (tripletList, 2 * M * N - M - N, 2 * M, M, N, dy);
 
     boundaryMatrix.setFromTriplets (tripletList.begin(), tripletList.end());
 
@@ -248,13 +335,13 @@ namespace SparseForms {
     #endif
   }
 
-  void makeBCLaplacianXBlock (vector<Triplet<double> >& tripletList,
-                              const int      M0,
-                              const int      N0,
-                              const int      M,
-                              const int      N,
-                              const double   h,
-                              const double * viscosityData) {
+  void makeBCLaplacianXBlock (vector<TripletXd>& tripletList,
+                              const GridIndex M0,
+                              const GridIndex N0,
+                              const GridIndex M,
+                              const GridIndex N,
+                              const double *  dx,
+                              const double *  viscosityData) {
     #ifdef DEBUG
       cout << "<Creating " << (M - 1) * N << "x" << 2 * M << " BCLaplacianXBlock>" << endl;
     #endif
@@ -263,20 +350,23 @@ namespace SparseForms {
     for (int i = 0; i < M; ++i) {
       for (int j = 0; j < 2; ++j) {
         double viscosity = (viscosityWindow (j * N, i) + viscosityWindow (j * N, i + 1)) / 2;
-        tripletList.push_back (Triplet<double> (M0 + i * (N - 1) + j * (N - 2),
+        // The wall is one cell width from the first (last) face
+        double wallWidth = dx[j * (N - 1)];
+        double wx = (wallWidth + dx[j * (N - 3) + 1]) / 2;
+        tripletList.push_back (TripletXd (M0 + i * (N - 1) + j * (N - 2),
                                                 N0 + i * 2       + j,
-                                                viscosity / (h * h)));
+                                                viscosity / (wx * wallWidth)));
       }
     }
   }
 
-  void makeBCLaplacianYBlock (vector<Triplet<double> >& tripletList,
-                              const int      M0,
-                              const int      N0,
-                              const int      M,
-                              const int      N,
-                              const double   h,
-                              const double * viscosityData) {
+  void makeBCLaplacianYBlock (vector<TripletXd>& tripletList,
+                              const GridIndex M0,
+                              const GridIndex N0,
+                              const GridIndex M,
+                              const GridIndex N,
+                              const double *  dy,
+                              const double *  viscosityData) {
     #ifdef DEBUG
       cout << "<Creating " << (M - 1) * N << "x" << 2 * N << " BCLaplacianYBlock>" << endl;
     #endif
@@ -285,42 +375,44 @@ namespace SparseForms {
     for (int i = 0; i < 2; ++i) {
       for (int j = 0; j < N; ++j) {
         double viscosity = (viscosityWindow (j, i * M) + viscosityWindow (j + 1, i * M)) / 2;
-        tripletList.push_back (Triplet<double> (M0 + i * (M - 2) * N + j,  
+        double wallHeight = dy[i * (M - 1)];
+        double wy = (wallHeight + dy[i * (M - 3) + 1]) / 2;
+        tripletList.push_back (TripletXd (M0 + i * (M - 2) * N + j,  
                                                 N0 + i           * N + j, 
-                                                viscosity / (h * h)));
+                                                viscosity / (wy * wallHeight)));
       }
     }
   }
 
-  void makeBCDivXBlock (vector<Triplet<double> >& tripletList,
-                        const int M0,
-                        const int N0,
-                        const int M,
-                        const int N,
-                        const double h) {
+  void makeBCDivXBlock (vector<TripletXd>& tripletList,
+                        const GridIndex M0,
+                        const GridIndex N0,
+                        const GridIndex M,
+                        const GridIndex N,
+                        const double * dx) {
     #ifdef DEBUG 
       cout << "<Creating " << M * N << "x" << 2 * M << " BCDivXBlock>" << endl;
     #endif
 
     for (int i = 0; i < M; ++i) {
-      tripletList.push_back (Triplet<double> (M0 + i * N,           N0 + i * 2,      1 / h));
-      tripletList.push_back (Triplet<double> (M0 + (i + 1) * N - 1, N0 + i * 2 + 1, -1 / h));
+      tripletList.push_back (TripletXd (M0 + i * N,           N0 + i * 2,      1 / dx[0]));
+      tripletList.push_back (TripletXd (M0 + (i + 1) * N - 1, N0 + i * 2 + 1, -1 / dx[N - 1]));
     }
   }
 
-  void makeBCDivYBlock (vector<Triplet<double> >& tripletList,
-                        const int M0,
-                        const int N0,
-                        const int M,
-                        const int N,
-                        const double h) {
+  void makeBCDivYBlock (vector<TripletXd>& tripletList,
+                        const GridIndex M0,
+                        const GridIndex N0,
+                        const GridIndex M,
+                        const GridIndex N,
+                        const double * dy) {
     #ifdef DEBUG 
       cout << "<Creating " << M * N << "x" << 2 * N << " BCDivYBlock>" << endl;
     #endif
 
     for (int i = 0; i < N; ++i) {
-      tripletList.push_back (Triplet<double> (M0 + i,               N0 + i,      1 / h));
-      tripletList.push_back (Triplet<double> (M0 + (M - 1) * N + i, N0 + N + i, -1 / h));
+      tripletList.push_back (TripletXd (M0 + i,               N0 + i,      1 / dy[0]));
+      tripletList.push_back (TripletXd (M0 + (M - 1) * N + i, N0 + N + i, -1 / dy[M - 1]));
     }
   }
 }
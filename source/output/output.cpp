@@ -2,8 +2,13 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+#include <mutex>
 
 #include "boost/lexical_cast.hpp"
+#include "boost/filesystem.hpp"
 
 #include "debug/exception.h"
 #include "geometry/dataWindow.h"
@@ -14,6 +19,25 @@
 
 using namespace std;
 
+// The serial HDF5 library is not thread-safe, so concurrent runs (see
+// BatchDriver) take turns writing their output files.
+static std::mutex hdf5Mutex;
+
+// In-memory HDF5 type of the transported fields. They are converted to double
+// precision on write, so the files do not depend on the build.
+static hid_t nativeRealType() {
+  return (sizeof (Real) == sizeof (float)) ? H5T_NATIVE_FLOAT : H5T_NATIVE_DOUBLE;
+}
+
+// Space-separated coordinates, at full precision, for an inline XDMF item.
+static std::string coordinateList (const std::vector<double> &coordinates) {
+  std::ostringstream list;
+  list << std::setprecision (std::numeric_limits<double>::max_digits10);
+  for (size_t k = 0; k < coordinates.size(); ++k)
+    list << (k > 0 ? " " : "") << coordinates[k];
+  return list.str();
+}
+
 OutputStructure::OutputStructure (Params            &p,
                                   GeometryStructure &gs,
                                   ProblemStructure  &ps) :
@@ -22,7 +46,13 @@ OutputStructure::OutputStructure (Params            &p,
     problem  (ps) {
   M  = geometry.getM();
   N  = geometry.getN();
-  dx = problem.getH();
+  dx = problem.getHx();
+  dy = problem.getHy();
+
+  if (problem.isStretched()) {
+    xVertexList = coordinateList (problem.getXFaces());
+    yVertexList = coordinateList (problem.getYFaces());
+  }
 
   params.push ("outputParams"); {
     params.queryParam<std::string>(
@@ -41,14 +71,29 @@ OutputStructure::OutputStructure (Params            &p,
     params.pop();
   }
 
-  char s[128];
-  sprintf(s, "test -e %s", outputPath.c_str());
-  if (system(s) != 0) {
-    sprintf(s, "mkdir %s", outputPath.c_str());
-    if (system(s) != 0) {
-      THROW_WITH_TRACE(RuntimeError() <<
-              errmsg_info("Couldn't create directory '" + outputPath + "'."));
-    }
+  // Only the first process holds the whole solution, and writes it.
+  if (!Decomposition::isRootProcess()) {
+    outputFormat = "none";
+    interpolatedUVelocityData = interpolatedVVelocityData = velocityDivergenceData = NULL;
+    compositionOutputData = NULL;
+    return;
+  }
+
+  interpolatedUVelocityData = new double[M * N];
+  interpolatedVVelocityData = new double[M * N];
+  velocityDivergenceData    = new double[M * N];
+  compositionOutputData     = new Real[M * N];
+
+  // Runs which only need in-memory results (e.g. convergence studies) write
+  // nothing at all.
+  if (outputFormat == "none")
+    return;
+
+  boost::system::error_code ec;
+  boost::filesystem::create_directories (outputPath, ec);
+  if (ec) {
+    THROW_WITH_TRACE(RuntimeError() <<
+            errmsg_info("Couldn't create directory '" + outputPath + "'."));
   }
 
   problemXdmfFile.open ((outputPath + "/" + outputFilename + "-series.xdmf").c_str(), ofstream::out);
@@ -60,15 +105,26 @@ OutputStructure::OutputStructure (Params            &p,
 }
 
 OutputStructure::~OutputStructure () {
-  problemXdmfFile << "    </Grid>" << endl
-                  << "  </Domain>" << endl
-                  << "</Xdmf>" << endl;
-  problemXdmfFile.close();
+  if (problemXdmfFile.is_open()) {
+    problemXdmfFile << "    </Grid>" << endl
+                    << "  </Domain>" << endl
+                    << "</Xdmf>" << endl;
+    problemXdmfFile.close();
+  }
+
+  delete[] interpolatedUVelocityData;
+  delete[] interpolatedVVelocityData;
+  delete[] velocityDivergenceData;
+  delete[] compositionOutputData;
 }
 
 void OutputStructure::outputData (const int timestep) {
+  // Collective, so every process takes part whether or not it writes.
+  problem.gatherTemperature();
+
   if (outputFormat == "hdf5") {
     this->writeHDF5File (timestep);
+  } else if (outputFormat == "none") {
   } else {
     THROW_WITH_TRACE(InvalidArgument() <<
             errmsg_info("Unknown output format '" + outputFormat + "' specified in parameters."));
@@ -76,22 +132,38 @@ void OutputStructure::outputData (const int timestep) {
 }
 
 void OutputStructure::writeHDF5File (const int timestep) {
+  std::lock_guard<std::mutex> lock (hdf5Mutex);
+
   hid_t outputFile = H5Fcreate ((outputPath + "/" + outputFilename + "-" + boost::lexical_cast<std::string> (timestep) + ".h5").c_str(),
                      H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
 
   cout << "<Outputting current data to \"" << outputPath << "/" << outputFilename << "-" << timestep << ".h5\">" << endl;
 
   problemXdmfFile << "      <Grid Name=\"mesh\" GridType=\"Uniform\">" << endl
-                  << "        <Time Value=\"" << problem.getTime() << "\"/>" << endl
-                  << "        <Topology TopologyType=\"2DCoRectMesh\" NumberOfElements=\"" << M + 1 << " " << N + 1<< "\"/>" << endl
-                  << "        <Geometry GeometryType=\"Origin_DxDy\">" << endl
-                  << "          <DataItem Dimensions=\"2\">" << endl
-                  << "            0 0" << endl
-                  << "          </DataItem>" << endl
-                  << "          <DataItem Dimensions=\"2\">" << endl
-                  << "            " << dx << " " << dx << endl
-                  << "          </DataItem>" << endl
-                  << "        </Geometry>" << endl;
+                  << "        <Time Value=\"" << problem.getTime() << "\"/>" << endl;
+
+  // A stretched grid lists its vertex coordinates, x first, then y.
+  if (problem.isStretched()) {
+    problemXdmfFile << "        <Topology TopologyType=\"2DRectMesh\" NumberOfElements=\"" << M + 1 << " " << N + 1<< "\"/>" << endl
+                    << "        <Geometry GeometryType=\"VXVY\">" << endl
+                    << "          <DataItem Dimensions=\"" << N + 1 << "\" NumberType=\"Float\" Precision=\"8\" Format=\"XML\">" << endl
+                    << "            " << xVertexList << endl
+                    << "          </DataItem>" << endl
+                    << "          <DataItem Dimensions=\"" << M + 1 << "\" NumberType=\"Float\" Precision=\"8\" Format=\"XML\">" << endl
+                    << "            " << yVertexList << endl
+                    << "          </DataItem>" << endl
+                    << "        </Geometry>" << endl;
+  } else {
+    problemXdmfFile << "        <Topology TopologyType=\"2DCoRectMesh\" NumberOfElements=\"" << M + 1 << " " << N + 1<< "\"/>" << endl
+                    << "        <Geometry GeometryType=\"Origin_DxDy\">" << endl
+                    << "          <DataItem Dimensions=\"2\">" << endl
+                    << "            0 0" << endl
+                    << "          </DataItem>" << endl
+                    << "          <DataItem Dimensions=\"2\">" << endl
+                    << "            " << dy << " " << dx << endl
+                    << "          </DataItem>" << endl
+                    << "        </Geometry>" << endl;
+  }
 
   hid_t dataset, datatype, dataspace;
   herr_t status;
@@ -111,8 +183,8 @@ void OutputStructure::writeHDF5File (const int timestep) {
   dataset = H5Dcreate2(outputFile, "Temperature", datatype, dataspace,
                        H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 
-  status = H5Dwrite (dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL,
-                     H5P_DEFAULT, geometry.getTemperatureData());
+  status = H5Dwrite (dataset, nativeRealType(), H5S_ALL, H5S_ALL,
+                     H5P_DEFAULT, geometry.getGatheredTemperatureData());
 
   if (status == -1) {
     THROW_WITH_TRACE(RuntimeError() <<
@@ -125,6 +197,34 @@ void OutputStructure::writeHDF5File (const int timestep) {
                   << "          </DataItem>" << endl
                   << "        </Attribute>" << endl;
 
+  // Write compositional fields, de-interleaving each one into a work array
+  const int K = geometry.getK();
+  const Real * compositionData = geometry.getCompositionData();
+
+  for (int f = 0; f < K; ++f) {
+    const std::string compositionName = "Composition" + boost::lexical_cast<std::string> (f);
+
+    for (GridIndex n = 0; n < M * N; ++n)
+      compositionOutputData[n] = compositionData[n * K + f];
+
+    dataset = H5Dcreate2(outputFile, compositionName.c_str(), datatype, dataspace,
+                         H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+
+    status = H5Dwrite (dataset, nativeRealType(), H5S_ALL, H5S_ALL,
+                       H5P_DEFAULT, compositionOutputData);
+
+    if (status == -1) {
+      THROW_WITH_TRACE(RuntimeError() <<
+              errmsg_info("H5Dwrite failed"));
+    }
+
+    problemXdmfFile << "        <Attribute Name=\"" << compositionName << "\" AttributeType=\"Scalar\" Center=\"Cell\">" << endl
+                    << "          <DataItem Dimensions=\"" << M << " " << N << "\" NumberType=\"Float\" Precision=\"8\" Format=\"HDF\">" << endl
+                    << "            " << outputFilename + "-" + boost::lexical_cast<std::string> (timestep) << ".h5:/" << compositionName << endl
+                    << "          </DataItem>" << endl
+                    << "        </Attribute>" << endl;
+  }
+
   // Write pressure
   dataset = H5Dcreate2(outputFile, "Pressure", datatype, dataspace,
                        H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
@@ -143,10 +243,9 @@ void OutputStructure::writeHDF5File (const int timestep) {
                   << "        </Attribute>" << endl;
 
   // Write U Velocity
-  static double * interpolatedUVelocityData = new double [M * N];
-  static DataWindow<double> interpolatedUVelocityWindow (interpolatedUVelocityData, N, M);
-  static DataWindow<double> uVelocityBoundaryWindow (geometry.getUVelocityBoundaryData(), 2, M);
-  static DataWindow<double> uVelocityWindow (geometry.getUVelocityData(), N - 1, M);
+  DataWindow<double> interpolatedUVelocityWindow (interpolatedUVelocityData, N, M);
+  DataWindow<double> uVelocityBoundaryWindow (geometry.getUVelocityBoundaryData(), 2, M);
+  DataWindow<double> uVelocityWindow (geometry.getUVelocityData(), N - 1, M);
 
   for (int i = 0; i < M; ++i) {
     for (int j = 0; j < N; ++j) {
@@ -181,10 +280,9 @@ void OutputStructure::writeHDF5File (const int timestep) {
                   << "        </Attribute>" << endl;
 
   // Write V Velocity
-  static double * interpolatedVVelocityData = new double [M * N];
-  static DataWindow<double> interpolatedVVelocityWindow (interpolatedVVelocityData, N, M);
-  static DataWindow<double> vVelocityBoundaryWindow (geometry.getVVelocityBoundaryData(), N, 2);
-  static DataWindow<double> vVelocityWindow (geometry.getVVelocityData(), N, M - 1);
+  DataWindow<double> interpolatedVVelocityWindow (interpolatedVVelocityData, N, M);
+  DataWindow<double> vVelocityBoundaryWindow (geometry.getVVelocityBoundaryData(), N, 2);
+  DataWindow<double> vVelocityWindow (geometry.getVVelocityData(), N, M - 1);
 
   for (int i = 0; i < M; ++i) {
     for (int j = 0; j < N; ++j) {
@@ -218,27 +316,28 @@ void OutputStructure::writeHDF5File (const int timestep) {
                   << "          </DataItem>" << endl
                   << "        </Attribute>" << endl;
 
-  static double * velocityDivergenceData = new double[M * N];
-  static DataWindow<double> velocityDivergenceWindow (velocityDivergenceData, N, M);
+  DataWindow<double> velocityDivergenceWindow (velocityDivergenceData, N, M);
+  const vector<double> &cellWidths  = problem.getCellWidths();
+  const vector<double> &cellHeights = problem.getCellHeights();
 
   for (int i = 0; i < M; ++i) {
     for (int j = 0; j < N; ++j) {
       double uDivergence, vDivergence;
 
       if (i == 0) {
-        vDivergence = (vVelocityBoundaryWindow (j, 0) - vVelocityWindow (j, 0)) / dx;
+        vDivergence = (vVelocityBoundaryWindow (j, 0) - vVelocityWindow (j, 0)) / cellHeights[i];
       } else if (i == (M - 1)) {
-        vDivergence = (vVelocityWindow (j, M - 2) - vVelocityBoundaryWindow (j, 1)) / dx;
+        vDivergence = (vVelocityWindow (j, M - 2) - vVelocityBoundaryWindow (j, 1)) / cellHeights[i];
       } else {
-        vDivergence = (vVelocityWindow (j, i - 1) - vVelocityWindow (j, i)) / dx;
+        vDivergence = (vVelocityWindow (j, i - 1) - vVelocityWindow (j, i)) / cellHeights[i];
       }
 
       if (j == 0) {
-        uDivergence = (uVelocityBoundaryWindow (0, i) - uVelocityWindow (0, i)) / dx;
+        uDivergence = (uVelocityBoundaryWindow (0, i) - uVelocityWindow (0, i)) / cellWidths[j];
       } else if (j == (N - 1)) {
-        uDivergence = (uVelocityWindow (N - 2, i) - uVelocityBoundaryWindow (1, i)) / dx;
+        uDivergence = (uVelocityWindow (N - 2, i) - uVelocityBoundaryWindow (1, i)) / cellWidths[j];
       } else {
-        uDivergence = (uVelocityWindow (j - 1, i) - uVelocityWindow (j, i)) / dx;
+        uDivergence = (uVelocityWindow (j - 1, i) - uVelocityWindow (j, i)) / cellWidths[j];
       }
 
       velocityDivergenceWindow (j, i) = uDivergence + vDivergence;
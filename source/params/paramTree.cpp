@@ -46,10 +46,10 @@ void ParamTree::moveDown () {
     THROW_WITH_TRACE(ParserException() <<
             errmsg_info("Popped off root of parameter tree"));
   } else if (focusNode->isTemp) {
-    // If the focus is a temporary node, delete it and remove it from the
-    // parent's child map before moving down.
-    focusNode->~ParamNode();
+    // If the focus is a temporary node, remove it from the parent's child
+    // map and delete it before moving down.
     parentNode->children.erase(focusNode->sectionKey);
+    delete focusNode;
   }
 
   focusNode = parentNode;
@@ -102,6 +102,10 @@ void ParamTree::addParam(std::string key, std::string param) {
   std::cerr << "Wrote " << key << " as " << param << std::endl;
 }
 
+void ParamTree::setParam(std::string key, std::string param) {
+  focusNode->params[key] = param;
+}
+
 void ParamTree::delParam(std::string key) {
   if (hasParam(key)) {
     focusNode->params.erase(key);
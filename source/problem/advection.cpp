@@ -1,4 +1,5 @@
 #include <iostream>
+#include <cmath>
 
 #include <Eigen/Sparse>
 #include <Eigen/Dense>
@@ -8,6 +9,7 @@
 #include "debug/exception.h"
 #include "matrixForms/sparseForms.h"
 #include "geometry/dataWindow.h"
+#include "geometry/interpolation.h"
 #include "geometry/geometry.h"
 #include "problem/problem.h"
 #include "debug.h"
@@ -19,77 +21,102 @@ using namespace std;
 
 // upwind method. Stable but inefficient.
 void ProblemStructure::upwindMethod() {
-  Map<VectorXd> temperatureVector (geometry.getTemperatureData(), M * N);
-  Map<VectorXd> temperatureBoundaryVector (geometry.getTemperatureBoundaryData(), 2 * M);
+  // Only this process' block is updated, in its own storage (see
+  // Decomposition::cell() and uFace()).
+  Decomposition &decomposition = geometry.getDecomposition();
 
-  DataWindow<double> uVelocityWindow (geometry.getUVelocityData(), N - 1, M);
-  DataWindow<double> vVelocityWindow (geometry.getVVelocityData(), N, M - 1);
+  const Real * temperature = geometry.getTemperatureData();
+  Real * nextTemperature = geometry.getTemperatureBackData();
+
+  const double * uVelocity = geometry.getBlockUVelocityData();
+  const double * vVelocity = geometry.getBlockVVelocityData();
   DataWindow<double> uVelocityBoundaryWindow (geometry.getUVelocityBoundaryData(), 2, M);
   DataWindow<double> vVelocityBoundaryWindow (geometry.getVVelocityBoundaryData(), N, 2);
 
-  double leftVelocity, rightVelocity, bottomVelocity, topVelocity;
-  double leftFlux, rightFlux, bottomFlux, topFlux;
-
-  VectorXd temporaryVector = temperatureVector;
-
-  for (int i = 0; i < M; ++i) {
-    for (int j = 0; j <  N; ++j) {
-      // Find all four edge velocities for the current cell.
-      leftVelocity   = (j == 0) ?
-                        uVelocityBoundaryWindow (0, i) :
-                        uVelocityWindow (j - 1, i);
-      rightVelocity  = (j == (N - 1)) ?
-                        uVelocityBoundaryWindow (1, i) :
-                        uVelocityWindow (j, i);
-      bottomVelocity = (i == 0) ?
-                        vVelocityBoundaryWindow (j, 0) :
-                        vVelocityWindow (j, i - 1);
-      topVelocity    = (i == (M - 1)) ?
-                        vVelocityBoundaryWindow (j, 1) :
-                        vVelocityWindow (j, i);
-
-      leftFlux = rightFlux = 0;
-      topFlux = bottomFlux = 0;
-
-      // Solve the Riemann problem on the neighboring velocities and calculate
-      // the fluxes accross each edge.
-      if (j > 0) {
-        if (leftVelocity < 0) {
-          leftFlux = temporaryVector (i * N + j) * leftVelocity * deltaT / h;
-        } else {
-          leftFlux = temporaryVector (i * N + (j - 1)) * leftVelocity * deltaT / h;
-        }
+  auto updateCell = [&] (const GridIndex i, const GridIndex j) {
+    double leftVelocity, rightVelocity, bottomVelocity, topVelocity;
+    double leftFlux, rightFlux, bottomFlux, topFlux;
+
+    // Find all four edge velocities for the current cell.
+    leftVelocity   = (j == 0) ?
+                      uVelocityBoundaryWindow (0, i) :
+                      uVelocity[decomposition.uFace (i, j - 1)];
+    rightVelocity  = (j == (N - 1)) ?
+                      uVelocityBoundaryWindow (1, i) :
+                      uVelocity[decomposition.uFace (i, j)];
+    bottomVelocity = (i == 0) ?
+                      vVelocityBoundaryWindow (j, 0) :
+                      vVelocity[decomposition.vFace (i - 1, j)];
+    topVelocity    = (i == (M - 1)) ?
+                      vVelocityBoundaryWindow (j, 1) :
+                      vVelocity[decomposition.vFace (i, j)];
+
+    leftFlux = rightFlux = 0;
+    topFlux = bottomFlux = 0;
+
+    // The fluxes are divided by the cell's width or height.
+    const double width  = cellWidths[j];
+    const double height = cellHeights[i];
+    const GridIndex c   = decomposition.cell (i, j);
+
+    // Solve the Riemann problem on the neighboring velocities and calculate
+    // the fluxes accross each edge.
+    if (j > 0) {
+      if (leftVelocity < 0) {
+        leftFlux = temperature[c] * leftVelocity * deltaT / width;
+      } else {
+        leftFlux = temperature[decomposition.cell (i, j - 1)] * leftVelocity * deltaT / width;
       }
+    }
 
-      if (j < (N - 1)) {
-        if (rightVelocity > 0) {
-          rightFlux = temporaryVector (i * N + j) * rightVelocity * deltaT / h;
-        } else {
-          rightFlux = temporaryVector (i * N + (j + 1)) * rightVelocity * deltaT / h;
-        }
+    if (j < (N - 1)) {
+      if (rightVelocity > 0) {
+        rightFlux = temperature[c] * rightVelocity * deltaT / width;
+      } else {
+        rightFlux = temperature[decomposition.cell (i, j + 1)] * rightVelocity * deltaT / width;
       }
+    }
 
-      if (i > 0) {
-        if (bottomVelocity < 0) {
-          bottomFlux = temporaryVector (i * N + j) * bottomVelocity * deltaT / h;
-        } else {
-          bottomFlux = temporaryVector ((i - 1) * N + j) * bottomVelocity * deltaT / h;
-        }
+    if (i > 0) {
+      if (bottomVelocity < 0) {
+        bottomFlux = temperature[c] * bottomVelocity * deltaT / height;
+      } else {
+        bottomFlux = temperature[decomposition.cell (i - 1, j)] * bottomVelocity * deltaT / height;
       }
+    }
 
-      if (i < (M - 1)) {
-        if (topVelocity > 0) {
-          topFlux = temporaryVector (i * N + j) * topVelocity * deltaT / h;
-        } else {
-          topFlux = temporaryVector ((i + 1) * N + j) * topVelocity * deltaT / h;
-        }
+    if (i < (M - 1)) {
+      if (topVelocity > 0) {
+        topFlux = temperature[c] * topVelocity * deltaT / height;
+      } else {
+        topFlux = temperature[decomposition.cell (i + 1, j)] * topVelocity * deltaT / height;
       }
-
-      temperatureVector (i * N + j) = temporaryVector (i * N + j) +
-                                        leftFlux - rightFlux +
-                                        bottomFlux - topFlux;
     }
+
+    nextTemperature[c] = temperature[c] +
+                         leftFlux - rightFlux +
+                         bottomFlux - topFlux;
+  };
+
+  // The cells away from the block edges are updated while the halo
+  // exchange is in flight.
+  decomposition.beginHaloExchange (geometry.getTemperatureData());
+  for (GridIndex i = decomposition.getRowBegin(); i < decomposition.getRowEnd(); ++i)
+    for (GridIndex j = decomposition.getColBegin(); j < decomposition.getColEnd(); ++j)
+      if (!decomposition.onBlockEdge (i, j))
+        updateCell (i, j);
+
+  decomposition.endHaloExchange (geometry.getTemperatureData());
+  if (decomposition.isDistributed()) {
+    for (GridIndex i = decomposition.getRowBegin(); i < decomposition.getRowEnd(); ++i)
+      for (GridIndex j = decomposition.getColBegin(); j < decomposition.getColEnd(); ++j)
+        if (decomposition.onBlockEdge (i, j))
+          updateCell (i, j);
+
+    temperatureDistributed = true;
   }
+
+  geometry.swapTemperatureBuffers();
 }
 
 void ProblemStructure::laxWendroff() {
@@ -97,9 +124,9 @@ void ProblemStructure::laxWendroff() {
 
 void ProblemStructure::frommMethod() {
   // Temperature data (MxN cell-centered grid)
-  DataWindow<double> temperatureWindow (geometry.getTemperatureData(), N, M);
+  DataWindow<Real> temperatureWindow (geometry.getTemperatureData(), N, M);
   // Temperature boundary data (2xN transverse boundary grid)
-  DataWindow<double> temperatureBoundaryWindow (geometry.getTemperatureBoundaryData(), N, 2);
+  DataWindow<Real> temperatureBoundaryWindow (geometry.getTemperatureBoundaryData(), N, 2);
 
   // U Velocity Data (Mx(N-1) lateral offset grid)
   DataWindow<double> uVelocityWindow (geometry.getUVelocityData(), N - 1, M);
@@ -111,46 +138,53 @@ void ProblemStructure::frommMethod() {
   // V Velocity Boundary Data (2xN transverse boundary grid)
   DataWindow<double> vVelocityBoundaryWindow (geometry.getVVelocityBoundaryData(), N, 2);
 
-  // Initilize half-time data
+  // Initilize half-time data. The work arrays are owned by the
+  // ProblemStructure and only allocated on the first call.
+  halfTimeTemperature.resize (M * N);
+  halfTimeUOffsetTemperature.resize (M * (N - 1));
+  halfTimeVOffsetTemperature.resize ((M - 1) * N);
+  halfTimeForcing.resize (2 * M * N - M - N);
+  halfTimeStokesSoln.resize (3 * M * N - M - N);
+  cellCenteredVelocity.resize (2 * M * N);
+
   // Half-time temperature data (MxN cell-centered grid)
-  static DataWindow<double> halfTimeTemperatureWindow (new double[M * N], N, M);
+  DataWindow<double> halfTimeTemperatureWindow (halfTimeTemperature.data(), N, M);
   // Half-time U-Offset temperature data (Mx(N-1) lateral offset grid)
-  static DataWindow<double> halfTimeUOffsetTemperatureWindow (new double[M * (N - 1)], N - 1, M);
+  DataWindow<double> halfTimeUOffsetTemperatureWindow (halfTimeUOffsetTemperature.data(), N - 1, M);
   // Half-time V-offset temperature data ((M-1)xN transverse offset grid)
-  static DataWindow<double> halfTimeVOffsetTemperatureWindow (new double[(M - 1) * N], N, M - 1);
+  DataWindow<double> halfTimeVOffsetTemperatureWindow (halfTimeVOffsetTemperature.data(), N, M - 1);
 
   // Half-time Forcing Data (for use in the Stokes solve)
-  static double * halfTimeForcingData = new double[2 * M * N - M - N];
+  double * halfTimeForcingData = halfTimeForcing.data();
   // Half-time U forcing data (Mx(N-1) lateral offset grid)
-  static double * halfTimeUForcingData = halfTimeForcingData;
-  static DataWindow<double> halfTimeUForcingWindow (halfTimeUForcingData, N - 1, M);
+  double * halfTimeUForcingData = halfTimeForcingData;
+  DataWindow<double> halfTimeUForcingWindow (halfTimeUForcingData, N - 1, M);
   // Half-time V forcing data ((M-1)xN transverse offset grid)
-  static double * halfTimeVForcingData = halfTimeForcingData + M * (N - 1);
-  static DataWindow<double> halfTimeVForcingWindow (halfTimeVForcingData, N, M - 1);
+  double * halfTimeVForcingData = halfTimeForcingData + M * (N - 1);
+  DataWindow<double> halfTimeVForcingWindow (halfTimeVForcingData, N, M - 1);
 
   // Half-time Stokes solution data (for use in the Stokes solve)
-  static double * halfTimeStokesSolnData = new double[3 * M * N - M - N];
+  double * halfTimeStokesSolnData = halfTimeStokesSoln.data();
   // Half-time U velocity data (Mx(N-1) lateral offset grid)
-  static double * halfTimeUVelocityData = halfTimeStokesSolnData;
-  static DataWindow<double> halfTimeUVelocityWindow (halfTimeUVelocityData, N - 1, M);
+  double * halfTimeUVelocityData = halfTimeStokesSolnData;
+  DataWindow<double> halfTimeUVelocityWindow (halfTimeUVelocityData, N - 1, M);
   // Half-time V velocity data ((M-1)xN transverse offset grid)
-  static double * halfTimeVVelocityData = halfTimeStokesSolnData + M * (N - 1);
-  static DataWindow<double> halfTimeVVelocityWindow (halfTimeVVelocityData, N, M - 1);
-  // Half-time pressure data (MxN cell-centered grid) (not technically necessary)
-  static double * halfTimePressureData = halfTimeStokesSolnData + 2 * M * N - M - N;
-  static DataWindow<double> halfTimePressureWindow (halfTimePressureData, N, M);
+  double * halfTimeVVelocityData = halfTimeStokesSolnData + M * (N - 1);
+  DataWindow<double> halfTimeVVelocityWindow (halfTimeVVelocityData, N, M - 1);
 
   // Cell-centered velocities
-  static double * cellCenteredVelocityData = new double[2 * M * N];
+  double * cellCenteredVelocityData = cellCenteredVelocity.data();
   // Cell-centered U velocity (MxN cell-centered grid)
-  static double * cellCenteredUVelocityData = cellCenteredVelocityData;
-  static DataWindow<double> cellCenteredUVelocityWindow (cellCenteredUVelocityData, N, M);
+  double * cellCenteredUVelocityData = cellCenteredVelocityData;
+  DataWindow<double> cellCenteredUVelocityWindow (cellCenteredUVelocityData, N, M);
   // Cell-centered V velocity (MxN cell-centered grid)
-  static double * cellCenteredVVelocityData = cellCenteredVelocityData + M * N;
-  static DataWindow<double> cellCenteredVVelocityWindow (cellCenteredVVelocityData, N, M);
+  double * cellCenteredVVelocityData = cellCenteredVelocityData + M * N;
+  DataWindow<double> cellCenteredVVelocityWindow (cellCenteredVVelocityData, N, M);
 
   Map<VectorXd> halfTimeStokesSolnVector (halfTimeStokesSolnData, 3 * M * N - M - N);
-  VectorXd temporaryTemperature = Map<VectorXd> (geometry.getTemperatureData(), N * M);
+  Map<VectorXr> temporaryTemperature (geometry.getTemperatureData(), N * M);
+  // Updated temperature data (MxN cell-centered grid)
+  DataWindow<Real> nextTemperatureWindow (geometry.getTemperatureBackData(), N, M);
 
   double leftNeighborT, rightNeighborT, bottomNeighborT, topNeighborT;
 
@@ -219,8 +253,8 @@ void ProblemStructure::frommMethod() {
 
         halfTimeUOffsetTemperatureWindow (j, i) +=
             temperatureWindow (j, i) +
-              (h / 2 - deltaT / 2 * cellCenteredUVelocityWindow (j, i)) *
-                (rightNeighborT - leftNeighborT) / (2 * h);
+              (hx / 2 - deltaT / 2 * cellCenteredUVelocityWindow (j, i)) *
+                (rightNeighborT - leftNeighborT) / (2 * hx);
       }
 
       // One or both velocities are negative. Take the flux from the right
@@ -235,8 +269,8 @@ void ProblemStructure::frommMethod() {
 
         halfTimeUOffsetTemperatureWindow (j, i) +=
             temperatureWindow (j + 1, i) -
-              (h / 2 + deltaT / 2 * cellCenteredUVelocityWindow (j + 1, i)) *
-                (rightNeighborT - leftNeighborT) / (2 * h);
+              (hx / 2 + deltaT / 2 * cellCenteredUVelocityWindow (j + 1, i)) *
+                (rightNeighborT - leftNeighborT) / (2 * hx);
 
       }
 
@@ -287,8 +321,8 @@ void ProblemStructure::frommMethod() {
 
         halfTimeVOffsetTemperatureWindow (j, i) +=
             temperatureWindow (j, i) -
-              (h / 2 + deltaT / 2 * cellCenteredVVelocityWindow (j, i)) *
-               (topNeighborT - bottomNeighborT) / (2 * h);
+              (hy / 2 + deltaT / 2 * cellCenteredVVelocityWindow (j, i)) *
+               (topNeighborT - bottomNeighborT) / (2 * hy);
       }
 
       // One or both velocities are negative. Take the flux from the top
@@ -303,8 +337,8 @@ void ProblemStructure::frommMethod() {
 
         halfTimeVOffsetTemperatureWindow (j, i) +=
             temperatureWindow (j, i + 1) +
-              (h / 2 - deltaT / 2 * cellCenteredVVelocityWindow (j, i + 1)) *
-               (topNeighborT - bottomNeighborT) / (2 * h);
+              (hy / 2 - deltaT / 2 * cellCenteredVVelocityWindow (j, i + 1)) *
+               (topNeighborT - bottomNeighborT) / (2 * hy);
       }
 
       // Velocities are in opposing directions. Take the average of the fluxes
@@ -325,11 +359,11 @@ void ProblemStructure::frommMethod() {
 
   for (int i = 0; i < M; ++i) {
     for (int j = 0; j < N; ++j) {
-      double diffusionWeight = 4;
+      double xDiffusionWeight = 2;
       if (j == 0) {
         leftHalfTimeNeighborT = temperatureWindow (j, i);
         leftNeighborT         = temperatureWindow (j, i);
-        diffusionWeight = 3;
+        xDiffusionWeight = 1;
       } else {
         leftHalfTimeNeighborT = halfTimeUOffsetTemperatureWindow (j - 1, i);
         leftNeighborT         = temperatureWindow (j - 1, i);
@@ -337,7 +371,7 @@ void ProblemStructure::frommMethod() {
       if (j == (N - 1)) {
         rightHalfTimeNeighborT = temperatureWindow (j, i);
         rightNeighborT         = temperatureWindow (j, i);
-        diffusionWeight = 3;
+        xDiffusionWeight = 1;
       } else {
         rightHalfTimeNeighborT = halfTimeUOffsetTemperatureWindow (j, i);
         rightNeighborT         = temperatureWindow (j + 1, i);
@@ -362,9 +396,10 @@ void ProblemStructure::frommMethod() {
       halfTimeTemperatureWindow (j, i) =
         (rightHalfTimeNeighborT + leftHalfTimeNeighborT +
          topHalfTimeNeighborT + bottomHalfTimeNeighborT) / 4 -
-         (diffusionWeight * temperatureWindow (j, i) +
-           leftNeighborT + rightNeighborT + bottomNeighborT + topNeighborT)
-         * deltaT * diffusivity / (h * h);
+         ((xDiffusionWeight * temperatureWindow (j, i) + leftNeighborT + rightNeighborT)
+           * deltaT * diffusivity / (hx * hx) +
+          (2 * temperatureWindow (j, i) + bottomNeighborT + topNeighborT)
+           * deltaT * diffusivity / (hy * hy));
     }
   }
 
@@ -378,11 +413,11 @@ void ProblemStructure::frommMethod() {
     // Benchmark taken from Tau (1991; JCP Vol. 99)
     for (int i = 0; i < M; ++i)
       for (int j = 0; j < N - 1; ++j)
-        halfTimeUForcingWindow (j, i) = 3 * cos ((j + 1) * h) * sin ((i + 0.5) * h);
+        halfTimeUForcingWindow (j, i) = 3 * cos ((j + 1) * hx) * sin ((i + 0.5) * hy);
 
     for (int i = 0; i < M - 1; ++i)
       for (int j = 0; j < N; ++j)
-        halfTimeVForcingWindow (j, i) = -sin ((j + 0.5) * h) * cos ((i + 1) * h);
+        halfTimeVForcingWindow (j, i) = -sin ((j + 0.5) * hx) * cos ((i + 1) * hy);
 
   } else if (forcingModel == "solCXBenchmark" ||
              forcingModel == "solKZBenchmark") {
@@ -393,16 +428,16 @@ void ProblemStructure::frommMethod() {
 
     for (int i = 0; i < M - 1; ++i)
       for (int j = 0; j < N; ++j)
-        halfTimeVForcingWindow (j, i) = - sin((i + 0.5) * pi * h) * cos ((j + 1) * pi * h);
+        halfTimeVForcingWindow (j, i) = - sin((i + 0.5) * pi * hy) * cos ((j + 1) * pi * hx);
 
   } else if (forcingModel == "vorticalFlow") {
     for (int i = 0; i < M; ++i)
       for (int j = 0; j < (N - 1); ++j)
-        halfTimeUForcingWindow (j, i) = 3 * cos ((j + 1) * 2 * h) * sin ((i + 0.5) * 2 * h);
+        halfTimeUForcingWindow (j, i) = 3 * cos ((j + 1) * 2 * hx) * sin ((i + 0.5) * 2 * hy);
 
     for (int i = 0; i < (M - 1); ++i)
       for (int j = 0; j < N; ++j)
-        halfTimeVForcingWindow (j, i) = -sin ((j + 0.5) * h) * cos ((i + 1) * h);
+        halfTimeVForcingWindow (j, i) = -sin ((j + 0.5) * hx) * cos ((i + 1) * hy);
 
   } else if (forcingModel == "buoyancy") {
     double referenceTemperature;
@@ -456,29 +491,10 @@ void ProblemStructure::frommMethod() {
     cout << halfTimeVForcingWindow.displayMatrix() << endl << endl;
   #endif
 
-  // Initialize half-time solver
-  static SparseMatrix<double> stokesMatrix   (3 * M * N - M - N, 3 * M * N - M - N);
-  static SparseMatrix<double> forcingMatrix  (3 * M * N - M - N, 2 * M * N - M - N);
-  static SparseMatrix<double> boundaryMatrix (3 * M * N - M - N, 2 * M + 2 * N);
-  static SparseLU<SparseMatrix<double>, COLAMDOrdering<int> > solver;
-
-  static bool initialized;
-
-  if (!(initialized) || !(viscosityModel=="constant")) {
-
-    double * viscosityData = geometry.getViscosityData();
-
-    SparseForms::makeStokesMatrix (stokesMatrix, M, N, h, viscosityData);
-    stokesMatrix.makeCompressed();
-    SparseForms::makeForcingMatrix (forcingMatrix, M, N);
-    forcingMatrix.makeCompressed();
-    SparseForms::makeBoundaryMatrix (boundaryMatrix, M, N, h, viscosityData);
-    boundaryMatrix.makeCompressed();
-
-    solver.analyzePattern (stokesMatrix);
-    solver.factorize      (stokesMatrix);
-
-    initialized = true;
+  // The half-time solve shares the Stokes system factored by solveStokes()
+  // for the current viscosity field.
+  if (!stokes->initialized) {
+    factorStokesSystem();
 
     #ifdef DEBUG
       cout << "<Viscosity Data>" << endl;
@@ -495,9 +511,16 @@ void ProblemStructure::frommMethod() {
   #endif
 
   // Solve stokes at the half-time to find velocities
-  halfTimeStokesSolnVector = solver.solve
-           (forcingMatrix  * Map<VectorXd>(halfTimeForcingData, 2 * M * N - M - N) +
-            boundaryMatrix * Map<VectorXd>(geometry.getVelocityBoundaryData(), 2 * M + 2 * N));
+  #ifndef USE_DENSE
+  halfTimeStokesSolnVector = stokes->solver.solve
+           (stokes->forcingMatrix  * Map<VectorXd>(halfTimeForcingData, 2 * M * N - M - N) +
+            stokes->boundaryMatrix * Map<VectorXd>(geometry.getVelocityBoundaryData(), 2 * M + 2 * N),
+            stokesInitialGuess (time + deltaT / 2));
+  #else
+  halfTimeStokesSolnVector = stokes->solver.solve
+           (stokes->forcingMatrix  * Map<VectorXd>(halfTimeForcingData, 2 * M * N - M - N) +
+            stokes->boundaryMatrix * Map<VectorXd>(geometry.getVelocityBoundaryData(), 2 * M + 2 * N));
+  #endif
 
   for (int i = 0; i < M; i++)
     for (int j = 0; j < (N - 1); j++)
@@ -519,6 +542,14 @@ void ProblemStructure::frommMethod() {
 
   double leftVelocity, rightVelocity, bottomVelocity, topVelocity;
 
+  // Initialize the flux limiter to point to the desired limiter function.
+  double (ProblemStructure::*limiter) (double,double,double) = &ProblemStructure::minmod;
+  if (fluxLimiter == "superbee") {
+    limiter = &ProblemStructure::superbee;
+  } else if (fluxLimiter == "vanLeer") {
+    limiter = &ProblemStructure::vanLeer;
+  }
+
   // Solve for full-time temperature
   for (int i = 0; i < M; ++i) {
     for (int j = 0; j < N; ++j) {
@@ -553,20 +584,6 @@ void ProblemStructure::frommMethod() {
         topVelocity = halfTimeVVelocityWindow (j, i);
       }
 
-      // Initialize the flux limiter to point to the desired limiter function.
-      static double (ProblemStructure::*limiter) (double,double,double) = NULL;
-      if (limiter == NULL) {
-        if (fluxLimiter == "minmod") {
-          limiter = &ProblemStructure::minmod;
-        } else if (fluxLimiter == "superbee") {
-          limiter = &ProblemStructure::superbee;
-        } else if (fluxLimiter == "vanLeer") {
-          limiter = &ProblemStructure::vanLeer;
-        } else if (fluxLimiter == "none") {
-          limiter = &ProblemStructure::minmod;
-        }
-      }
-
       double leftFirstOrderT = 0, rightFirstOrderT = 0,
              bottomFirstOrderT = 0, topFirstOrderT = 0,
              secondLeftFirstOrderT = 0, secondBottomFirstOrderT = 0;
@@ -593,10 +610,10 @@ void ProblemStructure::frommMethod() {
 
         if (j > 0) {
           if (leftFirstOrderVelocity < 0) {
-            leftFlux = temporaryTemperature (i * N + j) * leftFirstOrderVelocity * deltaT / h;
+            leftFlux = temporaryTemperature (i * N + j) * leftFirstOrderVelocity * deltaT / hx;
             leftFirstOrderT = temporaryTemperature (i * N + j);
           } else {
-            leftFlux = temporaryTemperature (i * N + (j - 1)) * leftFirstOrderVelocity * deltaT / h;
+            leftFlux = temporaryTemperature (i * N + (j - 1)) * leftFirstOrderVelocity * deltaT / hx;
             leftFirstOrderT = temporaryTemperature (i * N + (j - 1));
           }
         }
@@ -610,20 +627,20 @@ void ProblemStructure::frommMethod() {
 
         if (j < (N - 1)) {
           if (rightFirstOrderVelocity > 0) {
-            rightFlux = temporaryTemperature (i * N + j) * rightFirstOrderVelocity * deltaT / h;
+            rightFlux = temporaryTemperature (i * N + j) * rightFirstOrderVelocity * deltaT / hx;
             rightFirstOrderT = temporaryTemperature (i * N + j);
           } else {
-            rightFlux = temporaryTemperature (i * N + (j + 1)) * rightFirstOrderVelocity * deltaT / h;
+            rightFlux = temporaryTemperature (i * N + (j + 1)) * rightFirstOrderVelocity * deltaT / hx;
             rightFirstOrderT = temporaryTemperature (i * N + (j + 1));
           }
         }
 
         if (i > 0) {
           if (bottomFirstOrderVelocity < 0) {
-            bottomFlux = temporaryTemperature (i * N + j) * bottomFirstOrderVelocity * deltaT / h;
+            bottomFlux = temporaryTemperature (i * N + j) * bottomFirstOrderVelocity * deltaT / hy;
             bottomFirstOrderT = temporaryTemperature (i * N + j);
           } else {
-            bottomFlux = temporaryTemperature ((i - 1) * N + j) * bottomFirstOrderVelocity * deltaT / h;
+            bottomFlux = temporaryTemperature ((i - 1) * N + j) * bottomFirstOrderVelocity * deltaT / hy;
             bottomFirstOrderT = temporaryTemperature ((i - 1) * N + j);
           }
         }
@@ -636,10 +653,10 @@ void ProblemStructure::frommMethod() {
 
         if (i < (M - 1)) {
           if (topFirstOrderVelocity > 0) {
-            topFlux = temporaryTemperature (i * N + j) * topFirstOrderVelocity * deltaT / h;
+            topFlux = temporaryTemperature (i * N + j) * topFirstOrderVelocity * deltaT / hy;
             topFirstOrderT = temporaryTemperature (i * N + j);
           } else {
-            topFlux = temporaryTemperature ((i + 1) * N + j) * topFirstOrderVelocity * deltaT / h;
+            topFlux = temporaryTemperature ((i + 1) * N + j) * topFirstOrderVelocity * deltaT / hy;
             topFirstOrderT = temporaryTemperature ((i + 1) * N + j);
           }
         }
@@ -658,16 +675,16 @@ void ProblemStructure::frommMethod() {
                                           topFirstOrderT);
 
         lateralFlux =
-            ((1 - leftPhi) * leftFlux + leftPhi * (leftVelocity * leftNeighborT * deltaT / h)) -
-            ((1 - rightPhi) * rightFlux + rightPhi * rightVelocity * rightNeighborT * deltaT / h);
-        transverseFlux = ((1 - bottomPhi) * bottomFlux + bottomPhi * bottomVelocity * bottomNeighborT * deltaT / h) -
-                         ((1 - topPhi) * topFlux + topPhi * topVelocity * topNeighborT * deltaT / h);
+            ((1 - leftPhi) * leftFlux + leftPhi * (leftVelocity * leftNeighborT * deltaT / hx)) -
+            ((1 - rightPhi) * rightFlux + rightPhi * rightVelocity * rightNeighborT * deltaT / hx);
+        transverseFlux = ((1 - bottomPhi) * bottomFlux + bottomPhi * bottomVelocity * bottomNeighborT * deltaT / hy) -
+                         ((1 - topPhi) * topFlux + topPhi * topVelocity * topNeighborT * deltaT / hy);
 
-        temperatureWindow (j, i) = temporaryTemperature (i * N + j) + transverseFlux + lateralFlux;
+        nextTemperatureWindow (j, i) = temporaryTemperature (i * N + j) + transverseFlux + lateralFlux;
       } else
-        temperatureWindow (j, i) = temporaryTemperature (i * N + j) + deltaT / h * (leftVelocity * leftNeighborT - rightVelocity * rightNeighborT) + deltaT / h * (bottomVelocity * bottomNeighborT - topVelocity * topNeighborT);
+        nextTemperatureWindow (j, i) = temporaryTemperature (i * N + j) + deltaT / hx * (leftVelocity * leftNeighborT - rightVelocity * rightNeighborT) + deltaT / hy * (bottomVelocity * bottomNeighborT - topVelocity * topNeighborT);
 
-      if (std::isnan((double)temperatureWindow (j, i))) {
+      if (std::isnan((double)nextTemperatureWindow (j, i))) {
         std::ostringstream error_stream;
         error_stream << "Found NaN";
         #ifdef DEBUG
@@ -690,8 +707,335 @@ void ProblemStructure::frommMethod() {
     }
   }
 
+  geometry.swapTemperatureBuffers();
+
   #ifdef DEBUG
     cout << "<Full-Time Temperature Data>" << endl;
-    cout << temperatureWindow.displayMatrix() << endl << endl;
+    cout << nextTemperatureWindow.displayMatrix() << endl << endl;
+  #endif
+}
+
+/*
+ *
+ * Semi-Lagrangian advection helpers
+ *
+ */
+
+// Temperature at cell (column, row), extended with the insulated side
+// boundaries and the prescribed lower and upper boundary temperatures in the
+// ghost rows -1 and M.
+static double extendedTemperature (DataWindow<Real> &temperatureWindow,
+                                   DataWindow<Real> &temperatureBoundaryWindow,
+                                   const GridIndex M, const GridIndex N,
+                                   int column, const int row) {
+  column = max<GridIndex> (0, min<GridIndex> (N - 1, column));
+  if (row < 0)
+    return temperatureBoundaryWindow (column, 0);
+  if (row > (M - 1))
+    return temperatureBoundaryWindow (column, 1);
+  return temperatureWindow (column, row);
+}
+
+// Compositional field values of cell (column, row), clamped to the domain
+// since compositions have no prescribed boundary values.
+static const Real * compositionCell (const Real * compositionData,
+                                       const int K, const GridIndex M, const GridIndex N,
+                                       const int column, const int row) {
+  return compositionData +
+         (max<GridIndex> (0, min<GridIndex> (M - 1, row)) * N +
+          max<GridIndex> (0, min<GridIndex> (N - 1, column))) * K;
+}
+
+// Monotone cubic Hermite interpolation between f1 and f2 at t in [0, 1], with
+// harmonic-mean (Fritsch-Butland) slopes so the result stays within [f1, f2].
+static double monotoneCubic (const double f0, const double f1,
+                             const double f2, const double f3,
+                             const double t) {
+  double d0 = f1 - f0, d1 = f2 - f1, d2 = f3 - f2;
+  double m1 = (d0 * d1 > 0) ? 2 * d0 * d1 / (d0 + d1) : 0;
+  double m2 = (d1 * d2 > 0) ? 2 * d1 * d2 / (d1 + d2) : 0;
+
+  double t2 = t * t, t3 = t2 * t;
+  return (2 * t3 - 3 * t2 + 1) * f1 + (t3 - 2 * t2 + t) * m1 +
+         (-2 * t3 + 3 * t2) * f2 + (t3 - t2) * m2;
+}
+
+// Semi-Lagrangian advection. Traces the characteristic through each cell
+// center back over one time step with the midpoint rule and interpolates the
+// temperature at its departure point. Stable for any Courant number.
+void ProblemStructure::semiLagrangian() {
+  DataWindow<Real> temperatureWindow (geometry.getTemperatureData(), N, M);
+  DataWindow<Real> temperatureBoundaryWindow (geometry.getTemperatureBoundaryData(), N, 2);
+  DataWindow<Real> nextTemperatureWindow (geometry.getTemperatureBackData(), N, M);
+
+  DataWindow<double> uVelocityWindow (geometry.getUVelocityData(), N - 1, M);
+  DataWindow<double> vVelocityWindow (geometry.getVVelocityData(), N, M - 1);
+  DataWindow<double> uVelocityBoundaryWindow (geometry.getUVelocityBoundaryData(), 2, M);
+  DataWindow<double> vVelocityBoundaryWindow (geometry.getVVelocityBoundaryData(), N, 2);
+
+  // The compositional fields share the traced characteristics and
+  // interpolation weights of the temperature.
+  const int K = geometry.getK();
+  const Real * compositionData = geometry.getCompositionData();
+  Real * nextCompositionData   = geometry.getCompositionBackData();
+
+  const bool cubic = (semiLagrangianInterpolation == "monotoneCubic");
+  if (!cubic && semiLagrangianInterpolation != "bilinear")
+    THROW_WITH_TRACE(RuntimeError() <<
+            errmsg_info("Unexpected interpolation: '" + semiLagrangianInterpolation + "'."));
+
+  #ifdef USE_OPENMP
+  #pragma omp parallel for schedule(static)
+  #endif
+  for (int i = 0; i < M; ++i) {
+    for (int j = 0; j < N; ++j) {
+      double x = (j + 0.5) * hx;
+      double y = (i + 0.5) * hy;
+
+      // Midpoint rule for the departure point, kept inside the domain.
+      double xMid = x - deltaT / 2 * interpolateUVelocity (uVelocityWindow, uVelocityBoundaryWindow, M, N, hx, hy, x, y);
+      double yMid = y - deltaT / 2 * interpolateVVelocity (vVelocityWindow, vVelocityBoundaryWindow, M, N, hx, hy, x, y);
+      xMid = max (0.0, min (xExtent, xMid));
+      yMid = max (0.0, min (yExtent, yMid));
+
+      double xDeparture = x - deltaT * interpolateUVelocity (uVelocityWindow, uVelocityBoundaryWindow, M, N, hx, hy, xMid, yMid);
+      double yDeparture = y - deltaT * interpolateVVelocity (vVelocityWindow, vVelocityBoundaryWindow, M, N, hx, hy, xMid, yMid);
+      xDeparture = max (0.0, min (xExtent, xDeparture));
+      yDeparture = max (0.0, min (yExtent, yDeparture));
+
+      // Position in cell-center coordinates; rows -1 and M are the
+      // boundary temperatures.
+      double fx = xDeparture / hx - 0.5;
+      double fy = yDeparture / hy - 0.5;
+      int column = int (floor (fx));
+      int row    = int (floor (fy));
+      double tx = fx - column;
+      double ty = fy - row;
+
+      if (cubic) {
+        double rowValues[4];
+        for (int di = 0; di < 4; ++di) {
+          int sampleRow = max<GridIndex> (-1, min<GridIndex> (M, row + di - 1));
+          rowValues[di] = monotoneCubic (
+              extendedTemperature (temperatureWindow, temperatureBoundaryWindow, M, N, column - 1, sampleRow),
+              extendedTemperature (temperatureWindow, temperatureBoundaryWindow, M, N, column,     sampleRow),
+              extendedTemperature (temperatureWindow, temperatureBoundaryWindow, M, N, column + 1, sampleRow),
+              extendedTemperature (temperatureWindow, temperatureBoundaryWindow, M, N, column + 2, sampleRow),
+              tx);
+        }
+        nextTemperatureWindow (j, i) = monotoneCubic (rowValues[0], rowValues[1], rowValues[2], rowValues[3], ty);
+      } else {
+        double lower = (1 - tx) * extendedTemperature (temperatureWindow, temperatureBoundaryWindow, M, N, column,     row) +
+                       tx       * extendedTemperature (temperatureWindow, temperatureBoundaryWindow, M, N, column + 1, row);
+        double upper = (1 - tx) * extendedTemperature (temperatureWindow, temperatureBoundaryWindow, M, N, column,     row + 1) +
+                       tx       * extendedTemperature (temperatureWindow, temperatureBoundaryWindow, M, N, column + 1, row + 1);
+        nextTemperatureWindow (j, i) = (1 - ty) * lower + ty * upper;
+      }
+
+      if (K > 0) {
+        Real * nextCell = nextCompositionData + (i * N + j) * K;
+
+        if (cubic) {
+          const Real * cells[4][4];
+          for (int di = 0; di < 4; ++di)
+            for (int dj = 0; dj < 4; ++dj)
+              cells[di][dj] = compositionCell (compositionData, K, M, N, column + dj - 1, row + di - 1);
+
+          for (int f = 0; f < K; ++f) {
+            double rowValues[4];
+            for (int di = 0; di < 4; ++di)
+              rowValues[di] = monotoneCubic (cells[di][0][f], cells[di][1][f],
+                                             cells[di][2][f], cells[di][3][f], tx);
+            nextCell[f] = monotoneCubic (rowValues[0], rowValues[1], rowValues[2], rowValues[3], ty);
+          }
+        } else {
+          const Real * lowerLeft  = compositionCell (compositionData, K, M, N, column,     row);
+          const Real * lowerRight = compositionCell (compositionData, K, M, N, column + 1, row);
+          const Real * upperLeft  = compositionCell (compositionData, K, M, N, column,     row + 1);
+          const Real * upperRight = compositionCell (compositionData, K, M, N, column + 1, row + 1);
+
+          const double wLowerLeft  = (1 - tx) * (1 - ty), wLowerRight = tx * (1 - ty);
+          const double wUpperLeft  = (1 - tx) * ty,       wUpperRight = tx * ty;
+          for (int f = 0; f < K; ++f)
+            nextCell[f] = wLowerLeft * lowerLeft[f] + wLowerRight * lowerRight[f] +
+                          wUpperLeft * upperLeft[f] + wUpperRight * upperRight[f];
+        }
+      }
+    }
+  }
+
+  geometry.swapTemperatureBuffers();
+  if (K > 0)
+    geometry.swapCompositionBuffers();
+}
+
+// Particle-in-cell advection. The tracers first pick up whatever the grid
+// temperature gained since they were last projected (i.e. diffusion), are
+// moved over the step, and are averaged back onto the cells.
+void ProblemStructure::particleInCell() {
+  tracers.applyGridChange (geometry.getTemperatureData());
+  tracers.advect (tracerIntegrator, deltaT,
+                  geometry.getUVelocityData(),
+                  geometry.getVVelocityData(),
+                  geometry.getUVelocityBoundaryData(),
+                  geometry.getVVelocityBoundaryData());
+  tracers.bin();
+  tracers.project (geometry.getTemperatureData(), geometry.getCompositionData());
+}
+
+// Advection on the refined patch hierarchy. As with particleInCell(), the
+// hierarchy first picks up whatever the grid temperature gained since it was
+// last projected; its level 0 then holds the averages of the finer levels.
+void ProblemStructure::refinedAdvection() {
+  hierarchy.applyGridChange (geometry.getTemperatureData());
+  hierarchy.advance (deltaT,
+                     geometry.getUVelocityData(),
+                     geometry.getVVelocityData(),
+                     geometry.getUVelocityBoundaryData(),
+                     geometry.getVVelocityBoundaryData());
+  hierarchy.project (geometry.getTemperatureData());
+
+  #ifdef DEBUG
+    cout << "<Advected " << hierarchy.getCellUpdates() << " cells on "
+         << refinementLevels << " levels>" << endl;
+  #endif
+}
+
+// Upwind advection with local time steps. The compositional fields are
+// carried in the same sweeps, on the same levels.
+void ProblemStructure::multirateUpwind() {
+  if (multirateSolver.getM() != M || multirateSolver.getN() != N)
+    multirateSolver.setup (M, N, cellWidths.data(), cellHeights.data(), multirateLevels);
+
+  multirateSolver.step (deltaT, cfl,
+                        geometry.getUVelocityData(),
+                        geometry.getVVelocityData(),
+                        geometry.getTemperatureData(),
+                        geometry.getCompositionData(),
+                        geometry.getK());
+
+  #ifdef DEBUG
+    cout << "<Took " << multirateSolver.getCellUpdates() << " multirate cell updates>" << endl;
+  #endif
+}
+
+// Upwind advection of all K compositional fields in one sweep. The face
+// velocities and upwind directions of each cell are found once and applied
+// to the cell's contiguous block of field values.
+void ProblemStructure::upwindComposition() {
+  const int K = geometry.getK();
+  const Real * compositionData = geometry.getCompositionData();
+  Real * nextCompositionData   = geometry.getCompositionBackData();
+
+  DataWindow<double> uVelocityWindow (geometry.getUVelocityData(), N - 1, M);
+  DataWindow<double> vVelocityWindow (geometry.getVVelocityData(), N, M - 1);
+
+  #ifdef USE_OPENMP
+  #pragma omp parallel for schedule(static)
+  #endif
+  for (int i = 0; i < M; ++i) {
+    const double yCourant = deltaT / cellHeights[i];
+    for (int j = 0; j < N; ++j) {
+      const double xCourant = deltaT / cellWidths[j];
+      // Boundary faces carry no flux, as in upwind().
+      const double leftCoefficient   = (j > 0)       ? uVelocityWindow (j - 1, i) * xCourant : 0;
+      const double rightCoefficient  = (j < (N - 1)) ? uVelocityWindow (j, i)     * xCourant : 0;
+      const double bottomCoefficient = (i > 0)       ? vVelocityWindow (j, i - 1) * yCourant : 0;
+      const double topCoefficient    = (i < (M - 1)) ? vVelocityWindow (j, i)     * yCourant : 0;
+
+      const Real * cell   = compositionData + (i * N + j) * K;
+      const Real * left   = (leftCoefficient   > 0) ? cell - K     : cell;
+      const Real * right  = (rightCoefficient  < 0) ? cell + K     : cell;
+      const Real * bottom = (bottomCoefficient > 0) ? cell - N * K : cell;
+      const Real * top    = (topCoefficient    < 0) ? cell + N * K : cell;
+
+      Real * nextCell = nextCompositionData + (i * N + j) * K;
+      for (int f = 0; f < K; ++f)
+        nextCell[f] = cell[f] +
+                      leftCoefficient   * left[f]   - rightCoefficient * right[f] +
+                      bottomCoefficient * bottom[f] - topCoefficient   * top[f];
+    }
+  }
+
+  geometry.swapCompositionBuffers();
+}
+
+// Flux-limited second order advection of all K compositional fields in one
+// sweep. The flux through each face blends the upwind value with the
+// Lax-Wendroff face value
+//   T_u + (1 - |c|) / 2 (T_d - T_u)
+// of its upwind and downwind cells, by the fluxLimiter of the ratio of the
+// upwind and local jumps, as frommMethod() does for the temperature. Faces
+// next to a wall have no second upwind cell and fall back to first order.
+void ProblemStructure::frommComposition (const double * uVelocity, const double * vVelocity) {
+  const int K = geometry.getK();
+  const Real * compositionData = geometry.getCompositionData();
+  Real * nextCompositionData   = geometry.getCompositionBackData();
+
+  DataWindow<const double> uVelocityWindow (uVelocity, N - 1, M);
+  DataWindow<const double> vVelocityWindow (vVelocity, N, M - 1);
+
+  double (ProblemStructure::*limiter) (double,double,double) = &ProblemStructure::minmod;
+  if (fluxLimiter == "superbee") {
+    limiter = &ProblemStructure::superbee;
+  } else if (fluxLimiter == "vanLeer") {
+    limiter = &ProblemStructure::vanLeer;
+  }
+  const bool limited = (fluxLimiter != "none");
+
+  // Amount of field f moved through a face of Courant number 'courant'
+  // (signed along the face normal) from cell 'upwind' into cell 'downwind',
+  // with 'farUpwind' the next cell upwind.
+  auto faceFlux = [&] (const double courant, const Real * farUpwind,
+                       const Real * upwind, const Real * downwind, const int f) -> double {
+    const double phi = limited ? (this->*limiter) (farUpwind[f], upwind[f], downwind[f]) : 1;
+    return courant * (upwind[f] + phi * (1 - abs (courant)) / 2 * (downwind[f] - upwind[f]));
+  };
+
+  #ifdef USE_OPENMP
+  #pragma omp parallel for schedule(static)
   #endif
+  for (int i = 0; i < M; ++i) {
+    for (int j = 0; j < N; ++j) {
+      // Boundary faces carry no flux, as in upwind().
+      const double leftCourant   = (j > 0)       ? uVelocityWindow (j - 1, i) * deltaT / hx : 0;
+      const double rightCourant  = (j < (N - 1)) ? uVelocityWindow (j, i)     * deltaT / hx : 0;
+      const double bottomCourant = (i > 0)       ? vVelocityWindow (j, i - 1) * deltaT / hy : 0;
+      const double topCourant    = (i < (M - 1)) ? vVelocityWindow (j, i)     * deltaT / hy : 0;
+
+      auto cellAt = [&] (const int row, const int column) -> const Real * {
+        return compositionData + (row * N + column) * K;
+      };
+      const Real * cell = cellAt (i, j);
+
+      // The cells upwind of each face, and the next ones beyond them (the
+      // upwind cell itself at a wall).
+      const Real * leftUpwind    = (leftCourant > 0)   ? cellAt (i, max<int> (j - 1, 0)) : cell;
+      const Real * leftDownwind  = (leftCourant > 0)   ? cell : cellAt (i, max<int> (j - 1, 0));
+      const Real * leftFar       = (leftCourant > 0)   ? ((j > 1)       ? cellAt (i, j - 2) : leftUpwind) :
+                                                         ((j < (N - 1)) ? cellAt (i, j + 1) : leftUpwind);
+      const Real * rightUpwind   = (rightCourant > 0)  ? cell : cellAt (i, min<int> (j + 1, N - 1));
+      const Real * rightDownwind = (rightCourant > 0)  ? cellAt (i, min<int> (j + 1, N - 1)) : cell;
+      const Real * rightFar      = (rightCourant > 0)  ? ((j > 0)       ? cellAt (i, j - 1) : rightUpwind) :
+                                                         ((j < (N - 2)) ? cellAt (i, j + 2) : rightUpwind);
+      const Real * bottomUpwind   = (bottomCourant > 0) ? cellAt (max<int> (i - 1, 0), j) : cell;
+      const Real * bottomDownwind = (bottomCourant > 0) ? cell : cellAt (max<int> (i - 1, 0), j);
+      const Real * bottomFar      = (bottomCourant > 0) ? ((i > 1)       ? cellAt (i - 2, j) : bottomUpwind) :
+                                                          ((i < (M - 1)) ? cellAt (i + 1, j) : bottomUpwind);
+      const Real * topUpwind      = (topCourant > 0)    ? cell : cellAt (min<int> (i + 1, M - 1), j);
+      const Real * topDownwind    = (topCourant > 0)    ? cellAt (min<int> (i + 1, M - 1), j) : cell;
+      const Real * topFar         = (topCourant > 0)    ? ((i > 0)       ? cellAt (i - 1, j) : topUpwind) :
+                                                          ((i < (M - 2)) ? cellAt (i + 2, j) : topUpwind);
+
+      Real * nextCell = nextCompositionData + (i * N + j) * K;
+      for (int f = 0; f < K; ++f)
+        nextCell[f] = cell[f] +
+                      faceFlux (leftCourant,   leftFar,   leftUpwind,   leftDownwind,   f) -
+                      faceFlux (rightCourant,  rightFar,  rightUpwind,  rightDownwind,  f) +
+                      faceFlux (bottomCourant, bottomFar, bottomUpwind, bottomDownwind, f) -
+                      faceFlux (topCourant,    topFar,    topUpwind,    topDownwind,    f);
+    }
+  }
+
+  geometry.swapCompositionBuffers();
 }
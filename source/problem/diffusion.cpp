@@ -4,6 +4,7 @@
 #include <Eigen/Dense>
 
 #include "matrixForms/sparseForms.h"
+#include "geometry/dataWindow.h"
 #include "geometry/geometry.h"
 #include "problem/problem.h"
 #include "debug.h"
@@ -13,83 +14,100 @@ using namespace std;
 
 // Forward Euler diffusion method. Unstable but fairly efficient.
 void ProblemStructure::forwardEuler() {
-  Map<VectorXd> temperatureVector (geometry.getTemperatureData(), M * N);
-  Map<VectorXd> temperatureBoundaryVector (geometry.getTemperatureBoundaryData(), 2 * M);
-
-  double mu = deltaT * diffusivity / (h * h);
-
-  SparseMatrix<double> rhs;
-  SparseMatrix<double> rhsBoundary;
-  rhs.resize (M * N, M * N);
-  rhsBoundary.resize (M * N, 2 * N);
-
-  vector<Triplet<double> > tripletList;
-  tripletList.reserve (5 * M * N);
-
-  for (int i = 0; i < M; i++)
-    for (int j = 0; j < N; ++j) {
-      if ((j == 0) || (j == (N - 1)))
-        tripletList.push_back (Triplet<double> (i * N + j, i * N + j, 1 - 3 * mu)); 
-      else
-        tripletList.push_back (Triplet<double> (i * N + j, i * N + j, 1 - 4 * mu));
-      if (j > 0) 
-        tripletList.push_back (Triplet<double> (i * N + j, i * N + (j - 1), mu));
-      if (j < (N - 1)) 
-        tripletList.push_back (Triplet<double> (i * N + j, i * N + (j + 1), mu));
-      if (i > 0)
-        tripletList.push_back (Triplet<double> (i * N + j, (i - 1) * N + j, mu));
-      if (i < (M - 1))
-        tripletList.push_back (Triplet<double> (i * N + j, (i + 1) * N + j, mu));
-    }
-
-  rhs.setFromTriplets (tripletList.begin(), tripletList.end());
-  rhs.makeCompressed();
-
-  tripletList.clear();
-  tripletList.reserve (2 * N);
-
-  for (int j = 0; j < N; ++j) {
-    tripletList.push_back (Triplet<double> (j,               j,     mu));
-    tripletList.push_back (Triplet<double> ((M - 1) * N + j, N + j, mu));
+  // As in upwindMethod(), only this process' block is updated.
+  Decomposition &decomposition = geometry.getDecomposition();
+
+  const Real * temperature = geometry.getTemperatureData();
+  Real * nextTemperature = geometry.getTemperatureBackData();
+  DataWindow<Real> temperatureBoundaryWindow (geometry.getTemperatureBoundaryData(), N, 2);
+
+  vector<double> muLeft, muRight, muBottom, muTop;
+  diffusionNumbers (deltaT * diffusivity, muLeft, muRight, muBottom, muTop);
+
+  /* The five-point update, with insulated sides and the top and bottom
+   * boundary temperatures. Each cell accumulates in double precision, in the
+   * order of the sparse matrix product this replaces. */
+  auto updateCell = [&] (const GridIndex i, const GridIndex j) {
+    double value = 0;
+    if (i > 0)
+      value += muBottom[i] * temperature[decomposition.cell (i - 1, j)];
+    if (j > 0)
+      value += muLeft[j] * temperature[decomposition.cell (i, j - 1)];
+    value += (1 - (muLeft[j] + muRight[j]) - (muBottom[i] + muTop[i])) * temperature[decomposition.cell (i, j)];
+    if (j < (N - 1))
+      value += muRight[j] * temperature[decomposition.cell (i, j + 1)];
+    if (i < (M - 1))
+      value += muTop[i] * temperature[decomposition.cell (i + 1, j)];
+
+    if (i == 0)
+      value += muBottom[0] * temperatureBoundaryWindow (j, 0);
+    if (i == (M - 1))
+      value += muTop[M - 1] * temperatureBoundaryWindow (j, 1);
+
+    nextTemperature[decomposition.cell (i, j)] = value;
+  };
+
+  // The cells away from the block edges overlap the halo exchange.
+  decomposition.beginHaloExchange (geometry.getTemperatureData());
+  for (GridIndex i = decomposition.getRowBegin(); i < decomposition.getRowEnd(); ++i)
+    for (GridIndex j = decomposition.getColBegin(); j < decomposition.getColEnd(); ++j)
+      if (!decomposition.onBlockEdge (i, j))
+        updateCell (i, j);
+
+  decomposition.endHaloExchange (geometry.getTemperatureData());
+  if (decomposition.isDistributed()) {
+    for (GridIndex i = decomposition.getRowBegin(); i < decomposition.getRowEnd(); ++i)
+      for (GridIndex j = decomposition.getColBegin(); j < decomposition.getColEnd(); ++j)
+        if (decomposition.onBlockEdge (i, j))
+          updateCell (i, j);
+
+    temperatureDistributed = true;
   }
 
-
-  rhsBoundary.setFromTriplets (tripletList.begin(), tripletList.end());
-  rhsBoundary.makeCompressed();
-
-  VectorXd temporaryVector = temperatureVector;
-  temperatureVector = rhs * temporaryVector + rhsBoundary * temperatureBoundaryVector;
+  geometry.swapTemperatureBuffers();
 }
 
 // Backward Euler Diffusion method. Stable but inefficient.
 void ProblemStructure::backwardEuler() {
-  Map<VectorXd> temperatureVector (geometry.getTemperatureData(), M * N);
-  Map<VectorXd> temperatureBoundaryVector (geometry.getTemperatureBoundaryData(), 2 * N);
+  Map<VectorXr> temperatureVector (geometry.getTemperatureData(), M * N);
+  Map<VectorXr> temperatureBoundaryVector (geometry.getTemperatureBoundaryData(), 2 * N);
+
+  if (spectralDiffusionApplicable()) {
+    double muX = deltaT * diffusivity / (hx * hx);
+    double muY = deltaT * diffusivity / (hy * hy);
 
-  double mu = deltaT * diffusivity / (h * h);
+    Map<VectorXr> nextTemperatureVector (geometry.getTemperatureBackData(), M * N);
+    nextTemperatureVector = temperatureVector;
+    addDiffusionBoundaryTerms (muY, nextTemperatureVector.data());
 
-  SparseMatrix<double> lhs;
-  SparseMatrix<double> rhsBoundary;
+    solveSpectralDiffusion (muX, muY, nextTemperatureVector.data());
+    geometry.swapTemperatureBuffers();
+    return;
+  }
+
+  vector<double> muLeft, muRight, muBottom, muTop;
+  diffusionNumbers (deltaT * diffusivity, muLeft, muRight, muBottom, muTop);
+
+  SparseMatrixXd lhs;
+  SparseMatrixXd rhsBoundary;
   lhs.resize (M * N, M * N);
   rhsBoundary.resize (M * N, 2 * N);
 
-  vector<Triplet<double> > tripletList;
+  vector<TripletXd> tripletList;
   tripletList.reserve (5 * M * N);
 
   for (int i = 0; i < M; i++)
     for (int j = 0; j < N; ++j) {
-      if ((j == 0) || (j == (N - 1)))
-        tripletList.push_back (Triplet<double> (i * N + j, i * N + j, 1 + 3 * mu)); 
-      else
-        tripletList.push_back (Triplet<double> (i * N + j, i * N + j, 1 + 4 * mu));
+      tripletList.push_back (TripletXd (i * N + j, i * N + j,
+                                        1 + (muLeft[j] + muRight[j]) + (muBottom[i] + muTop[i])));
       if (j > 0) 
-        tripletList.push_back (Triplet<double> (i * N + j, i * N + (j - 1), -mu));
+        tripletList.push_back (TripletXd (i * N + j, i * N + (j - 1), -muLeft[j]));
       if (j < (N - 1)) 
-        tripletList.push_back (Triplet<double> (i * N + j, i * N + (j + 1), -mu));
+        tripletList.push_back (TripletXd (i * N + j, i * N + (j + 1), -muRight[j]));
       if (i > 0)
-        tripletList.push_back (Triplet<double> (i * N + j, (i - 1) * N + j, -mu));
+        tripletList.push_back (TripletXd (i * N + j, (i - 1) * N + j, -muBottom[i]));
       if (i < (M - 1))
-        tripletList.push_back (Triplet<double> (i * N + j, (i + 1) * N + j, -mu));
+        tripletList.push_back (TripletXd (i * N + j, (i + 1) * N + j, -muTop[i]));
     }
 
   lhs.setFromTriplets (tripletList.begin(), tripletList.end());
@@ -99,52 +117,82 @@ void ProblemStructure::backwardEuler() {
   tripletList.reserve (2 * N);
 
   for (int j = 0; j < N; ++j) {
-    tripletList.push_back (Triplet<double> (j,               j,     mu));
-    tripletList.push_back (Triplet<double> ((M - 1) * N + j, N + j, mu));
+    tripletList.push_back (TripletXd (j,               j,     muBottom[0]));
+    tripletList.push_back (TripletXd ((M - 1) * N + j, N + j, muTop[M - 1]));
   }
 
   rhsBoundary.setFromTriplets (tripletList.begin(), tripletList.end());
   rhsBoundary.makeCompressed();
 
-  VectorXd temporaryVector = temperatureVector;
+  VectorXd rhsVector = rhsBoundary * temperatureBoundaryVector.cast<double>();
+  rhsVector += temperatureVector.cast<double>();
 
   #ifdef DEBUG
     cout << "<Backward Euler " << lhs.rows() << "x" << lhs.cols() << " LHS Matrix generated>" << endl;
     cout << "<Backward Euler " << rhsBoundary.rows() << "x" << rhsBoundary.cols() << " RHS Boundary Matrix generated>" << endl;
     cout << "<Temperature Boundary Vector has "<< temperatureBoundaryVector.rows() << " elements>" << endl;
   #endif
-  
-  SimplicialLLT<SparseMatrix<double> > solver;
+
+  scaleByCellAreas (lhs, rhsVector);
+
+  SimplicialLLT<SparseMatrixXd > solver;
   solver.compute (lhs);
-  temperatureVector =  solver.solve(temporaryVector + rhsBoundary * temperatureBoundaryVector);
+  temperatureVector = solver.solve (rhsVector).cast<Real>();
 }
 
 void ProblemStructure::crankNicolson() {
-  Map<VectorXd> temperatureVector (geometry.getTemperatureData(), M * N);
-  Map<VectorXd> temperatureBoundaryVector (geometry.getTemperatureBoundaryData(), 2 * M);
+  Map<VectorXr> temperatureVector (geometry.getTemperatureData(), M * N);
+  Map<VectorXr> temperatureBoundaryVector (geometry.getTemperatureBoundaryData(), 2 * N);
+
+  if (spectralDiffusionApplicable()) {
+    double muX = deltaT * diffusivity / (2 * hx * hx);
+    double muY = deltaT * diffusivity / (2 * hy * hy);
+
+    DataWindow<Real> temperatureWindow (geometry.getTemperatureData(), N, M);
+    DataWindow<Real> nextTemperatureWindow (geometry.getTemperatureBackData(), N, M);
+
+    // Explicit half of the step, applied with the same stencil as the
+    // sparse path.
+    for (int i = 0; i < M; ++i)
+      for (int j = 0; j < N; ++j) {
+        double xDiagonal = ((j == 0) || (j == (N - 1))) ? 1 : 2;
+        double xNeighbors = 0, yNeighbors = 0;
+        if (j > 0)       xNeighbors += temperatureWindow (j - 1, i);
+        if (j < (N - 1)) xNeighbors += temperatureWindow (j + 1, i);
+        if (i > 0)       yNeighbors += temperatureWindow (j, i - 1);
+        if (i < (M - 1)) yNeighbors += temperatureWindow (j, i + 1);
+
+        nextTemperatureWindow (j, i) = (1 - xDiagonal * muX - 2 * muY) * temperatureWindow (j, i) +
+                                       muX * xNeighbors + muY * yNeighbors;
+      }
+    addDiffusionBoundaryTerms (2 * muY, geometry.getTemperatureBackData());
+
+    solveSpectralDiffusion (muX, muY, geometry.getTemperatureBackData());
+    geometry.swapTemperatureBuffers();
+    return;
+  }
 
-  double mu = deltaT * diffusivity / (2 * h * h);
+  vector<double> muLeft, muRight, muBottom, muTop;
+  diffusionNumbers (deltaT * diffusivity / 2, muLeft, muRight, muBottom, muTop);
 
-  SparseMatrix<double> rhs (M * N, M * N);
-  SparseMatrix<double> rhsBoundary (M * N, 2 * N);
+  SparseMatrixXd rhs (M * N, M * N);
+  SparseMatrixXd rhsBoundary (M * N, 2 * N);
 
-  vector<Triplet<double> > tripletList;
+  vector<TripletXd> tripletList;
   tripletList.reserve (5 * M * N);
 
   for (int i = 0; i < M; i++)
     for (int j = 0; j < N; ++j) {
-      if ((j == 0) || (j == (N - 1)))
-        tripletList.push_back (Triplet<double> (i * N + j, i * N + j, 1 - 3 * mu)); 
-      else
-        tripletList.push_back (Triplet<double> (i * N + j, i * N + j, 1 - 4 * mu));
+      tripletList.push_back (TripletXd (i * N + j, i * N + j,
+                                        1 - (muLeft[j] + muRight[j]) - (muBottom[i] + muTop[i])));
       if (j > 0) 
-        tripletList.push_back (Triplet<double> (i * N + j, i * N + (j - 1), mu));
+        tripletList.push_back (TripletXd (i * N + j, i * N + (j - 1), muLeft[j]));
       if (j < (N - 1)) 
-        tripletList.push_back (Triplet<double> (i * N + j, i * N + (j + 1), mu));
+        tripletList.push_back (TripletXd (i * N + j, i * N + (j + 1), muRight[j]));
       if (i > 0)
-        tripletList.push_back (Triplet<double> (i * N + j, (i - 1) * N + j, mu));
+        tripletList.push_back (TripletXd (i * N + j, (i - 1) * N + j, muBottom[i]));
       if (i < (M - 1))
-        tripletList.push_back (Triplet<double> (i * N + j, (i + 1) * N + j, mu));
+        tripletList.push_back (TripletXd (i * N + j, (i + 1) * N + j, muTop[i]));
     }
 
   rhs.setFromTriplets (tripletList.begin(), tripletList.end());
@@ -154,42 +202,151 @@ void ProblemStructure::crankNicolson() {
   tripletList.reserve (2 * N);
 
   for (int j = 0; j < N; ++j) {
-    tripletList.push_back (Triplet<double> (j,               j,     mu));
-    tripletList.push_back (Triplet<double> ((M - 1) * N + j, N + j, mu));
+    tripletList.push_back (TripletXd (j,               j,     muBottom[0]));
+    tripletList.push_back (TripletXd ((M - 1) * N + j, N + j, muTop[M - 1]));
   }
 
   rhsBoundary.setFromTriplets (tripletList.begin(), tripletList.end());
   rhsBoundary.makeCompressed();
 
-  VectorXd temporaryVector = rhs * temperatureVector + rhsBoundary * temperatureBoundaryVector;
+  VectorXd rhsVector = rhs * temperatureVector.cast<double>();
+  rhsVector.noalias() += rhsBoundary * temperatureBoundaryVector.cast<double>();
   
-  SparseMatrix<double> lhs;
+  SparseMatrixXd lhs;
   lhs.resize (M * N, M * N);
-  rhsBoundary.resize (M * N, 2 * M);
 
   tripletList.clear();
   tripletList.reserve (5 * M * N);
 
   for (int i = 0; i < M; i++)
     for (int j = 0; j < N; ++j) {
-      if ((j == 0) || (j == (N - 1)))
-        tripletList.push_back (Triplet<double> (i * N + j, i * N + j, 1 + 3 * mu)); 
-      else
-        tripletList.push_back (Triplet<double> (i * N + j, i * N + j, 1 + 4 * mu));
+      tripletList.push_back (TripletXd (i * N + j, i * N + j,
+                                        1 + (muLeft[j] + muRight[j]) + (muBottom[i] + muTop[i])));
       if (j > 0) 
-        tripletList.push_back (Triplet<double> (i * N + j, i * N + (j - 1), -mu));
+        tripletList.push_back (TripletXd (i * N + j, i * N + (j - 1), -muLeft[j]));
       if (j < (N - 1)) 
-        tripletList.push_back (Triplet<double> (i * N + j, i * N + (j + 1), -mu));
+        tripletList.push_back (TripletXd (i * N + j, i * N + (j + 1), -muRight[j]));
       if (i > 0)
-        tripletList.push_back (Triplet<double> (i * N + j, (i - 1) * N + j, -mu));
+        tripletList.push_back (TripletXd (i * N + j, (i - 1) * N + j, -muBottom[i]));
       if (i < (M - 1))
-        tripletList.push_back (Triplet<double> (i * N + j, (i + 1) * N + j, -mu));
+        tripletList.push_back (TripletXd (i * N + j, (i + 1) * N + j, -muTop[i]));
     }
 
   lhs.setFromTriplets (tripletList.begin(), tripletList.end());
   lhs.makeCompressed();
   
-  SimplicialLLT<SparseMatrix<double> > solver;
+  rhsVector.noalias() += rhsBoundary * temperatureBoundaryVector.cast<double>();
+  scaleByCellAreas (lhs, rhsVector);
+
+  SimplicialLLT<SparseMatrixXd > solver;
   solver.compute (lhs);
-  temperatureVector =  solver.solve(temporaryVector + rhsBoundary * temperatureBoundaryVector);
+  temperatureVector = solver.solve (rhsVector).cast<Real>();
+}
+
+// Alternating-direction implicit (Peaceman-Rachford) diffusion method.
+// Stable, second-order, and linear in the number of cells.
+void ProblemStructure::alternatingDirectionImplicit() {
+  double muX = deltaT * diffusivity / (2 * hx * hx);
+  double muY = deltaT * diffusivity / (2 * hy * hy);
+
+  if (adiSolver.getM() != M || adiSolver.getN() != N)
+    adiSolver.setup (M, N);
+
+  adiSolver.step (muX, muY, geometry.getTemperatureData(), geometry.getTemperatureBoundaryData());
+}
+
+// Runge-Kutta-Legendre super-time-stepping diffusion method. Explicit and
+// matrix-free, but stable for any time step.
+void ProblemStructure::rungeKuttaLegendre() {
+  if (rklSolver.getM() != M || rklSolver.getN() != N)
+    rklSolver.setup (M, N);
+
+  int stages = rklSolver.step (deltaT, diffusivity, hx, hy,
+                               geometry.getTemperatureData(),
+                               geometry.getTemperatureBoundaryData(),
+                               geometry.getTemperatureBackData());
+  geometry.swapTemperatureBuffers();
+
+  #ifdef DEBUG
+    cout << "<Took " << stages << " RKL2 stages>" << endl;
+  #else
+    (void) stages;
+  #endif
+}
+
+/** spectralDiffusionApplicable() decides whether the implicit diffusion
+ *  methods may use the SpectralDiffusionSolver, which requires the diffusion
+ *  operator to be separable with the eigenvectors of a uniform grid: a
+ *  uniform (not necessarily square) grid, constant diffusivity, insulated
+ *  side boundaries and prescribed lower and upper boundary temperatures.
+ *  Stretched grids fall back to the sparse solver.
+ */
+bool ProblemStructure::spectralDiffusionApplicable() {
+  return (diffusionSolver == "spectral") && !stretchedGrid;
+}
+
+/** diffusionNumbers() computes the coefficients \f$ s / (h d) \f$ of the
+ *  five-point diffusion stencil for each column (left and right) and row
+ *  (bottom and top) of cells, where \f$ s \f$ is **scale**, \f$ h \f$ the
+ *  cell's width or height and \f$ d \f$ the distance to the neighboring
+ *  center. They are zero at the insulated sides, while the top and bottom
+ *  boundary temperatures are taken one cell height beyond the last rows. On
+ *  a uniform grid they are \f$ s / h_x^2 \f$ and \f$ s / h_y^2 \f$.
+ */
+void ProblemStructure::diffusionNumbers (const double scale,
+                                         vector<double> &left, vector<double> &right,
+                                         vector<double> &bottom, vector<double> &top) {
+  left.resize (N);
+  right.resize (N);
+  bottom.resize (M);
+  top.resize (M);
+
+  for (int j = 0; j < N; ++j) {
+    left[j]  = (j > 0)       ? scale / (cellWidths[j] * ((cellWidths[j - 1] + cellWidths[j]) / 2)) : 0;
+    right[j] = (j < (N - 1)) ? scale / (cellWidths[j] * ((cellWidths[j] + cellWidths[j + 1]) / 2)) : 0;
+  }
+  for (int i = 0; i < M; ++i) {
+    bottom[i] = scale / (cellHeights[i] * ((i > 0)       ? (cellHeights[i - 1] + cellHeights[i]) / 2 : cellHeights[i]));
+    top[i]    = scale / (cellHeights[i] * ((i < (M - 1)) ? (cellHeights[i] + cellHeights[i + 1]) / 2 : cellHeights[i]));
+  }
+}
+
+/* The implicit diffusion matrices are only symmetric, as SimplicialLLT
+ * requires, on a uniform grid. Otherwise each row is scaled by its cell's
+ * area, which makes it symmetric again. */
+void ProblemStructure::scaleByCellAreas (SparseMatrixXd &lhs, VectorXd &rhs) {
+  if (!stretchedGrid)
+    return;
+
+  VectorXd areas (M * N);
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N; ++j)
+      areas (i * N + j) = cellWidths[j] * cellHeights[i];
+
+  lhs = areas.asDiagonal() * lhs;
+  rhs = areas.cwiseProduct (rhs);
+}
+
+// Add mu, the diffusion number in y, times the prescribed lower and upper
+// boundary temperatures to the first and last rows of the MxN array data.
+void ProblemStructure::addDiffusionBoundaryTerms (const double mu, Real * data) {
+  DataWindow<Real> temperatureBoundaryWindow (geometry.getTemperatureBoundaryData(), N, 2);
+  DataWindow<Real> dataWindow (data, N, M);
+
+  for (int j = 0; j < N; ++j) {
+    dataWindow (j, 0)     += mu * temperatureBoundaryWindow (j, 0);
+    dataWindow (j, M - 1) += mu * temperatureBoundaryWindow (j, 1);
+  }
+}
+
+// Solve (I + muX Lx + muY Ly) T = data in place with the spectral solver.
+void ProblemStructure::solveSpectralDiffusion (const double muX, const double muY, Real * data) {
+  if (spectralSolver.getM() != M || spectralSolver.getN() != N)
+    spectralSolver.setup (M, N);
+
+  spectralSolver.solve (muX, muY, data);
+
+  #ifdef DEBUG
+    cout << "<Solved the diffusion step spectrally>" << endl;
+  #endif
 }
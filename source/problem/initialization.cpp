@@ -1,4 +1,5 @@
 #include <iostream>
+#include <algorithm>
 #include <cmath>
 
 #include "boost/math/constants/constants.hpp"
@@ -21,13 +22,17 @@ const double pi = boost::math::constants::pi<double>();
 void ProblemStructure::initializeProblem() {
   initializeTimestep();
   initializeTemperature();
+  initializeComposition();
+  initializeTracers();
+  initializeRefinement();
   initializeTemperatureBoundary();
   initializeVelocityBoundary();
   initializeViscosity();
 }
 
 void ProblemStructure::initializeTimestep() {
-  deltaT = cfl * h / diffusivity;
+  deltaT = cfl * min (*min_element (cellWidths.begin(), cellWidths.end()),
+                      *min_element (cellHeights.begin(), cellHeights.end())) / diffusivity;
   int nTimestep = (endTime - time) / deltaT;
   if (abs (nTimestep * deltaT + time - endTime) > 1E-06)
     deltaT = (endTime - time) / ++nTimestep;
@@ -37,7 +42,11 @@ void ProblemStructure::initializeTimestep() {
 }
 
 void ProblemStructure::initializeTemperature() {
-  DataWindow<double> temperatureWindow (geometry.getTemperatureData(), N, M);
+  // Each process initializes the cells of its own block.
+  Decomposition &decomposition = geometry.getDecomposition();
+  const GridIndex rowBegin = decomposition.getRowBegin(), rowEnd = decomposition.getRowEnd();
+  const GridIndex colBegin = decomposition.getColBegin(), colEnd = decomposition.getColEnd();
+  Real * temperature = geometry.getTemperatureData();
 
   double referenceTemperature;
   double temperatureScale;
@@ -60,9 +69,9 @@ void ProblemStructure::initializeTemperature() {
 
   if (temperatureModel == "constant") {
 
-    for (int i = 0; i < M; ++i)
-      for (int j = 0; j < N; ++j)
-        temperatureWindow (j, i) = referenceTemperature;
+    for (GridIndex i = rowBegin; i < rowEnd; ++i)
+      for (GridIndex j = colBegin; j < colEnd; ++j)
+        temperature[decomposition.cell (i, j)] = referenceTemperature;
 
   } else if (temperatureModel == "sineWave") {
     int xModes;
@@ -78,20 +87,20 @@ void ProblemStructure::initializeTemperature() {
       params.pop();
     }
 
-    for (int i = 0; i < M; ++i)
-      for (int j = 0; j < N; ++j)
-        temperatureWindow (j, i) = referenceTemperature +
-                                   sin ((i + 0.5) * h * xModes * pi / xExtent) *
-                                   sin ((j + 0.5) * h * yModes * pi / yExtent) *
-                                   temperatureScale;
+    for (GridIndex i = rowBegin; i < rowEnd; ++i)
+      for (GridIndex j = colBegin; j < colEnd; ++j)
+        temperature[decomposition.cell (i, j)] = referenceTemperature +
+                                                 sin (yCenters[i] * xModes * pi / xExtent) *
+                                                 sin (xCenters[j] * yModes * pi / yExtent) *
+                                                 temperatureScale;
 
   } else if (temperatureModel == "squareWave") {
-    for (int i = 0; i < M; ++i)
-      for (int j = 0; j < N; ++j) {
+    for (GridIndex i = rowBegin; i < rowEnd; ++i)
+      for (GridIndex j = colBegin; j < colEnd; ++j) {
         if ((M / 4 < j && j < 3 * M / 4) && (N / 4 < i && i < 3 * N / 4))
-          temperatureWindow (j, i) = referenceTemperature + temperatureScale;
+          temperature[decomposition.cell (i, j)] = referenceTemperature + temperatureScale;
         else
-          temperatureWindow (j, i) = referenceTemperature;
+          temperature[decomposition.cell (i, j)] = referenceTemperature;
       }
   } else if (temperatureModel == "circle") {
      double center_x;
@@ -108,12 +117,12 @@ void ProblemStructure::initializeTemperature() {
        params.pop();
      }
 
-     for (int i = 0; i < M; ++i)
-       for (int j= 0; j < N; ++j) {
-         if ( std::sqrt(std::pow((i*h+h/2)-(center_y),2.0) + std::pow((j*h+h/2)-(center_x),2.0))  < radius )
-           temperatureWindow (j, i) = referenceTemperature + temperatureScale;
+     for (GridIndex i = rowBegin; i < rowEnd; ++i)
+       for (GridIndex j = colBegin; j < colEnd; ++j) {
+         if ( std::sqrt(std::pow(yCenters[i]-(center_y),2.0) + std::pow(xCenters[j]-(center_x),2.0))  < radius )
+           temperature[decomposition.cell (i, j)] = referenceTemperature + temperatureScale;
          else
-           temperatureWindow (j, i) = referenceTemperature;
+           temperature[decomposition.cell (i, j)] = referenceTemperature;
        }
   } else {
     THROW_WITH_TRACE(InvalidArgument() <<
@@ -122,13 +131,76 @@ void ProblemStructure::initializeTemperature() {
 
   #ifdef DEBUG
     cout << "<Initialized temperature model as: \"" << temperatureModel << "\">" << endl;
-    cout << "<Temperature Data>" << endl;
-    cout << temperatureWindow.displayMatrix() << endl << endl;
+    if (!decomposition.isDistributed()) {
+      cout << "<Temperature Data>" << endl;
+      cout << DataWindow<Real> (temperature, N, M).displayMatrix() << endl << endl;
+    }
+  #endif
+
+  // The gathered temperature is filled in when first needed.
+  temperatureDistributed = decomposition.isDistributed();
+}
+
+void ProblemStructure::initializeComposition() {
+  const int K = geometry.getK();
+  if (K == 0)
+    return;
+
+  Real * compositionData = geometry.getCompositionData();
+
+  if (compositionModel == "layers") {
+    // Field f marks the f-th of K equal horizontal layers, counted upward.
+    for (int i = 0; i < M; ++i) {
+      const int layer = min<GridIndex> (K - 1, (i * K) / M);
+      for (int j = 0; j < N; ++j)
+        for (int f = 0; f < K; ++f)
+          compositionData[(i * N + j) * K + f] = (f == layer) ? 1.0 : 0.0;
+    }
+  } else if (compositionModel == "none") {
+    for (GridIndex n = 0; n < M * N * K; ++n)
+      compositionData[n] = 0.0;
+  } else {
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("Unexpected composition model: '" + compositionModel + "'"));
+  }
+
+  #ifdef DEBUG
+    cout << "<Initialized " << K << " compositional fields as: \"" << compositionModel << "\">" << endl;
+  #endif
+}
+
+void ProblemStructure::initializeTracers() {
+  if (advectionMethod != "particleInCell")
+    return;
+
+  tracers.seed (M, N, geometry.getK(), hx, hy,
+                tracersPerSide, tracerSortInterval,
+                geometry.getTemperatureData(),
+                geometry.getCompositionData());
+
+  #ifdef DEBUG
+    cout << "<Seeded " << tracers.getTracerCount() << " tracers>" << endl;
+  #endif
+}
+
+void ProblemStructure::initializeRefinement() {
+  if (refinementLevels == 1)
+    return;
+
+  hierarchy.setup (M, N, hx, hy, refinementLevels,
+                   refinementPatchSize, regridInterval, refinementThreshold,
+                   (advectionMethod == "frommMethod") ? "fromm" : "upwind",
+                   fluxLimiter,
+                   geometry.getTemperatureData());
+
+  #ifdef DEBUG
+    for (int l = 1; l < refinementLevels; ++l)
+      cout << "<Level " << l << " refined with " << hierarchy.getPatchCount (l) << " patches>" << endl;
   #endif
 }
 
 void ProblemStructure::initializeTemperatureBoundary() {
-  DataWindow<double> temperatureBoundaryWindow (geometry.getTemperatureBoundaryData(), N, 2);
+  DataWindow<Real> temperatureBoundaryWindow (geometry.getTemperatureBoundaryData(), N, 2);
 
   double upperTemperature;
   double lowerTemperature;
@@ -157,10 +229,10 @@ void ProblemStructure::initializeVelocityBoundary() {
   if (boundaryModel == "tauBenchmark") {
     for (int i = 0; i < M; ++i)
       for (int j = 0; j < 2; ++j)
-        uVelocityBoundaryWindow (j, i) = cos (j * N * h) * sin ((i + 0.5) * h);
+        uVelocityBoundaryWindow (j, i) = cos (xFaces[j * N]) * sin (yCenters[i]);
     for (int i = 0; i < 2; ++i)
       for (int j = 0; j < N; ++j)
-        vVelocityBoundaryWindow (j, i) = -sin ((j + 0.5) * h) * cos (i * M * h);
+        vVelocityBoundaryWindow (j, i) = -sin (xCenters[j]) * cos (yFaces[i * M]);
   } else if (boundaryModel == "solCXBenchmark" ||
              boundaryModel == "solKZBenchmark" ||
              boundaryModel == "noFlux") {
@@ -211,7 +283,7 @@ void ProblemStructure::initializeViscosity() {
   } else if (viscosityModel == "solKZBenchmark") {
     for (int i = 0; i < (M + 1); ++i)
       for (int j = 0; j < (N + 1); ++j)
-        viscosityWindow (j, i) = 1.0 + j * h * 1.0E06;
+        viscosityWindow (j, i) = 1.0 + xFaces[j] * 1.0E06;
   } else {
     THROW_WITH_TRACE(InvalidArgument() <<
             errmsg_info("Unexpected viscosity model: '" + viscosityModel + "'"));
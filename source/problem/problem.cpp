@@ -3,11 +3,15 @@
  */
 
 #include <iostream>
+#include <algorithm>
 #include <cassert>
 #include <limits>
+#include <cmath>
 
 #include <Eigen/Sparse>
 
+#include "debug/exception.h"
+#include "geometry/dataWindow.h"
 #include "geometry/geometry.h"
 #include "problem/problem.h"
 #include "params.h"
@@ -26,7 +30,17 @@ ProblemStructure::ProblemStructure(Params &p,
    *  user. 
    */
     params   (p),
-    geometry (gs) {
+    geometry (gs),
+    stepError (-1),
+    previousError (0),
+    rejectedSteps (0),
+    stepsSinceStokes (std::numeric_limits<int>::max()),
+    stokesInitialGuessMode ("zero"),
+    stokesSolved (false),
+    lastStokesTime (0),
+    olderStokesTime (0),
+    temperatureDistributed (false),
+    stokes (new StokesSystem()) {
   /** The majority of calls to the shared GeometryStructure object come from
    *  requests for the pointers to data in memory, but access to
    *  GeometryStructure is also required to find the values of M and N, the
@@ -76,16 +90,33 @@ ProblemStructure::ProblemStructure(Params &p,
             yExtent,
             0.0);
 
-    assert (((xExtent == 0) ^ (yExtent == 0)));
+    assert (((xExtent != 0) || (yExtent != 0)));
 
+    // With a single extent given, the cells are square.
     if (xExtent == 0) {
-      h      = yExtent / double(M);
-      xExtent = h * double(N);
+      hy      = yExtent / double(M);
+      hx      = hy;
+      xExtent = hx * double(N);
+    } else if (yExtent == 0) {
+      hx      = xExtent / double(N);
+      hy      = hx;
+      yExtent = hy * double(M);
     } else {
-      h      = xExtent / double(N);
-      yExtent = h * double(M);
+      hx      = xExtent / double(N);
+      hy      = yExtent / double(M);
     }
 
+    double xStretching, yStretching;
+    params.queryParam<double>(
+            "xStretching",
+            xStretching,
+            0.0);
+    params.queryParam<double>(
+            "yStretching",
+            yStretching,
+            0.0);
+    initializeGridSpacing (xStretching, yStretching);
+
     params.getParam<double>("diffusivity", diffusivity);
 
     params.queryParam<std::string>(
@@ -96,6 +127,10 @@ ProblemStructure::ProblemStructure(Params &p,
             "temperatureModel",
             temperatureModel,
             "constant");
+    params.queryParam<std::string>(
+            "compositionModel",
+            compositionModel,
+            "layers");
     params.queryParam<std::string>(
             "viscosityModel",
             viscosityModel,
@@ -109,19 +144,185 @@ ProblemStructure::ProblemStructure(Params &p,
             "advectionMethod",
             advectionMethod,
             "upwindMethod");
-    params.push("advectionParams"); {
+    params.tryPush("advectionParams"); {
       params.queryParam<std::string>(
               "fluxLimiter",
               fluxLimiter,
               "vanLeer");
+      params.queryParam<std::string>(
+              "interpolation",
+              semiLagrangianInterpolation,
+              "monotoneCubic");
+      params.queryParam<double>(
+              "courantNumber",
+              semiLagrangianCourant,
+              4.0);
+      params.queryParam<std::string>(
+              "tracerIntegrator",
+              tracerIntegrator,
+              "rungeKutta2");
+      params.queryParam<int>(
+              "tracersPerSide",
+              tracersPerSide,
+              3);
+      params.queryParam<int>(
+              "tracerSortInterval",
+              tracerSortInterval,
+              10);
+      params.queryParam<int>(
+              "multirateLevels",
+              multirateLevels,
+              1);
+
+      params.pop();
+    }
+
+    params.tryPush("refinementParams"); {
+      params.queryParam<int>("levels", refinementLevels, 1);
+      params.queryParam<int>("patchSize", refinementPatchSize, 16);
+      params.queryParam<int>("regridInterval", regridInterval, 4);
+      params.queryParam<double>("threshold", refinementThreshold, 0.05);
 
       params.pop();
     }
+    if (refinementLevels < 1)
+      THROW_WITH_TRACE(InvalidArgument()
+              << errmsg_info("Refinement requires levels >= 1."));
+    if (multirateLevels < 1 || multirateLevels > 16)
+      THROW_WITH_TRACE(InvalidArgument()
+              << errmsg_info("Multirate advection requires 1 to 16 levels."));
+    if (multirateLevels > 1 && (advectionMethod != "upwindMethod" || refinementLevels > 1))
+      THROW_WITH_TRACE(InvalidArgument()
+              << errmsg_info("Multirate advection requires upwindMethod without refinement."));
+    if (refinementLevels > 1 &&
+        advectionMethod != "upwindMethod" &&
+        advectionMethod != "frommMethod")
+      THROW_WITH_TRACE(InvalidArgument()
+              << errmsg_info("Advection method '" + advectionMethod + "' does not support refinement."));
 
     params.queryParam<std::string>(
             "diffusionMethod",
             diffusionMethod,
             "backwardEuler");
+    params.queryParam<std::string>(
+            "diffusionSolver",
+            diffusionSolver,
+            "spectral");
+    if (diffusionSolver != "spectral" && diffusionSolver != "sparse")
+      THROW_WITH_TRACE(InvalidArgument()
+              << errmsg_info("Unexpected diffusion solver: '" + diffusionSolver + "'."));
+
+    params.queryParam<std::string>(
+            "splittingMethod",
+            splittingMethod,
+            "lie");
+    if (splittingMethod != "lie" && splittingMethod != "strang")
+      THROW_WITH_TRACE(InvalidArgument()
+              << errmsg_info("Unexpected splitting method: '" + splittingMethod + "'."));
+
+    // Only the flux-form transport methods and the sparse Stokes forms
+    // account for variable cell sizes.
+    if (stretchedGrid) {
+      if (advectionMethod == "frommMethod" ||
+          advectionMethod == "semiLagrangian" ||
+          advectionMethod == "particleInCell")
+        THROW_WITH_TRACE(InvalidArgument()
+                << errmsg_info("Advection method '" + advectionMethod + "' requires a uniform grid."));
+      if (diffusionMethod == "alternatingDirectionImplicit" ||
+          diffusionMethod == "rungeKuttaLegendre")
+        THROW_WITH_TRACE(InvalidArgument()
+                << errmsg_info("Diffusion method '" + diffusionMethod + "' requires a uniform grid."));
+      if (refinementLevels > 1)
+        THROW_WITH_TRACE(InvalidArgument()
+                << errmsg_info("Refinement requires a uniform grid."));
+    #ifdef USE_DENSE
+      THROW_WITH_TRACE(InvalidArgument()
+              << errmsg_info("The dense Stokes forms require a uniform grid."));
+    #endif
+    }
+
+    // Only the explicit upwind advection and forward Euler diffusion are
+    // decomposed over MPI processes (see Decomposition); everything else
+    // would need the whole temperature on every process.
+    if (geometry.getDecomposition().isDistributed()) {
+      if ((advectionMethod != "upwindMethod" && advectionMethod != "none") ||
+          (diffusionMethod != "forwardEuler" && diffusionMethod != "none"))
+        THROW_WITH_TRACE(InvalidArgument()
+                << errmsg_info("Runs on several MPI processes require upwindMethod advection and forwardEuler diffusion."));
+      if (refinementLevels > 1 || multirateLevels > 1 || geometry.getK() > 0)
+        THROW_WITH_TRACE(InvalidArgument()
+                << errmsg_info("Runs on several MPI processes support neither refinement, multirate advection nor compositional fields."));
+    }
+
+    params.tryPush("subcyclingParams"); {
+      params.queryParam<std::string>("mode", subcyclingMode, "fixed");
+      params.queryParam<int>("substeps", stokesSubsteps, 1);
+      params.queryParam<int>("maxSubsteps", maxStokesSubsteps, 16);
+      params.queryParam<double>("velocityTolerance", velocityTolerance, 1E-02);
+
+      params.pop();
+    }
+    if (subcyclingMode != "fixed" && subcyclingMode != "adaptive")
+      THROW_WITH_TRACE(InvalidArgument()
+              << errmsg_info("Unexpected subcycling mode: '" + subcyclingMode + "'."));
+    if (stokesSubsteps < 1 || maxStokesSubsteps < stokesSubsteps)
+      THROW_WITH_TRACE(InvalidArgument()
+              << errmsg_info("Subcycling requires 1 <= substeps <= maxSubsteps."));
+
+  #ifndef USE_DENSE
+    params.tryPush("stokesSolverParams"); {
+      std::string stokesPrecision;
+      std::string orderingCache;
+      std::string stokesOrdering;
+      std::string stokesBackend;
+      double refinementTolerance;
+      int maxRefinements;
+      int maxStokesIterations;
+
+      params.queryParam<std::string>("precision", stokesPrecision, "double");
+      params.queryParam<double>("refinementTolerance", refinementTolerance, 1E-10);
+      params.queryParam<int>("maxRefinements", maxRefinements, 10);
+      stokes->solver.setup (stokesPrecision, refinementTolerance, maxRefinements);
+
+      params.queryParam<std::string>("ordering", stokesOrdering, "colamd");
+      stokes->solver.setOrdering (stokesOrdering, M, N);
+
+      params.queryParam<std::string>("orderingCache", orderingCache, "");
+      stokes->solver.setOrderingCache (orderingCache);
+
+      params.queryParam<std::string>("backend", stokesBackend, "eigen");
+      params.queryParam<int>("maxIterations", maxStokesIterations, 500);
+      stokes->solver.setBackend (stokesBackend, M * N, maxStokesIterations);
+
+      params.queryParam<std::string>("initialGuess", stokesInitialGuessMode, "previous");
+      if (stokesInitialGuessMode != "zero" &&
+          stokesInitialGuessMode != "previous" &&
+          stokesInitialGuessMode != "extrapolated")
+        THROW_WITH_TRACE(InvalidArgument() <<
+                errmsg_info("Unexpected Stokes initial guess: '" + stokesInitialGuessMode + "'."));
+
+      params.pop();
+    }
+  #endif
+
+    params.queryParam<std::string>(
+            "timestepController",
+            timestepController,
+            "cfl");
+    if (timestepController != "cfl" && timestepController != "pi")
+      THROW_WITH_TRACE(InvalidArgument()
+              << errmsg_info("Unexpected timestep controller: '" + timestepController + "'."));
+    params.tryPush("timestepParams"); {
+      params.queryParam<double>("tolerance", controllerTolerance, 1E-02);
+      params.queryParam<double>("safety", controllerSafety, 0.9);
+      params.queryParam<double>("integralGain", controllerIntegralGain, 0.7);
+      params.queryParam<double>("proportionalGain", controllerProportionalGain, 0.4);
+      params.queryParam<double>("maxGrowth", controllerMaxGrowth, 2.0);
+      params.queryParam<double>("minShrink", controllerMinShrink, 0.2);
+      params.queryParam<double>("rejectionRatio", controllerRejectionRatio, 2.0);
+
+      params.pop();
+    }
 
     params.queryParam<std::string>(
             "outputFile",
@@ -132,6 +333,50 @@ ProblemStructure::ProblemStructure(Params &p,
   }
 }
 
+/** initializeGridSpacing() places the N + 1 vertical and M + 1 horizontal
+ *  cell faces. With a stretching factor \f$ \beta > 0 \f$ the faces of a
+ *  side of length L with n cells are clustered towards both walls,
+ *  \f[ x_k = \frac {L} {2} \left( 1 + \frac {\tanh (\beta (2k/n - 1))} {\tanh \beta} \right) \f]
+ *  which makes the cells at the walls about \f$ \beta / \sinh \beta \cosh \beta \f$
+ *  times, and those in the middle \f$ \beta / \tanh \beta \f$ times, the
+ *  uniform spacing; e.g. 0.15 and 2.1 times for \f$ \beta = 2 \f$.
+ */
+void ProblemStructure::initializeGridSpacing (const double xStretching, const double yStretching) {
+  if (xStretching < 0 || yStretching < 0)
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("The grid stretching factors must not be negative."));
+
+  stretchedGrid = (xStretching > 0) || (yStretching > 0);
+
+  // The uniform spacing is computed exactly as before stretching existed.
+  auto placeFaces = [] (const GridIndex n, const double extent, const double h, const double beta,
+                        vector<double> &faces, vector<double> &centers, vector<double> &sizes) {
+    faces.resize (n + 1);
+    centers.resize (n);
+    sizes.resize (n);
+
+    for (GridIndex k = 0; k <= n; ++k)
+      faces[k] = (beta > 0) ?
+                 extent / 2 * (1 + tanh (beta * (2 * double(k) / double(n) - 1)) / tanh (beta)) :
+                 k * h;
+    for (GridIndex k = 0; k < n; ++k) {
+      sizes[k]   = (beta > 0) ? faces[k + 1] - faces[k] : h;
+      centers[k] = (beta > 0) ? (faces[k] + faces[k + 1]) / 2 : (k + 0.5) * h;
+    }
+  };
+
+  placeFaces (N, xExtent, hx, xStretching, xFaces, xCenters, cellWidths);
+  placeFaces (M, yExtent, hy, yStretching, yFaces, yCenters, cellHeights);
+
+  #ifdef DEBUG
+    if (stretchedGrid)
+      cout << "<Stretched grid: cell widths " << *min_element (cellWidths.begin(), cellWidths.end())
+           << " to " << *max_element (cellWidths.begin(), cellWidths.end()) << ", heights "
+           << *min_element (cellHeights.begin(), cellHeights.end()) << " to "
+           << *max_element (cellHeights.begin(), cellHeights.end()) << ">" << endl;
+  #endif
+}
+
 /** advanceTimestep() advances the problem time forward by one timestep, 
  *  incrementing the current timestep number in the process, and checks to see 
  *  whether completion conditions (either passing the final problem time or the 
@@ -141,92 +386,193 @@ ProblemStructure::ProblemStructure(Params &p,
 bool ProblemStructure::advanceTimestep() {
   time += deltaT;
   timestepNumber++;
+  if (stepsSinceStokes < std::numeric_limits<int>::max())
+    stepsSinceStokes++;
 
   return ((time < endTime) && (timestepNumber < endStep));
 }
 
 /** recalculateTimestep() calculates the current time step based on the user-
  *  specified CFL condition and the current state of the simulation. The
- *  timestep is calculated based on the maximum rates of advection and
- *  diffusion in the current problem. In future, this should take into account
- *  whether either advection or diffusion have been disabled in the parameter
- *  file.
+ *  timestep is the largest step allowed by the stability limits of the
+ *  advection and diffusion methods in use, optionally further restricted by
+ *  an error controller (see the 'timestepController' parameter).
  */
 void ProblemStructure::recalculateTimestep() {
-  Map<VectorXd> uVelocityVector (geometry.getUVelocityData(), M *       (N - 1));
-  Map<VectorXd> vVelocityVector (geometry.getVVelocityData(), (M - 1) * N);
-  Map<VectorXd> uVelocityBoundaryVector (geometry.getUVelocityBoundaryData(), 2 * N);
-  Map<VectorXd> vVelocityBoundaryVector (geometry.getVVelocityBoundaryData(), 2 * M);
-
-/** The current time step \f$ \Delta{t} \f$ rate of advection is calculated by finding the maximum
-   *  lateral and transverse velocities in the problem domain, then combining
-   *  both to gain a "worst-case" idea of the maximum velocity inside the
-   *  domain. This is then compared against the CFL condition using the formula
-   *  \f[ \Delta{t} = \frac {\sigma h} {||{\vec u}||} \f]
-   *  where \f$\Delta{t}\f$ is the time step, \f$\sigma\f$ is the CFL number,
-   *  \f$h\f$ is the grid spacing, and \f$ \| \vec u \| f$ is the maximum velocity in
-   *  the domain.
-   **/
-  double maxInteriorUVelocity = uVelocityVector.maxCoeff();
-  double maxBoundaryUVelocity = uVelocityBoundaryVector.maxCoeff();
-  double maxUVelocity = (maxInteriorUVelocity > maxBoundaryUVelocity) ? maxInteriorUVelocity : maxBoundaryUVelocity;
-
-  /** This needs to be rewritten, it is incorrect, since it is an overestimate of
-   *  the maximum velocity in the domain. EGP - 2015-09-27
+  const double * uVelocity = geometry.getBlockUVelocityData();
+  const double * vVelocity = geometry.getBlockVVelocityData();
+  DataWindow<double> uVelocityBoundaryWindow (geometry.getUVelocityBoundaryData(), 2, M);
+  DataWindow<double> vVelocityBoundaryWindow (geometry.getVVelocityBoundaryData(), N, 2);
+
+  double advectionDeltaT = std::numeric_limits<double>::infinity();
+  double diffusionDeltaT = std::numeric_limits<double>::infinity();
+
+  /** The advective time step \f$ \Delta{t} \f$ is limited by the CFL
+   *  condition of the unsplit upwind-type schemes used for advection,
+   *  \f[ \Delta{t} \max_{cell} \left( \frac {|u|} {h_x} + \frac {|v|} {h_y} \right) \le \sigma \f]
+   *  where \f$\sigma\f$ is the CFL number and \f$|u|\f$ and \f$|v|\f$
+   *  are the largest absolute face velocities of each cell. Both components
+   *  are gathered in a single pass over the cells.
    */
-  /** The current time step \f[ \Delta{t} \f] is calculated by finding the maximum
-    *  lateral and  transverse velocities in the problem domain, then combining
-    *  both to gain a "worst-case" idea of the maximum velocity inside the
-    *  domain. This is then compared against the CFL condition using the formula
-    *  \f[ \Delt
-   **/
-
-  double maxInteriorVVelocity = vVelocityVector.maxCoeff();
-  double maxBoundaryVVelocity = vVelocityBoundaryVector.maxCoeff();
-  double maxVVelocity = (maxInteriorVVelocity > maxBoundaryVVelocity) ? maxInteriorVVelocity : maxBoundaryVVelocity;
-  double advectionDeltaT = cfl * h / sqrt (maxUVelocity * maxUVelocity + maxVVelocity * maxVVelocity);
-  if (maxUVelocity == 0 || maxVVelocity == 0)
-    advectionDeltaT = std::numeric_limits<int>::max();
-
-  /** THIS IS INCORRECT! If the solver is explicit (e.g., first order Euler)
-   *  then there needs to be a 2 h*h or a 4 * h * h in the denominator!
-   *
-   *  Then the time step must be \f[ \Delta{t} = \frac {\sigma h} {\kappa} \f]
-   *  the maximum velocity in the domain. EGP - 2015-09-27:
-   * The calculation for the diffusion is similar, but much simpler. The
-   *  diffusive delta-t is calculated using the formula
-   *  \f[ \Delta{t} = \frac {\sigma h} {\kappa} \f]
-   *  where \f$\Delta{t}\f$
-   *
-   **/
-  double diffusionDeltaT = cfl * h / diffusivity;
-
-  if (advectionDeltaT < diffusionDeltaT) {
-    deltaT = advectionDeltaT;
-  } else {
-    deltaT = diffusionDeltaT;
-    cout << "<CAUTION! Recalculated the time step as " << deltaT << "based on an IMPLICIT diffusion solver!>" << endl;
+  if (advectionMethod != "none") {
+    double maxCourantSum = 0;
+
+    // Each process scans the faces of its own block; the maximum is then
+    // reduced over all of them.
+    Decomposition &decomposition = geometry.getDecomposition();
+    for (GridIndex i = decomposition.getRowBegin(); i < decomposition.getRowEnd(); ++i) {
+      for (GridIndex j = decomposition.getColBegin(); j < decomposition.getColEnd(); ++j) {
+        double leftVelocity   = (j == 0) ?
+                                 uVelocityBoundaryWindow (0, i) :
+                                 uVelocity[decomposition.uFace (i, j - 1)];
+        double rightVelocity  = (j == (N - 1)) ?
+                                 uVelocityBoundaryWindow (1, i) :
+                                 uVelocity[decomposition.uFace (i, j)];
+        double bottomVelocity = (i == 0) ?
+                                 vVelocityBoundaryWindow (j, 0) :
+                                 vVelocity[decomposition.vFace (i - 1, j)];
+        double topVelocity    = (i == (M - 1)) ?
+                                 vVelocityBoundaryWindow (j, 1) :
+                                 vVelocity[decomposition.vFace (i, j)];
+
+        double courantSum = max (abs (leftVelocity), abs (rightVelocity)) / cellWidths[j] +
+                            max (abs (bottomVelocity), abs (topVelocity)) / cellHeights[i];
+        if (courantSum > maxCourantSum)
+          maxCourantSum = courantSum;
+      }
+    }
+    maxCourantSum = decomposition.maxAll (maxCourantSum);
+
+    /* The semi-Lagrangian and particle-in-cell methods are stable for any
+     * Courant number; their step is instead limited by the accuracy of the
+     * traced characteristics. */
+    double courantNumber = (advectionMethod == "semiLagrangian" ||
+                            advectionMethod == "particleInCell") ?
+                           semiLagrangianCourant : cfl;
+    if (maxCourantSum > 0)
+      advectionDeltaT = courantNumber / maxCourantSum;
+
+    /* With multirate advection only the fastest cells are held to the CFL
+     * limit, by taking up to 2^(levels - 1) local steps per step. */
+    if (multirateLevels > 1)
+      advectionDeltaT *= (1 << (multirateLevels - 1));
+  }
+
+  /** The diffusive limit depends on the method. The explicit five-point
+   *  update used by forwardEuler() (and by the half-time predictor of
+   *  frommMethod() without refinement) is stable only for
+   *  \f[ \Delta{t} \le \frac {\sigma} {2 \kappa (h_x^{-2} + h_y^{-2})} \f]
+   *  while the other methods (including the explicit rungeKuttaLegendre(),
+   *  which adds stages as needed) are unconditionally stable.
+   *  Without an error controller, these methods are instead held to
+   *  the accuracy limit \f$ \Delta{t} \le \sigma \min(h_x, h_y) / \kappa \f$.
+   *  On a stretched grid \f$ h_x \f$ and \f$ h_y \f$ are the smallest
+   *  cell width and height.
+   */
+  if (diffusivity > 0) {
+    double minHx = *min_element (cellWidths.begin(), cellWidths.end());
+    double minHy = *min_element (cellHeights.begin(), cellHeights.end());
+
+    bool explicitDiffusion = (diffusionMethod == "forwardEuler") ||
+                             (advectionMethod == "frommMethod" && refinementLevels == 1);
+    if (explicitDiffusion)
+      diffusionDeltaT = cfl / (2 * diffusivity * (1 / (minHx * minHx) + 1 / (minHy * minHy)));
+    else if (diffusionMethod != "none" && timestepController == "cfl")
+      diffusionDeltaT = cfl * min (minHx, minHy) / diffusivity;
+  }
+
+  double stableDeltaT = min (advectionDeltaT, diffusionDeltaT);
+
+  if (timestepController == "pi") {
+    /** The PI controller uses the relative change in temperature over the
+     *  previous step as its error estimate \f$ e_n \f$ (see
+     *  solveAdvectionDiffusion()), and chooses
+     *  \f[ \Delta{t}_{n+1} = \Delta{t}_n \, s
+     *       \left( \frac {tol} {e_n} \right)^{k_I}
+     *       \left( \frac {e_{n-1}} {tol} \right)^{k_P} \f]
+     *  with the growth factor clamped to [minShrink, maxGrowth]. The
+     *  stability limits above always take precedence.
+     */
+    if (stepError >= 0) {
+      double factor = controllerMaxGrowth;
+      if (stepError > 0) {
+        factor = controllerSafety *
+                 pow (controllerTolerance / stepError, controllerIntegralGain);
+        if (previousError > 0)
+          factor *= pow (previousError / controllerTolerance, controllerProportionalGain);
+      }
+      factor = max (controllerMinShrink, min (controllerMaxGrowth, factor));
+
+      previousError = stepError;
+      deltaT = min (deltaT * factor, stableDeltaT);
+    } else {
+      deltaT = min (deltaT, stableDeltaT);
+    }
+  } else if (stableDeltaT < std::numeric_limits<double>::infinity()) {
+    deltaT = stableDeltaT;
   }
 
   if (time + deltaT > endTime) { deltaT = endTime - time; }
 
   #ifdef DEBUG
+    cout << "<Advective time step limit: " << advectionDeltaT << ">" << endl;
+    cout << "<Diffusive time step limit: " << diffusionDeltaT << ">" << endl;
     cout << "<Recalculated the time step as " << deltaT << ">" << endl;
   #endif
 }
 
-double ProblemStructure::getH() {
-  return h;
+double ProblemStructure::getHx() {
+  return hx;
+}
+
+double ProblemStructure::getHy() {
+  return hy;
+}
+
+bool ProblemStructure::isStretched() {
+  return stretchedGrid;
+}
+
+const std::vector<double> &ProblemStructure::getCellWidths() {
+  return cellWidths;
+}
+
+const std::vector<double> &ProblemStructure::getCellHeights() {
+  return cellHeights;
+}
+
+const std::vector<double> &ProblemStructure::getXFaces() {
+  return xFaces;
+}
+
+const std::vector<double> &ProblemStructure::getYFaces() {
+  return yFaces;
+}
+
+const std::vector<double> &ProblemStructure::getXCenters() {
+  return xCenters;
+}
+
+const std::vector<double> &ProblemStructure::getYCenters() {
+  return yCenters;
 }
 
 double ProblemStructure::getTime() {
   return time;
 }
 
+double ProblemStructure::getDeltaT() {
+  return deltaT;
+}
+
 int ProblemStructure::getTimestepNumber() {
   return timestepNumber;
 }
 
+int ProblemStructure::getRejectedSteps() {
+  return rejectedSteps;
+}
+
 double ProblemStructure::getEndTime() {
   return endTime;
 }
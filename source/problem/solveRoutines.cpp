@@ -1,5 +1,6 @@
 #include <iostream>
 #include <cmath>
+#include <limits>
 
 #include <Eigen/Sparse>
 #include <Eigen/Dense>
@@ -33,6 +34,13 @@ using namespace std;
 // Update the forcing terms
 // T -> F
 void ProblemStructure::updateForcingTerms() {
+  // The forcing is only stored on the first process, which solves the
+  // Stokes system; the others take part in the temperature gather.
+  if (forcingModel == "buoyancy")
+    gatherTemperature();
+  if (!Decomposition::isRootProcess())
+    return;
+
   DataWindow<double> uForcingWindow (geometry.getUForcingData(), N - 1, M);
   DataWindow<double> vForcingWindow (geometry.getVForcingData(), N, M - 1);
 
@@ -44,11 +52,11 @@ void ProblemStructure::updateForcingTerms() {
     // Benchmark taken from Tau (1991; JCP Vol. 99)
     for (int i = 0; i < M; ++i)
       for (int j = 0; j < N - 1; ++j)
-        uForcingWindow (j, i) = 3 * cos ((j + 1) * h) * sin ((i + 0.5) * h);
+        uForcingWindow (j, i) = 3 * cos (xFaces[j + 1]) * sin (yCenters[i]);
 
     for (int i = 0; i < M - 1; ++i)
       for (int j = 0; j < N; ++j)
-        vForcingWindow (j, i) = -sin ((j + 0.5) * h) * cos ((i + 1) * h);
+        vForcingWindow (j, i) = -sin (xCenters[j]) * cos (yFaces[i + 1]);
 
   } else if (forcingModel == "solCXBenchmark" ||
              forcingModel == "solKZBenchmark") {
@@ -59,19 +67,19 @@ void ProblemStructure::updateForcingTerms() {
 
     for (int i = 0; i < M - 1; ++i)
       for (int j = 0; j < N; ++j)
-        vForcingWindow (j, i) = - sin((i + 0.5) * pi * h) * cos ((j + 1) * pi * h);
+        vForcingWindow (j, i) = - sin(pi * yCenters[i]) * cos (pi * xFaces[j + 1]);
 
   } else if (forcingModel == "vorticalFlow") {
     for (int i = 0; i < M; ++i)
       for (int j = 0; j < (N - 1); j++)
-        uForcingWindow (j, i) = cos ((j + 1) * h) * sin ((i + 0.5) * h);
+        uForcingWindow (j, i) = cos (xFaces[j + 1]) * sin (yCenters[i]);
 
     for (int i = 0; i < (M - 1); ++i)
       for (int j = 0; j < N; ++j)
-        vForcingWindow (j, i) = -sin ((j + 0.5) * h) * cos ((i + 1) * h);
+        vForcingWindow (j, i) = -sin (xCenters[j]) * cos (yFaces[i + 1]);
 
   } else if (forcingModel == "buoyancy") {
-    DataWindow<double> temperatureWindow (geometry.getTemperatureData(), N, M);
+    DataWindow<Real> temperatureWindow (geometry.getGatheredTemperatureData(), N, M);
 
     double referenceTemperature;
     double densityConstant;
@@ -100,14 +108,18 @@ void ProblemStructure::updateForcingTerms() {
       for (int j = 0; j < (N - 1); ++j)
         uForcingWindow (j, i) = 0;
 
-    for (int i = 0; i < (M - 1); ++i)
+    // The temperature is interpolated linearly to the faces between rows,
+    // which on a uniform grid is the mean of the two cells.
+    for (int i = 0; i < (M - 1); ++i) {
+      double lowerWeight = cellHeights[i + 1] / (cellHeights[i] + cellHeights[i + 1]);
       for (int j = 0; j < N; ++j) {
         vForcingWindow (j, i) =  -1 * densityConstant *
                                   (1 - thermalExpansion *
-                                   ((temperatureWindow (j, i) +
-                                     temperatureWindow (j, i + 1)) / 2 -
+                                   ((lowerWeight * temperatureWindow (j, i) +
+                                     (1 - lowerWeight) * temperatureWindow (j, i + 1)) -
                                       referenceTemperature));
       }
+    }
   } else {
     THROW_WITH_TRACE(RuntimeError() <<
             errmsg_info("Unexpected forcing model: '" + forcingModel + "'."));
@@ -121,57 +133,231 @@ void ProblemStructure::updateForcingTerms() {
   #endif
 }
 
+// Assemble and factor the Stokes system for the current viscosity field
+void ProblemStructure::factorStokesSystem() {
+  double * viscosityData = geometry.getViscosityData();
+
+  #ifndef USE_DENSE
+  // Each process assembles the rows of the system it solves for, and the
+  // first the right-hand side.
+  GridIndex rowBegin, rowEnd;
+  stokes->solver.ownedRows (3 * M * N - M - N, rowBegin, rowEnd);
+  stokes->stokesMatrix.resize (rowEnd - rowBegin, 3 * M * N - M - N);
+
+  SparseForms::makeStokesMatrix   (stokes->stokesMatrix,   M, N, cellWidths.data(), cellHeights.data(), viscosityData,
+                                   SparseForms::RowRange (rowBegin, rowEnd));
+  stokes->stokesMatrix.makeCompressed();
+
+  if (Decomposition::isRootProcess()) {
+    stokes->forcingMatrix.resize  (3 * M * N - M - N, 2 * M * N - M - N);
+    stokes->boundaryMatrix.resize (3 * M * N - M - N, 2 * M + 2 * N);
+
+    SparseForms::makeForcingMatrix  (stokes->forcingMatrix,  M, N);
+    stokes->forcingMatrix.makeCompressed();
+    SparseForms::makeBoundaryMatrix (stokes->boundaryMatrix, M, N, cellWidths.data(), cellHeights.data(), viscosityData);
+    stokes->boundaryMatrix.makeCompressed();
+  }
+
+  stokes->solver.compute (stokes->stokesMatrix);
+  #else
+  /* Don't use this unless you hate your computer. */
+  stokes->stokesMatrix   = MatrixXd::Zero (3 * M * N - M - N, 3 * M * N - M - N);
+  stokes->forcingMatrix  = MatrixXd::Zero (3 * M * N - M - N, 2 * M * N - M - N);
+  stokes->boundaryMatrix = MatrixXd::Zero (3 * M * N - M - N, 2 * M + 2 * N);
+
+  DenseForms::makeStokesMatrix   (stokes->stokesMatrix, M, N, hx, hy, viscosityData);
+  DenseForms::makeForcingMatrix  (stokes->forcingMatrix, M, N);
+  DenseForms::makeBoundaryMatrix (stokes->boundaryMatrix, M, N, hx, hy, viscosityData);
+
+  stokes->solver.compute (stokes->stokesMatrix);
+  #endif
+
+  stokes->initialized = true;
+}
+
+VectorXd ProblemStructure::stokesRightHandSide() {
+  VectorXd rhs = stokes->forcingMatrix  * Map<VectorXd>(geometry.getForcingData(), 2 * M * N - M - N) +
+                 stokes->boundaryMatrix * Map<VectorXd>(geometry.getVelocityBoundaryData(), 2 * M + 2 * N);
+
+  /* The system is only solvable if the boundary velocities carry no net
+   * flux, i.e. the continuity rows weighted by the cell areas sum to zero.
+   * Boundary velocities sampled from a divergence-free field balance on a
+   * uniform grid, but not exactly on a stretched one, so there the net flux
+   * is spread evenly over the domain. */
+  if (stretchedGrid) {
+    const GridIndex velocitySize = 2 * M * N - M - N;
+    double netFlux = 0;
+    for (int i = 0; i < M; ++i)
+      for (int j = 0; j < N; ++j)
+        netFlux += cellWidths[j] * cellHeights[i] * rhs (velocitySize + i * N + j);
+
+    rhs.tail (M * N).array() -= netFlux / (xExtent * yExtent);
+  }
+
+  return rhs;
+}
+
 // Solve the stokes equation
 // F -> U X P
 void ProblemStructure::solveStokes() {
-  Map<VectorXd> stokesSolnVector (geometry.getStokesData(), M * (N - 1) + (M - 1) * N + M * N);
-
+  // The first process holds the forcing and the solution, and hands the
+  // other processes of a distributed run the velocities of their blocks.
+  // With the petsc backend they all take part in the solve; otherwise the
+  // first solves the whole system alone.
+  const bool rootProcess = Decomposition::isRootProcess();
   #ifndef USE_DENSE
-  static SparseMatrix<double> stokesMatrix   (3 * M * N - M - N, 3 * M * N - M - N);
-  static SparseMatrix<double> forcingMatrix  (3 * M * N - M - N, 2 * M * N - M - N);
-  static SparseMatrix<double> boundaryMatrix (3 * M * N - M - N, 2 * M + 2 * N);
-  static SparseLU<SparseMatrix<double>, COLAMDOrdering<int> > solver;
+  const bool sharedSolve = (stokes->solver.getBackend() == "petsc");
   #else
-  /* Don't use this unless you hate your computer. */
-  static MatrixXd stokesMatrix   (3 * M * N - M - N, 3 * M * N - M - N);
-  static MatrixXd forcingMatrix  (3 * M * N - M - N, 2 * M * N - M - N);
-  static MatrixXd boundaryMatrix (3 * M * N - M - N, 2 * M + 2 * N);
-  static PartialPivLU<MatrixXd> solver;
+  const bool sharedSolve = false;
   #endif
 
-  static bool initialized;
+  if (rootProcess || sharedSolve) {
+    if (!(stokes->initialized) || !(viscosityModel=="constant"))
+      factorStokesSystem();
 
-  double * viscosityData = geometry.getViscosityData();
+    #ifndef USE_DENSE
+    VectorXd rhs, guess;
+    if (rootProcess) {
+      rhs   = stokesRightHandSide();
+      guess = stokesInitialGuess (time);
+    }
+    VectorXd solution = stokes->solver.solve (rhs, guess);
+    #else
+    VectorXd solution = stokes->solver.solve (stokesRightHandSide());
+    #endif
+
+    if (rootProcess) {
+      Map<VectorXd> (geometry.getStokesData(), M * (N - 1) + (M - 1) * N + M * N) = solution;
+      finishStokesSolve();
+    }
+  }
+
+  Decomposition &decomposition = geometry.getDecomposition();
+  if (decomposition.isDistributed()) {
+    decomposition.scatterFaces (geometry.getUVelocityData(), geometry.getVVelocityData(),
+                                geometry.getBlockUVelocityData(), geometry.getBlockVVelocityData());
+    decomposition.broadcast (stokesSubsteps);
+    stepsSinceStokes = 0;
+  }
+}
+
+void ProblemStructure::solveStokes (const std::vector<ProblemStructure *> &problems) {
+  if (problems.empty())
+    return;
 
-  if (!(initialized) || !(viscosityModel=="constant")) {
+  ProblemStructure &first = *problems[0];
+  for (size_t k = 1; k < problems.size(); ++k)
+    if (problems[k]->stokes != first.stokes)
+      THROW_WITH_TRACE(InvalidArgument() <<
+              errmsg_info("Batched Stokes solves require a shared Stokes system."));
+
+  if (!(first.stokes->initialized) || !(first.viscosityModel=="constant"))
+    first.factorStokesSystem();
+
+  const GridIndex M = first.M, N = first.N;
+  const GridIndex stokesSize = 3 * M * N - M - N;
+
+  // One column per problem, solved together against the shared factors.
+  MatrixXd rhs (stokesSize, problems.size()), solution;
+  for (size_t k = 0; k < problems.size(); ++k)
+    rhs.col (k) = problems[k]->stokesRightHandSide();
 
   #ifndef USE_DENSE
-    SparseForms::makeStokesMatrix   (stokesMatrix,   M, N, h, viscosityData);
-    stokesMatrix.makeCompressed();
-    SparseForms::makeForcingMatrix  (forcingMatrix,  M, N);
-    forcingMatrix.makeCompressed();
-    SparseForms::makeBoundaryMatrix (boundaryMatrix, M, N, h, viscosityData);
-    boundaryMatrix.makeCompressed();
-
-    solver.analyzePattern (stokesMatrix);
-    solver.factorize (stokesMatrix);
+  // Warm start every column, or none of them.
+  MatrixXd guess (stokesSize, problems.size());
+  for (size_t k = 0; k < problems.size() && guess.size() > 0; ++k) {
+    VectorXd problemGuess = problems[k]->stokesInitialGuess (problems[k]->time);
+    if (problemGuess.size() == stokesSize)
+      guess.col (k) = problemGuess;
+    else
+      guess.resize (0, 0);
+  }
+
+  first.stokes->solver.solve (rhs, guess, solution);
   #else
-    DenseForms::makeStokesMatrix   (stokesMatrix, M, N, h, viscosityData);
-    DenseForms::makeForcingMatrix  (forcingMatrix, M, N);
-    DenseForms::makeBoundaryMatrix (boundaryMatrix, M, N, h, viscosityData);
+  solution = first.stokes->solver.solve (rhs);
+  #endif
 
-    solver.compute (stokesMatrix);
+  for (size_t k = 0; k < problems.size(); ++k) {
+    Map<VectorXd> (problems[k]->geometry.getStokesData(), stokesSize) = solution.col (k);
+    problems[k]->finishStokesSolve();
+  }
+}
+
+void ProblemStructure::shareStokesSystem (ProblemStructure &source) {
+  Map<VectorXd> viscosity       (geometry.getViscosityData(),        (M + 1) * (N + 1));
+  Map<VectorXd> sourceViscosity (source.geometry.getViscosityData(), (source.M + 1) * (source.N + 1));
+
+  if (M != source.M || N != source.N || cellWidths != source.cellWidths || cellHeights != source.cellHeights ||
+      viscosityModel != "constant" || source.viscosityModel != "constant" ||
+      viscosity != sourceViscosity)
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("Problems sharing a Stokes system need the same grid and constant viscosity field."));
+  #ifndef USE_DENSE
+  if (!stokes->solver.sameSettings (source.stokes->solver))
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("Problems sharing a Stokes system need the same stokesSolverParams."));
   #endif
-    initialized = true;
+
+  stokes = source.stokes;
+}
+
+VectorXd ProblemStructure::stokesInitialGuess (const double solveTime) {
+  if (stokesInitialGuessMode == "zero" || !stokesSolved)
+    return VectorXd();
+
+  Map<VectorXd> stokesVector (geometry.getStokesData(), 3 * M * N - M - N);
+
+  /* Linear extrapolation in time from the last two solutions, which follows
+   * a smoothly evolving flow more closely than the last solution alone. */
+  if (stokesInitialGuessMode == "extrapolated" &&
+      olderStokesSolution.size() == stokesVector.size() &&
+      lastStokesTime > olderStokesTime) {
+    double ratio = (solveTime - lastStokesTime) / (lastStokesTime - olderStokesTime);
+    return stokesVector + ratio * (lastStokesSolution - olderStokesSolution);
   }
 
-  stokesSolnVector = solver.solve (forcingMatrix  * Map<VectorXd>(geometry.getForcingData(), 2 * M * N - M - N) +
-                                   boundaryMatrix * Map<VectorXd>(geometry.getVelocityBoundaryData(), 2 * M + 2 * N));
+  return stokesVector;
+}
 
+void ProblemStructure::finishStokesSolve() {
   Map<VectorXd> pressureVector (geometry.getPressureData(), M * N);
   double pressureMean = pressureVector.sum() / (M * N);
   pressureVector -= VectorXd::Constant (M * N, pressureMean);
 
+  if (stokesInitialGuessMode == "extrapolated") {
+    olderStokesSolution.swap (lastStokesSolution);
+    lastStokesSolution = Map<VectorXd> (geometry.getStokesData(), 3 * M * N - M - N);
+    olderStokesTime = lastStokesTime;
+  }
+  lastStokesTime = time;
+  stokesSolved   = true;
+
+  /* In adaptive subcycling mode the number of transport steps until the
+   * next solve is chosen so that the velocity is expected to change by about
+   * velocityTolerance (relative to its maximum) over the interval, based on
+   * the change per step seen since the previous solve. */
+  Map<VectorXd> velocityVector (geometry.getUVelocityData(), M * (N - 1) + (M - 1) * N);
+  if (subcyclingMode == "adaptive") {
+    if (previousVelocity.size() == velocityVector.size() && stepsSinceStokes > 0) {
+      double velocityScale = velocityVector.lpNorm<Infinity>();
+      double change = (velocityVector - previousVelocity).lpNorm<Infinity>() /
+                      max (velocityScale, std::numeric_limits<double>::min()) /
+                      stepsSinceStokes;
+
+      int substeps = maxStokesSubsteps;
+      if (change > 0 && velocityTolerance / change < maxStokesSubsteps)
+        substeps = max (1, int (velocityTolerance / change));
+      stokesSubsteps = min (substeps, 2 * stokesSubsteps);
+    }
+    previousVelocity = velocityVector;
+
+    #ifdef DEBUG
+      cout << "<Reusing the velocity for " << stokesSubsteps << " steps>" << endl;
+    #endif
+  }
+  stepsSinceStokes = 0;
+
 #ifdef DEBUG
   cout << "<Calculated Stokes Equation Solutions>" << endl;
   cout << "<U Velocity Data>" << endl;
@@ -183,22 +369,150 @@ void ProblemStructure::solveStokes() {
 #endif
 }
 
+void ProblemStructure::gatherTemperature() {
+  if (!temperatureDistributed)
+    return;
+
+  geometry.getDecomposition().gather (geometry.getTemperatureData(),
+                                      geometry.getGatheredTemperatureData());
+  temperatureDistributed = false;
+}
+
+bool ProblemStructure::stokesSolveRequired() {
+  return (stepsSinceStokes >= stokesSubsteps);
+}
+
+int ProblemStructure::getStokesSubsteps() {
+  return stokesSubsteps;
+}
+
 // Solve the advection/diffusion equation
 // U X T -> T
 void ProblemStructure::solveAdvectionDiffusion() {
+  if (timestepController != "pi") {
+    solveTransportStep();
+    return;
+  }
+
+  /* Under the PI controller each step is measured by its relative change in
+   * temperature. A step changing it by more than rejectionRatio times the
+   * tolerance is undone and retried with a smaller step, unless the advection
+   * keeps state which can't be restored (the tracers of particleInCell() or
+   * the patch hierarchy). The retries are bounded, as the change shrinks with
+   * the step. */
+  const int maxRetries = 10;
+  const bool retryable = (advectionMethod != "particleInCell" && refinementLevels == 1);
+
+  const GridIndex temperatureSize = geometry.getDecomposition().getCellCount();
+  const GridIndex compositionSize = M * N * geometry.getK();
+  const VectorXr startTemperature = Map<VectorXr> (geometry.getTemperatureData(), temperatureSize);
+  const VectorXr startComposition = Map<VectorXr> (geometry.getCompositionData(), compositionSize);
+  const bool startDistributed = temperatureDistributed;
+
+  for (int retry = 0; ; ++retry) {
+    solveTransportStep();
+    stepError = relativeTemperatureChange (startTemperature);
+
+    if (!retryable || retry == maxRetries ||
+        stepError <= controllerRejectionRatio * controllerTolerance)
+      break;
+
+    ++rejectedSteps;
+    deltaT *= max (controllerMinShrink,
+                   controllerSafety * pow (controllerTolerance / stepError, controllerIntegralGain));
+    Map<VectorXr> (geometry.getTemperatureData(), temperatureSize) = startTemperature;
+    Map<VectorXr> (geometry.getCompositionData(), compositionSize) = startComposition;
+    temperatureDistributed = startDistributed;
+
+    #ifdef DEBUG
+      cout << "<Rejected the step, retrying with " << deltaT << ">" << endl;
+    #endif
+  }
+}
+
+double ProblemStructure::relativeTemperatureChange (const VectorXr &startTemperature) {
+  // Each process measures its own block; the norms are reduced in double
+  // precision.
+  const Real * temperature = geometry.getTemperatureData();
+  Decomposition &decomposition = geometry.getDecomposition();
+
+  double temperatureScale = 0, change = 0;
+  for (GridIndex i = decomposition.getRowBegin(); i < decomposition.getRowEnd(); ++i)
+    for (GridIndex j = decomposition.getColBegin(); j < decomposition.getColEnd(); ++j) {
+      const GridIndex c = decomposition.cell (i, j);
+      temperatureScale = max (temperatureScale, abs (double (temperature[c])));
+      change = max (change, abs (double (temperature[c]) - double (startTemperature (c))));
+    }
+  temperatureScale = decomposition.maxAll (temperatureScale);
+  change = decomposition.maxAll (change);
+
+  return change / max (temperatureScale, std::numeric_limits<double>::min());
+}
+
+void ProblemStructure::solveTransportStep() {
+  if (splittingMethod == "strang") {
+    // Strang splitting: half a diffusion step on either side of a full
+    // advection step.
+    double fullDeltaT = deltaT;
+
+    deltaT = fullDeltaT / 2;
+    solveDiffusion();
+    deltaT = fullDeltaT;
+    solveAdvection();
+    deltaT = fullDeltaT / 2;
+    solveDiffusion();
+    deltaT = fullDeltaT;
+  } else {
+    solveAdvection();
+    solveDiffusion();
+  }
+
+  #ifdef DEBUG
+    cout << "<Finished Advection/Diffusion Step>" << endl << endl;
+  #endif
+}
+
+void ProblemStructure::solveAdvection() {
   #ifdef DEBUG
     cout << "<Using \"" << advectionMethod << "\" for advection>" << endl;
   #endif
-  if (advectionMethod == "upwindMethod") {
+  if (refinementLevels > 1) {
+    refinedAdvection();
+  } else if (multirateLevels > 1) {
+    multirateUpwind();
+  } else if (advectionMethod == "upwindMethod") {
     upwindMethod();
   } else if (advectionMethod == "frommMethod") {
     frommMethod();
+  } else if (advectionMethod == "semiLagrangian") {
+    semiLagrangian();
+  } else if (advectionMethod == "particleInCell") {
+    particleInCell();
   } else if (advectionMethod == "none") {
   } else {
     THROW_WITH_TRACE(RuntimeError()
             << errmsg_info("Unexpected advection method: '" + advectionMethod + "'."));
   }
 
+  // semiLagrangian(), particleInCell() and multirateUpwind() carry the
+  // compositional fields along with the temperature; the flux-based methods
+  // share one sweep over all fields, limited second order for frommMethod
+  // (with the half-time velocities when they were solved for).
+  if (geometry.getK() > 0 && multirateLevels == 1) {
+    if (advectionMethod == "frommMethod") {
+      if (refinementLevels > 1)
+        frommComposition (geometry.getUVelocityData(), geometry.getVVelocityData());
+      else
+        frommComposition (halfTimeStokesSoln.data(), halfTimeStokesSoln.data() + M * (N - 1));
+    } else if (advectionMethod != "semiLagrangian" &&
+               advectionMethod != "particleInCell" &&
+               advectionMethod != "none") {
+      upwindComposition();
+    }
+  }
+}
+
+void ProblemStructure::solveDiffusion() {
   #ifdef DEBUG
     cout << "<Using \"" << diffusionMethod << "\" for diffusion>" << endl;
   #endif
@@ -208,13 +522,13 @@ void ProblemStructure::solveAdvectionDiffusion() {
     backwardEuler();
   } else if (diffusionMethod == "crankNicolson") {
     crankNicolson();
+  } else if (diffusionMethod == "alternatingDirectionImplicit") {
+    alternatingDirectionImplicit();
+  } else if (diffusionMethod == "rungeKuttaLegendre") {
+    rungeKuttaLegendre();
   } else if (diffusionMethod == "none") {
   } else {
     THROW_WITH_TRACE(RuntimeError()
             << errmsg_info("Unexpected diffusion method: '" + diffusionMethod + "'."));
   }
-
-  #ifdef DEBUG
-    cout << "<Finished Advection/Diffusion Step>" << endl << endl;
-  #endif
 }
@@ -0,0 +1,568 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "debug/exception.h"
+#include "refinement/patchHierarchy.h"
+
+using namespace std;
+
+/// Layers of ghost cells around each patch, as needed by Fromm's scheme
+const int ghostCells = 2;
+/// Cells of the level below that must surround each patch
+const int nestingMargin = 2;
+
+static double minmod (const double a, const double b) {
+  if (a * b <= 0)
+    return 0;
+  return (abs (a) < abs (b)) ? a : b;
+}
+
+PatchHierarchy::PatchHierarchy() :
+    M (0),
+    N (0),
+    patchSize (16),
+    regridInterval (4),
+    threshold (0),
+    secondOrder (false),
+    limiter (noLimiter),
+    cellUpdates (0),
+    uVelocity (NULL),
+    vVelocity (NULL),
+    uVelocityBoundary (NULL),
+    vVelocityBoundary (NULL) {}
+
+void PatchHierarchy::setup (const GridIndex M, const GridIndex N,
+                            const double hx,
+                            const double hy,
+                            const int levels,
+                            const int patchSize,
+                            const int regridInterval,
+                            const double threshold,
+                            const std::string &scheme,
+                            const std::string &limiter,
+                            const Real * temperature) {
+  if (levels < 1 || patchSize < 4 || patchSize % 2 != 0 || regridInterval < 1)
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("Refinement requires levels >= 1, an even patchSize >= 4 and regridInterval >= 1."));
+
+  if (scheme == "upwind")
+    secondOrder = false;
+  else if (scheme == "fromm")
+    secondOrder = true;
+  else
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("Unexpected refinement scheme: '" + scheme + "'."));
+
+  if (limiter == "none")
+    this->limiter = noLimiter;
+  else if (limiter == "minmod")
+    this->limiter = minmodLimiter;
+  else if (limiter == "superbee")
+    this->limiter = superbeeLimiter;
+  else if (limiter == "vanLeer")
+    this->limiter = vanLeerLimiter;
+  else
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("Unexpected flux limiter: '" + limiter + "'."));
+
+  this->M = M;
+  this->N = N;
+  this->patchSize = patchSize;
+  this->regridInterval = regridInterval;
+  this->threshold = threshold;
+  cellUpdates = 0;
+
+  this->levels.assign (levels, Level());
+  for (int l = 0; l < levels; ++l) {
+    Level &level = this->levels[l];
+    level.M = M << l;
+    level.N = N << l;
+    level.hx = hx / (1 << l);
+    level.hy = hy / (1 << l);
+    level.tileRows = (level.M + patchSize - 1) / patchSize;
+    level.tileCols = (level.N + patchSize - 1) / patchSize;
+    level.steps = 0;
+    level.time = level.stepStart = 0;
+    level.deltaT = 1;
+  }
+
+  // Level 0 is a single patch over the whole grid.
+  Patch base;
+  base.row = base.col = 0;
+  base.rows = M;
+  base.cols = N;
+  base.data.assign ((M + 2 * ghostCells) * (N + 2 * ghostCells), 0.0);
+  base.xFlux.resize (M * (N + 1));
+  base.yFlux.resize ((M + 1) * N);
+  for (GridIndex i = 0; i < M; ++i)
+    for (GridIndex j = 0; j < N; ++j)
+      base.data[cellIndex (base, i, j)] = temperature[i * N + j];
+  this->levels[0].patches.push_back (base);
+
+  if (levels > 1)
+    regrid (1);
+}
+
+void PatchHierarchy::applyGridChange (const Real * temperature) {
+  Patch &base = levels[0].patches[0];
+
+  vector<double> change (M * N);
+  for (GridIndex i = 0; i < M; ++i)
+    for (GridIndex j = 0; j < N; ++j) {
+      double &value = base.data[cellIndex (base, i, j)];
+      change[i * N + j] = temperature[i * N + j] - value;
+      value = temperature[i * N + j];
+    }
+
+  for (int l = 1; l < (int) levels.size(); ++l) {
+    vector<Patch> &patches = levels[l].patches;
+    #ifdef USE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    #endif
+    for (size_t p = 0; p < patches.size(); ++p) {
+      Patch &patch = patches[p];
+      for (GridIndex i = patch.row; i < patch.row + patch.rows; ++i)
+        for (GridIndex j = patch.col; j < patch.col + patch.cols; ++j)
+          patch.data[cellIndex (patch, i, j)] += change[(i >> l) * N + (j >> l)];
+    }
+  }
+}
+
+void PatchHierarchy::advance (const double deltaT,
+                              const double * uVelocity,
+                              const double * vVelocity,
+                              const double * uVelocityBoundary,
+                              const double * vVelocityBoundary) {
+  this->uVelocity = uVelocity;
+  this->vVelocity = vVelocity;
+  this->uVelocityBoundary = uVelocityBoundary;
+  this->vVelocityBoundary = vVelocityBoundary;
+
+  cellUpdates = 0;
+  advanceLevel (0, deltaT);
+}
+
+void PatchHierarchy::project (Real * temperature) {
+  Patch &base = levels[0].patches[0];
+  for (GridIndex i = 0; i < M; ++i)
+    for (GridIndex j = 0; j < N; ++j)
+      temperature[i * N + j] = base.data[cellIndex (base, i, j)];
+}
+
+int PatchHierarchy::getLevelCount() {
+  return levels.size();
+}
+
+GridIndex PatchHierarchy::getPatchCount (const int level) {
+  return levels[level].patches.size();
+}
+
+GridIndex PatchHierarchy::getCellUpdates() {
+  return cellUpdates;
+}
+
+bool PatchHierarchy::covers (const int level, const GridIndex i, const GridIndex j) {
+  return (i >= 0 && i < levels[level].M && j >= 0 && j < levels[level].N &&
+          patchAt (level, i, j) >= 0);
+}
+
+double PatchHierarchy::getValue (const int level, const GridIndex i, const GridIndex j) {
+  const Patch &patch = levels[level].patches[patchAt (level, i, j)];
+  return patch.data[cellIndex (patch, i, j)];
+}
+
+int PatchHierarchy::patchAt (const int level, const GridIndex i, const GridIndex j) {
+  if (level == 0)
+    return 0;
+  const Level &l = levels[level];
+  return l.tiles[(i / patchSize) * l.tileCols + j / patchSize];
+}
+
+GridIndex PatchHierarchy::cellIndex (const Patch &patch, const GridIndex i, const GridIndex j) {
+  return (i - patch.row + ghostCells) * (patch.cols + 2 * ghostCells) + (j - patch.col + ghostCells);
+}
+
+double PatchHierarchy::coarseValue (const int level, const GridIndex i, const GridIndex j, const double alpha) {
+  const Patch &patch = levels[level].patches[patchAt (level, i, j)];
+  const GridIndex k = cellIndex (patch, i, j);
+  if (alpha >= 1)
+    return patch.data[k];
+  return (1 - alpha) * patch.oldData[k] + alpha * patch.data[k];
+}
+
+double PatchHierarchy::interpolate (const int level, const GridIndex i, const GridIndex j, const double alpha) {
+  const int coarse = level - 1;
+  const GridIndex ic = i / 2, jc = j / 2;
+  const double center = coarseValue (coarse, ic, jc, alpha);
+
+  // Neighbors outside the domain take the center value, giving one-sided
+  // (and so zero minmod) slopes at the walls.
+  auto neighbor = [&] (const GridIndex in, const GridIndex jn) {
+    if (in < 0 || in >= levels[coarse].M || jn < 0 || jn >= levels[coarse].N ||
+        patchAt (coarse, in, jn) < 0)
+      return center;
+    return coarseValue (coarse, in, jn, alpha);
+  };
+
+  const double xSlope = minmod (center - neighbor (ic, jc - 1), neighbor (ic, jc + 1) - center);
+  const double ySlope = minmod (center - neighbor (ic - 1, jc), neighbor (ic + 1, jc) - center);
+
+  return center + ((j % 2) ? 0.25 : -0.25) * xSlope + ((i % 2) ? 0.25 : -0.25) * ySlope;
+}
+
+double PatchHierarchy::uFace (const int level, const GridIndex i, const GridIndex j) {
+  const GridIndex scale = GridIndex (1) << level;
+  const GridIndex row = i >> level, face = j >> level, offset = j & (scale - 1);
+
+  auto baseVelocity = [&] (const GridIndex f) {
+    if (f == 0)
+      return uVelocityBoundary[row * 2];
+    if (f == N)
+      return uVelocityBoundary[row * 2 + 1];
+    return uVelocity[row * (N - 1) + f - 1];
+  };
+
+  if (offset == 0)
+    return baseVelocity (face);
+  return ((scale - offset) * baseVelocity (face) + offset * baseVelocity (face + 1)) / scale;
+}
+
+double PatchHierarchy::vFace (const int level, const GridIndex i, const GridIndex j) {
+  const GridIndex scale = GridIndex (1) << level;
+  const GridIndex col = j >> level, face = i >> level, offset = i & (scale - 1);
+
+  auto baseVelocity = [&] (const GridIndex f) {
+    if (f == 0)
+      return vVelocityBoundary[col];
+    if (f == M)
+      return vVelocityBoundary[N + col];
+    return vVelocity[(f - 1) * N + col];
+  };
+
+  if (offset == 0)
+    return baseVelocity (face);
+  return ((scale - offset) * baseVelocity (face) + offset * baseVelocity (face + 1)) / scale;
+}
+
+double PatchHierarchy::faceValue (const double behind, const double upwind, const double ahead, const double courant) {
+  if (!secondOrder)
+    return upwind;
+
+  const double a = upwind - behind, b = ahead - upwind;
+  double slope;
+  switch (limiter) {
+    case minmodLimiter:
+      slope = minmod (a, b);
+      break;
+    case superbeeLimiter:
+      slope = (a * b <= 0) ? 0 :
+              copysign (max (min (2 * abs (a), abs (b)), min (abs (a), 2 * abs (b))), a);
+      break;
+    case vanLeerLimiter:
+      slope = (a * b <= 0) ? 0 : 2 * a * b / (a + b);
+      break;
+    default:
+      slope = (a + b) / 2;
+  }
+
+  return upwind + (1 - abs (courant)) / 2 * slope;
+}
+
+/* Level l is rebuilt from the cells of level l - 1 whose temperature jumps
+ * by more than the threshold to a neighbor. Each tile of level l within
+ * regridInterval cells of level l - 1 of such a cell is refined, provided
+ * level l - 1 covers it with a margin of nestingMargin cells; as features
+ * move at most a cell of level l - 1 per step of level l - 1, they stay on
+ * the patches until the next regrid. Patches on tiles that stay refined keep
+ * their data, the others are interpolated from level l - 1. */
+void PatchHierarchy::regrid (const int level) {
+  const int coarse = level - 1;
+  Level &fine = levels[level];
+  Level &below = levels[coarse];
+  const GridIndex footprint = patchSize / 2;
+
+  vector<char> refine (fine.tileRows * fine.tileCols, 0);
+  for (const Patch &patch : below.patches)
+    for (GridIndex i = patch.row; i < patch.row + patch.rows; ++i)
+      for (GridIndex j = patch.col; j < patch.col + patch.cols; ++j) {
+        const double value = patch.data[cellIndex (patch, i, j)];
+        double jump = 0;
+        const GridIndex neighbors[4][2] = {{i, j - 1}, {i, j + 1}, {i - 1, j}, {i + 1, j}};
+        for (int n = 0; n < 4; ++n) {
+          const GridIndex in = neighbors[n][0], jn = neighbors[n][1];
+          if (in < 0 || in >= below.M || jn < 0 || jn >= below.N || patchAt (coarse, in, jn) < 0)
+            continue;
+          jump = max (jump, abs (getValue (coarse, in, jn) - value));
+        }
+        if (jump <= threshold)
+          continue;
+
+        const GridIndex tileRowBegin = max<GridIndex> (0, i - regridInterval) / footprint;
+        const GridIndex tileRowEnd   = min<GridIndex> (below.M - 1, i + regridInterval) / footprint;
+        const GridIndex tileColBegin = max<GridIndex> (0, j - regridInterval) / footprint;
+        const GridIndex tileColEnd   = min<GridIndex> (below.N - 1, j + regridInterval) / footprint;
+        for (GridIndex ti = tileRowBegin; ti <= tileRowEnd; ++ti)
+          for (GridIndex tj = tileColBegin; tj <= tileColEnd; ++tj)
+            refine[ti * fine.tileCols + tj] = 1;
+      }
+
+  vector<Patch> patches;
+  vector<int> tiles (fine.tileRows * fine.tileCols, -1);
+  for (GridIndex ti = 0; ti < fine.tileRows; ++ti)
+    for (GridIndex tj = 0; tj < fine.tileCols; ++tj) {
+      if (!refine[ti * fine.tileCols + tj])
+        continue;
+
+      Patch patch;
+      patch.row = ti * patchSize;
+      patch.col = tj * patchSize;
+      patch.rows = min<GridIndex> (patchSize, fine.M - patch.row);
+      patch.cols = min<GridIndex> (patchSize, fine.N - patch.col);
+
+      // Enforce proper nesting in level l - 1.
+      bool nested = true;
+      const GridIndex rowEnd = min (below.M, (patch.row + patch.rows) / 2 + nestingMargin);
+      const GridIndex colEnd = min (below.N, (patch.col + patch.cols) / 2 + nestingMargin);
+      for (GridIndex i = max<GridIndex> (0, patch.row / 2 - nestingMargin); nested && i < rowEnd; ++i)
+        for (GridIndex j = max<GridIndex> (0, patch.col / 2 - nestingMargin); nested && j < colEnd; ++j)
+          nested = (patchAt (coarse, i, j) >= 0);
+      if (!nested)
+        continue;
+
+      const int previous = fine.tiles.empty() ? -1 : fine.tiles[ti * fine.tileCols + tj];
+      if (previous >= 0) {
+        patch.data.swap (fine.patches[previous].data);
+      } else {
+        patch.data.assign ((patch.rows + 2 * ghostCells) * (patch.cols + 2 * ghostCells), 0.0);
+        for (GridIndex i = patch.row; i < patch.row + patch.rows; ++i)
+          for (GridIndex j = patch.col; j < patch.col + patch.cols; ++j)
+            patch.data[cellIndex (patch, i, j)] = interpolate (level, i, j, 1.0);
+      }
+      patch.xFlux.resize (patch.rows * (patch.cols + 1));
+      patch.yFlux.resize ((patch.rows + 1) * patch.cols);
+      patch.fluxRegister[0].resize (patch.rows / 2);
+      patch.fluxRegister[1].resize (patch.rows / 2);
+      patch.fluxRegister[2].resize (patch.cols / 2);
+      patch.fluxRegister[3].resize (patch.cols / 2);
+
+      tiles[ti * fine.tileCols + tj] = patches.size();
+      patches.push_back (patch);
+    }
+
+  fine.patches.swap (patches);
+  fine.tiles.swap (tiles);
+  fine.steps = 0;
+  fine.time = below.time;
+
+  if (level + 1 < (int) levels.size())
+    regrid (level + 1);
+}
+
+void PatchHierarchy::fillGhosts (const int level) {
+  Level &current = levels[level];
+  const double alpha = (level > 0) ?
+                       (current.time - levels[level - 1].stepStart) / levels[level - 1].deltaT :
+                       1.0;
+
+  #ifdef USE_OPENMP
+  #pragma omp parallel for schedule(dynamic)
+  #endif
+  for (size_t p = 0; p < current.patches.size(); ++p) {
+    Patch &patch = current.patches[p];
+    for (GridIndex i = patch.row - ghostCells; i < patch.row + patch.rows + ghostCells; ++i)
+      for (GridIndex j = patch.col - ghostCells; j < patch.col + patch.cols + ghostCells; ++j) {
+        if (i >= patch.row && i < patch.row + patch.rows &&
+            j >= patch.col && j < patch.col + patch.cols)
+          continue;
+
+        // Cells beyond the walls repeat the cell at the wall.
+        const GridIndex ci = max<GridIndex> (0, min (current.M - 1, i));
+        const GridIndex cj = max<GridIndex> (0, min (current.N - 1, j));
+        const int source = patchAt (level, ci, cj);
+
+        double value;
+        if (source >= 0) {
+          const Patch &neighbor = current.patches[source];
+          value = neighbor.data[cellIndex (neighbor, ci, cj)];
+        } else {
+          value = interpolate (level, ci, cj, alpha);
+        }
+        patch.data[cellIndex (patch, i, j)] = value;
+      }
+  }
+}
+
+void PatchHierarchy::stepPatch (const int level, Patch &patch, const double deltaT) {
+  const Level &current = levels[level];
+  const GridIndex stride = patch.cols + 2 * ghostCells;
+  const double * data = patch.data.data();
+
+  patch.oldData = patch.data;
+
+  // Fluxes through the vertical faces; the walls carry none.
+  for (GridIndex r = 0; r < patch.rows; ++r)
+    for (GridIndex f = 0; f <= patch.cols; ++f) {
+      const GridIndex i = patch.row + r, j = patch.col + f;
+      double &flux = patch.xFlux[r * (patch.cols + 1) + f];
+      if (j == 0 || j == current.N) {
+        flux = 0;
+        continue;
+      }
+
+      const double velocity = uFace (level, i, j);
+      const double courant = velocity * deltaT / current.hx;
+      const GridIndex left = cellIndex (patch, i, j - 1);
+      const double value = (velocity >= 0) ?
+                           faceValue (data[left - 1], data[left], data[left + 1], courant) :
+                           faceValue (data[left + 2], data[left + 1], data[left], courant);
+      flux = velocity * value * deltaT * current.hy;
+    }
+
+  // Fluxes through the horizontal faces.
+  for (GridIndex f = 0; f <= patch.rows; ++f)
+    for (GridIndex s = 0; s < patch.cols; ++s) {
+      const GridIndex i = patch.row + f, j = patch.col + s;
+      double &flux = patch.yFlux[f * patch.cols + s];
+      if (i == 0 || i == current.M) {
+        flux = 0;
+        continue;
+      }
+
+      const double velocity = vFace (level, i, j);
+      const double courant = velocity * deltaT / current.hy;
+      const GridIndex bottom = cellIndex (patch, i - 1, j);
+      const double value = (velocity >= 0) ?
+                           faceValue (data[bottom - stride], data[bottom], data[bottom + stride], courant) :
+                           faceValue (data[bottom + 2 * stride], data[bottom + stride], data[bottom], courant);
+      flux = velocity * value * deltaT * current.hx;
+    }
+
+  const double area = current.hx * current.hy;
+  for (GridIndex r = 0; r < patch.rows; ++r)
+    for (GridIndex s = 0; s < patch.cols; ++s)
+      patch.data[cellIndex (patch, patch.row + r, patch.col + s)] +=
+          (patch.xFlux[r * (patch.cols + 1) + s] - patch.xFlux[r * (patch.cols + 1) + s + 1] +
+           patch.yFlux[r * patch.cols + s] - patch.yFlux[(r + 1) * patch.cols + s]) / area;
+
+  if (level == 0)
+    return;
+
+  for (GridIndex r = 0; r < patch.rows; ++r) {
+    patch.fluxRegister[0][r / 2] += patch.xFlux[r * (patch.cols + 1)];
+    patch.fluxRegister[1][r / 2] += patch.xFlux[r * (patch.cols + 1) + patch.cols];
+  }
+  for (GridIndex s = 0; s < patch.cols; ++s) {
+    patch.fluxRegister[2][s / 2] += patch.yFlux[s];
+    patch.fluxRegister[3][s / 2] += patch.yFlux[patch.rows * patch.cols + s];
+  }
+}
+
+void PatchHierarchy::advanceLevel (const int level, const double deltaT) {
+  Level &current = levels[level];
+  const bool finer = (level + 1 < (int) levels.size());
+
+  if (finer && current.steps > 0 && current.steps % regridInterval == 0)
+    regrid (level + 1);
+  ++current.steps;
+
+  fillGhosts (level);
+  current.stepStart = current.time;
+  current.deltaT = deltaT;
+
+  #ifdef USE_OPENMP
+  #pragma omp parallel for schedule(dynamic)
+  #endif
+  for (size_t p = 0; p < current.patches.size(); ++p)
+    stepPatch (level, current.patches[p], deltaT);
+  for (const Patch &patch : current.patches)
+    cellUpdates += patch.rows * patch.cols;
+
+  current.time += deltaT;
+
+  if (!finer || levels[level + 1].patches.empty())
+    return;
+
+  for (Patch &patch : levels[level + 1].patches)
+    for (int side = 0; side < 4; ++side)
+      fill (patch.fluxRegister[side].begin(), patch.fluxRegister[side].end(), 0.0);
+
+  advanceLevel (level + 1, deltaT / 2);
+  advanceLevel (level + 1, deltaT / 2);
+  levels[level + 1].time = current.time;
+
+  reflux (level + 1);
+  averageDown (level + 1);
+}
+
+/* The coarse cell on the far side of each coarse-fine face was updated with
+ * the coarse flux through it; exchange that for the sum of the fine fluxes.
+ * Faces shared with another patch of the level or on a wall are skipped. */
+void PatchHierarchy::reflux (const int level) {
+  const int coarse = level - 1;
+  const Level &fine = levels[level];
+  Level &below = levels[coarse];
+  const double area = below.hx * below.hy;
+
+  for (const Patch &patch : fine.patches) {
+    const GridIndex row = patch.row / 2, col = patch.col / 2;
+    const GridIndex rows = patch.rows / 2, cols = patch.cols / 2;
+
+    for (GridIndex k = 0; k < rows; ++k) {
+      const GridIndex i = row + k;
+      // Left side: the face is the right face of the coarse cell.
+      if (patch.col > 0 && patchAt (level, 2 * i, patch.col - 1) < 0) {
+        Patch &target = below.patches[patchAt (coarse, i, col - 1)];
+        const double coarseFlux = target.xFlux[(i - target.row) * (target.cols + 1) + (col - target.col)];
+        target.data[cellIndex (target, i, col - 1)] += (coarseFlux - patch.fluxRegister[0][k]) / area;
+      }
+      // Right side: the face is the left face of the coarse cell.
+      const GridIndex right = col + cols;
+      if (right < below.N && patchAt (level, 2 * i, 2 * right) < 0) {
+        Patch &target = below.patches[patchAt (coarse, i, right)];
+        const double coarseFlux = target.xFlux[(i - target.row) * (target.cols + 1) + (right - target.col)];
+        target.data[cellIndex (target, i, right)] += (patch.fluxRegister[1][k] - coarseFlux) / area;
+      }
+    }
+
+    for (GridIndex k = 0; k < cols; ++k) {
+      const GridIndex j = col + k;
+      // Bottom side: the face is the top face of the coarse cell.
+      if (patch.row > 0 && patchAt (level, patch.row - 1, 2 * j) < 0) {
+        Patch &target = below.patches[patchAt (coarse, row - 1, j)];
+        const double coarseFlux = target.yFlux[(row - target.row) * target.cols + (j - target.col)];
+        target.data[cellIndex (target, row - 1, j)] += (coarseFlux - patch.fluxRegister[2][k]) / area;
+      }
+      // Top side: the face is the bottom face of the coarse cell.
+      const GridIndex top = row + rows;
+      if (top < below.M && patchAt (level, 2 * top, 2 * j) < 0) {
+        Patch &target = below.patches[patchAt (coarse, top, j)];
+        const double coarseFlux = target.yFlux[(top - target.row) * target.cols + (j - target.col)];
+        target.data[cellIndex (target, top, j)] += (patch.fluxRegister[3][k] - coarseFlux) / area;
+      }
+    }
+  }
+}
+
+void PatchHierarchy::averageDown (const int level) {
+  const int coarse = level - 1;
+  Level &fine = levels[level];
+  Level &below = levels[coarse];
+
+  #ifdef USE_OPENMP
+  #pragma omp parallel for schedule(dynamic)
+  #endif
+  for (size_t p = 0; p < fine.patches.size(); ++p) {
+    const Patch &patch = fine.patches[p];
+    for (GridIndex i = patch.row / 2; i < (patch.row + patch.rows) / 2; ++i)
+      for (GridIndex j = patch.col / 2; j < (patch.col + patch.cols) / 2; ++j) {
+        Patch &target = below.patches[patchAt (coarse, i, j)];
+        target.data[cellIndex (target, i, j)] =
+            (patch.data[cellIndex (patch, 2 * i,     2 * j)] +
+             patch.data[cellIndex (patch, 2 * i,     2 * j + 1)] +
+             patch.data[cellIndex (patch, 2 * i + 1, 2 * j)] +
+             patch.data[cellIndex (patch, 2 * i + 1, 2 * j + 1)]) / 4;
+      }
+  }
+}
@@ -0,0 +1,158 @@
+#include <algorithm>
+
+#include "solvers/adiDiffusionSolver.h"
+
+using namespace Eigen;
+using namespace std;
+
+/// Number of lines swept together by one thread
+static const int lineBlock = 64;
+
+ADIDiffusionSolver::ADIDiffusionSolver() :
+    M (0),
+    N (0),
+    factoredMuX (-1),
+    factoredMuY (-1) {
+}
+
+void ADIDiffusionSolver::setup (const GridIndex M, const GridIndex N) {
+  this->M = M;
+  this->N = N;
+  factoredMuX = -1;
+  factoredMuY = -1;
+
+  transposedTemperature.resize (M * N);
+}
+
+GridIndex ADIDiffusionSolver::getM() {
+  return M;
+}
+
+GridIndex ADIDiffusionSolver::getN() {
+  return N;
+}
+
+void ADIDiffusionSolver::step (const double muX,
+                               const double muY,
+                               double * temperature,
+                               const double * boundary) {
+  if (muX != factoredMuX || muY != factoredMuY) {
+    // Insulated sides: the end rows of the x operator have a single neighbor.
+    VectorXd xDiagonal = VectorXd::Constant (N, 1 + 2 * muX);
+    xDiagonal (0)     -= muX;
+    xDiagonal (N - 1) -= muX;
+    factor (muX, xDiagonal, xInverseDiagonal, xUpper);
+
+    factor (muY, VectorXd::Constant (M, 1 + 2 * muY), yInverseDiagonal, yUpper);
+
+    factoredMuX = muX;
+    factoredMuY = muY;
+  }
+
+  double * half = transposedTemperature.data();
+
+  /* First half step: explicit in y, implicit in x. The right-hand side is
+   * written transposed so that the x systems are interleaved line-innermost.
+   */
+  #ifdef USE_OPENMP
+  #pragma omp parallel for schedule(static)
+  #endif
+  for (int i = 0; i < M; ++i) {
+    const double * below = (i == 0)       ? boundary     : temperature + (i - 1) * N;
+    const double * above = (i == (M - 1)) ? boundary + N : temperature + (i + 1) * N;
+    const double * row   = temperature + i * N;
+
+    for (int j = 0; j < N; ++j)
+      half[j * M + i] = row[j] + muY * (below[j] - 2 * row[j] + above[j]);
+  }
+
+  solveLines (muX, xInverseDiagonal, xUpper, half, N, M);
+
+  /* Second half step: explicit in x, implicit in y, transposing back into
+   * the temperature array.
+   */
+  #ifdef USE_OPENMP
+  #pragma omp parallel for schedule(static)
+  #endif
+  for (int i = 0; i < M; ++i) {
+    double * row = temperature + i * N;
+
+    for (int j = 0; j < N; ++j) {
+      double center = half[j * M + i];
+      double left   = (j == 0)       ? center : half[(j - 1) * M + i];
+      double right  = (j == (N - 1)) ? center : half[(j + 1) * M + i];
+
+      row[j] = center + muX * (left - 2 * center + right);
+    }
+  }
+
+  for (int j = 0; j < N; ++j) {
+    temperature[j]               += muY * boundary[j];
+    temperature[(M - 1) * N + j] += muY * boundary[N + j];
+  }
+
+  solveLines (muY, yInverseDiagonal, yUpper, temperature, M, N);
+}
+
+void ADIDiffusionSolver::step (const double muX,
+                               const double muY,
+                               float * temperature,
+                               const float * boundary) {
+  workTemperature = Map<VectorXf> (temperature, M * N).cast<double>();
+  workBoundary    = Map<const VectorXf> (boundary, 2 * N).cast<double>();
+  step (muX, muY, workTemperature.data(), workBoundary.data());
+  Map<VectorXf> (temperature, M * N) = workTemperature.cast<float>();
+}
+
+void ADIDiffusionSolver::factor (const double mu,
+                                 const VectorXd &diagonal,
+                                 VectorXd &inverseDiagonal,
+                                 VectorXd &upper) {
+  const int n = diagonal.size();
+  inverseDiagonal.resize (n);
+  upper.resize (n);
+
+  inverseDiagonal (0) = 1 / diagonal (0);
+  upper (0)           = -mu * inverseDiagonal (0);
+  for (int k = 1; k < n; ++k) {
+    inverseDiagonal (k) = 1 / (diagonal (k) + mu * upper (k - 1));
+    upper (k)           = -mu * inverseDiagonal (k);
+  }
+}
+
+void ADIDiffusionSolver::solveLines (const double mu,
+                                     const VectorXd &inverseDiagonal,
+                                     const VectorXd &upper,
+                                     double * data,
+                                     const int n,
+                                     const int lines) {
+  const int nBlocks = (lines + lineBlock - 1) / lineBlock;
+
+  #ifdef USE_OPENMP
+  #pragma omp parallel for schedule(static)
+  #endif
+  for (int block = 0; block < nBlocks; ++block) {
+    const int begin = block * lineBlock;
+    const int end   = min (begin + lineBlock, lines);
+
+    // Forward elimination
+    for (int l = begin; l < end; ++l)
+      data[l] *= inverseDiagonal (0);
+    for (int k = 1; k < n; ++k) {
+      const double scale = inverseDiagonal (k);
+      double * current        = data + k * lines;
+      const double * previous = data + (k - 1) * lines;
+      for (int l = begin; l < end; ++l)
+        current[l] = (current[l] + mu * previous[l]) * scale;
+    }
+
+    // Back substitution
+    for (int k = n - 2; k >= 0; --k) {
+      const double factor = upper (k);
+      double * current    = data + k * lines;
+      const double * next = data + (k + 1) * lines;
+      for (int l = begin; l < end; ++l)
+        current[l] -= factor * next[l];
+    }
+  }
+}
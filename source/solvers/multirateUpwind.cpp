@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cmath>
+
+#include "debug/exception.h"
+#include "solvers/multirateUpwind.h"
+
+using namespace std;
+
+MultirateUpwind::MultirateUpwind() :
+    M (0),
+    N (0),
+    levels (1),
+    cellUpdates (0) {
+}
+
+void MultirateUpwind::setup (const GridIndex M, const GridIndex N,
+                             const double * dx,
+                             const double * dy,
+                             const int levels) {
+  if (levels < 1 || levels > 16)
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("Multirate advection requires 1 to 16 levels."));
+
+  this->M = M;
+  this->N = N;
+  this->levels = levels;
+
+  this->dx.assign (dx, dx + N);
+  this->dy.assign (dy, dy + M);
+  cellAreas.resize (M * N);
+  for (GridIndex i = 0; i < M; ++i)
+    for (GridIndex j = 0; j < N; ++j)
+      cellAreas[i * N + j] = dx[j] * dy[i];
+
+  cellLevels.assign (M * N, 0);
+  changes.assign (M * N, 0.0);
+  levelCells.assign (levels, vector<GridIndex>());
+  sources.assign (levels, vector<GridIndex>());
+  targets.assign (levels, vector<GridIndex>());
+  rates.assign (levels, vector<double>());
+  amounts.assign (levels, vector<double>());
+}
+
+GridIndex MultirateUpwind::getM() {
+  return M;
+}
+
+GridIndex MultirateUpwind::getN() {
+  return N;
+}
+
+GridIndex MultirateUpwind::getCellUpdates() {
+  return cellUpdates;
+}
+
+const int * MultirateUpwind::getLevelData() {
+  return cellLevels.data();
+}
+
+void MultirateUpwind::step (const double deltaT,
+                            const double cfl,
+                            const double * uVelocity,
+                            const double * vVelocity,
+                            Real * temperature,
+                            Real * composition,
+                            const int K) {
+  assignLevels (deltaT, cfl, uVelocity, vVelocity);
+
+  advanceField (deltaT, temperature, 1);
+  for (int f = 0; f < K; ++f)
+    advanceField (deltaT, composition + f, K);
+}
+
+void MultirateUpwind::assignLevels (const double deltaT,
+                                    const double cfl,
+                                    const double * uVelocity,
+                                    const double * vVelocity) {
+  cellUpdates = 0;
+  for (int k = 0; k < levels; ++k)
+    levelCells[k].clear();
+  for (GridIndex i = 0; i < M; ++i)
+    for (GridIndex j = 0; j < N; ++j) {
+      const double left   = (j > 0)       ? uVelocity[i * (N - 1) + j - 1] : 0;
+      const double right  = (j < (N - 1)) ? uVelocity[i * (N - 1) + j]     : 0;
+      const double bottom = (i > 0)       ? vVelocity[(i - 1) * N + j]     : 0;
+      const double top    = (i < (M - 1)) ? vVelocity[i * N + j]           : 0;
+      const double courant = deltaT * (max (abs (left), abs (right)) / dx[j] +
+                                       max (abs (bottom), abs (top)) / dy[i]);
+
+      int k = 0;
+      while (k < levels - 1 && courant > cfl * (1 << k))
+        ++k;
+      cellLevels[i * N + j] = k;
+      levelCells[k].push_back (i * N + j);
+      cellUpdates += GridIndex (1) << k;
+    }
+
+  for (int k = 0; k < levels; ++k) {
+    sources[k].clear();
+    targets[k].clear();
+    rates[k].clear();
+  }
+
+  auto addFace = [&] (const GridIndex lower, const GridIndex upper, const double velocity, const double length) {
+    if (velocity == 0)
+      return;
+    const int k = max (cellLevels[lower], cellLevels[upper]);
+    sources[k].push_back ((velocity > 0) ? lower : upper);
+    targets[k].push_back ((velocity > 0) ? upper : lower);
+    rates[k].push_back (abs (velocity) * length);
+  };
+
+  for (GridIndex i = 0; i < M; ++i)
+    for (GridIndex j = 1; j < N; ++j)
+      addFace (i * N + j - 1, i * N + j, uVelocity[i * (N - 1) + j - 1], dy[i]);
+  for (GridIndex i = 1; i < M; ++i)
+    for (GridIndex j = 0; j < N; ++j)
+      addFace ((i - 1) * N + j, i * N + j, vVelocity[(i - 1) * N + j], dx[j]);
+
+  for (int k = 0; k < levels; ++k)
+    amounts[k].resize (rates[k].size());
+}
+
+/* The step is taken in 2^(levels - 1) substeps of the finest level. Level k
+ * sweeps its faces at every 2^(levels - 1 - k)-th substep, over a step of
+ * deltaT / 2^k. The changes to a cell are gathered over its own step and
+ * applied at its end, so the fluxes out of it during the step all see the
+ * value at its start: then a constant field stays constant across level
+ * boundaries, and the cell can lose no more than its CFL number allows. */
+void MultirateUpwind::advanceField (const double deltaT, Real * field, const int stride) {
+  const int substeps = 1 << (levels - 1);
+
+  for (int s = 0; s < substeps; ++s) {
+    for (int k = 0; k < levels; ++k) {
+      if (s % (substeps >> k) != 0)
+        continue;
+
+      const double length = deltaT / (1 << k);
+      const GridIndex faces = rates[k].size();
+      const GridIndex * source = sources[k].data();
+      const double * rate = rates[k].data();
+      double * amount = amounts[k].data();
+
+      #ifdef USE_OPENMP
+      #pragma omp parallel for schedule(static)
+      #endif
+      for (GridIndex n = 0; n < faces; ++n)
+        amount[n] = rate[n] * length * field[source[n] * stride];
+
+      for (GridIndex n = 0; n < faces; ++n) {
+        const GridIndex source = sources[k][n], target = targets[k][n];
+        changes[source] -= amounts[k][n] / cellAreas[source];
+        changes[target] += amounts[k][n] / cellAreas[target];
+      }
+    }
+
+    for (int k = 0; k < levels; ++k) {
+      if ((s + 1) % (substeps >> k) != 0)
+        continue;
+
+      for (GridIndex c : levelCells[k]) {
+        field[c * stride] += changes[c];
+        changes[c] = 0;
+      }
+    }
+  }
+}
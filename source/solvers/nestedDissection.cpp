@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <vector>
+
+#include "debug/exception.h"
+#include "solvers/nestedDissection.h"
+
+using namespace Eigen;
+using namespace std;
+
+/// Parts with at most this many unknowns are not dissected further
+const int leafSize = 16;
+/// Width of the separators, in half cells
+const int separatorWidth = 4;
+
+NestedDissectionOrdering::NestedDissectionOrdering (const GridIndex M, const GridIndex N) :
+    M (M),
+    N (N) {
+}
+
+void NestedDissectionOrdering::operator() (const SparseMatrixXd &matrix, Permutation &ordering) {
+  const GridIndex size = 3 * M * N - M - N;
+  if (matrix.rows() != size || matrix.cols() != size)
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("Nested dissection expects the Stokes matrix of its grid."));
+
+  x.resize (size);
+  y.resize (size);
+
+  GridIndex k = 0;
+  // U velocities, on the vertical faces
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N - 1; ++j, ++k) {
+      x[k] = 2 * (j + 1);
+      y[k] = 2 * i + 1;
+    }
+  // V velocities, on the horizontal faces
+  for (int i = 0; i < M - 1; ++i)
+    for (int j = 0; j < N; ++j, ++k) {
+      x[k] = 2 * j + 1;
+      y[k] = 2 * (i + 1);
+    }
+  // Pressures, at the cell centers
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N; ++j, ++k) {
+      x[k] = 2 * j + 1;
+      y[k] = 2 * i + 1;
+    }
+
+  vector<GridIndex> unknowns (size), order;
+  for (GridIndex k = 0; k < size; ++k)
+    unknowns[k] = k;
+  order.reserve (size);
+  dissect (unknowns, order);
+
+  ordering.resize (size);
+  for (GridIndex k = 0; k < size; ++k)
+    ordering.indices()(k) = order[k];
+}
+
+void NestedDissectionOrdering::dissect (vector<GridIndex> &unknowns, vector<GridIndex> &order) {
+  if (unknowns.size() <= (size_t) leafSize) {
+    order.insert (order.end(), unknowns.begin(), unknowns.end());
+    return;
+  }
+
+  int xMin = x[unknowns[0]], xMax = xMin, yMin = y[unknowns[0]], yMax = yMin;
+  for (GridIndex k : unknowns) {
+    xMin = min (xMin, x[k]); xMax = max (xMax, x[k]);
+    yMin = min (yMin, y[k]); yMax = max (yMax, y[k]);
+  }
+
+  /* Split across the longer side at an even coordinate s, i.e. on a line of
+   * faces. SparseLU orders the columns for the pattern of A^T A, in which
+   * unknowns are coupled up to four half cells apart, so the unknowns from
+   * s to s + 3 separate those below s from those above s + 3. */
+  const bool splitX = (xMax - xMin >= yMax - yMin);
+  const vector<int> &coordinate = splitX ? x : y;
+  const int split = ((splitX ? xMin + xMax : yMin + yMax) / 2) & ~1;
+
+  vector<GridIndex> lower, upper, separator;
+  for (GridIndex k : unknowns) {
+    if (coordinate[k] < split)
+      lower.push_back (k);
+    else if (coordinate[k] >= split + separatorWidth)
+      upper.push_back (k);
+    else
+      separator.push_back (k);
+  }
+
+  if (lower.empty() || upper.empty()) {
+    order.insert (order.end(), unknowns.begin(), unknowns.end());
+    return;
+  }
+
+  unknowns.clear();
+  unknowns.shrink_to_fit();
+  dissect (lower, order);
+  dissect (upper, order);
+  order.insert (order.end(), separator.begin(), separator.end());
+}
@@ -0,0 +1,155 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "boost/filesystem.hpp"
+
+#include "debug/exception.h"
+#include "solvers/orderingCache.h"
+
+using namespace Eigen;
+using namespace std;
+
+/** Layout of a cache file: this header followed by **size** GridIndex
+ *  column indices.
+ */
+struct OrderingHeader {
+  char magic[8];
+  boost::uint64_t key;
+  boost::int64_t size;
+};
+
+static const char orderingMagic[8] = "mcorder";
+
+// 64-bit FNV-1a hash of n bytes, continuing from hash.
+static boost::uint64_t fnv1a (const void * data, const size_t n, boost::uint64_t hash) {
+  const unsigned char * bytes = static_cast<const unsigned char *>(data);
+  for (size_t k = 0; k < n; ++k) {
+    hash ^= bytes[k];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+OrderingCache::OrderingCache() {}
+
+void OrderingCache::setDirectory (const std::string &directory) {
+  this->directory = directory;
+  if (directory.empty())
+    return;
+
+  boost::system::error_code ec;
+  boost::filesystem::create_directories (directory, ec);
+  if (ec) {
+    THROW_WITH_TRACE(RuntimeError() <<
+            errmsg_info("Couldn't create directory '" + directory + "'."));
+  }
+}
+
+bool OrderingCache::enabled() {
+  return !directory.empty();
+}
+
+boost::uint64_t OrderingCache::key (const SparseMatrixXd &matrix,
+                                    const std::string &method) {
+  if (!matrix.isCompressed())
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("Ordering cache keys require a compressed matrix."));
+
+  const boost::int64_t rows = matrix.rows(), cols = matrix.cols();
+
+  boost::uint64_t hash = 14695981039346656037ULL;
+  hash = fnv1a (&rows, sizeof (rows), hash);
+  hash = fnv1a (&cols, sizeof (cols), hash);
+  hash = fnv1a (matrix.outerIndexPtr(), (cols + 1) * sizeof (GridIndex), hash);
+  hash = fnv1a (matrix.innerIndexPtr(), matrix.nonZeros() * sizeof (GridIndex), hash);
+  hash = fnv1a (method.data(), method.size(), hash);
+  return hash;
+}
+
+bool OrderingCache::load (const boost::uint64_t key, const GridIndex size, Permutation &ordering) {
+  if (!enabled())
+    return false;
+
+  int file = open (path (key).c_str(), O_RDONLY);
+  if (file < 0)
+    return false;
+
+  const size_t expectedBytes = sizeof (OrderingHeader) + size_t (size) * sizeof (GridIndex);
+  struct stat status;
+  if (fstat (file, &status) != 0 || size_t (status.st_size) != expectedBytes) {
+    close (file);
+    return false;
+  }
+
+  void * mapping = mmap (NULL, expectedBytes, PROT_READ, MAP_PRIVATE, file, 0);
+  close (file);
+  if (mapping == MAP_FAILED)
+    return false;
+
+  const OrderingHeader * header = static_cast<const OrderingHeader *>(mapping);
+  const GridIndex * indices = reinterpret_cast<const GridIndex *>(header + 1);
+
+  bool valid = (memcmp (header->magic, orderingMagic, sizeof (orderingMagic)) == 0 &&
+                header->key == key && header->size == size);
+
+  // Reject anything that is not a permutation rather than hand it to the
+  // factorization.
+  vector<bool> seen (valid ? size : 0, false);
+  for (GridIndex k = 0; valid && k < size; ++k) {
+    valid = (indices[k] >= 0 && indices[k] < size && !seen[indices[k]]);
+    if (valid)
+      seen[indices[k]] = true;
+  }
+
+  if (valid) {
+    ordering.resize (size);
+    memcpy (ordering.indices().data(), indices, size * sizeof (GridIndex));
+  }
+
+  munmap (mapping, expectedBytes);
+  return valid;
+}
+
+void OrderingCache::store (const boost::uint64_t key, const Permutation &ordering) {
+  if (!enabled())
+    return;
+
+  OrderingHeader header;
+  memcpy (header.magic, orderingMagic, sizeof (orderingMagic));
+  header.key  = key;
+  header.size = ordering.size();
+
+  // Write to a file private to this call (concurrent batch runs share the
+  // process) and rename it into place, so that no run ever sees a partial
+  // entry.
+  const string temporaryPath =
+      path (key) + "." + boost::filesystem::unique_path ("%%%%-%%%%-%%%%-%%%%").string();
+
+  ofstream file (temporaryPath.c_str(), ofstream::out | ofstream::binary);
+  file.write (reinterpret_cast<const char *>(&header), sizeof (header));
+  file.write (reinterpret_cast<const char *>(ordering.indices().data()),
+              ordering.size() * sizeof (GridIndex));
+  file.close();
+
+  // The entry only saves later runs some work, so losing it is not an error.
+  if (!file || rename (temporaryPath.c_str(), path (key).c_str()) != 0) {
+    remove (temporaryPath.c_str());
+    cerr << "<Couldn't write ordering cache entry '" << path (key) << "'>" << endl;
+  }
+}
+
+std::string OrderingCache::path (const boost::uint64_t key) {
+  ostringstream name;
+  name << directory << "/stokes-" << hex << key << ".ordering";
+  return name.str();
+}
@@ -0,0 +1,279 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "debug/exception.h"
+#include "solvers/petscStokesSolver.h"
+
+using namespace Eigen;
+using namespace std;
+
+#ifdef USE_PETSC
+static_assert (sizeof (PetscScalar) == sizeof (double),
+               "The Stokes solver requires PETSc built with real double precision scalars.");
+
+// Turn a PETSc error code into an exception.
+static void check (const PetscErrorCode error) {
+  if (error) {
+    const char * text = NULL;
+    PetscErrorMessage (error, &text, NULL);
+    THROW_WITH_TRACE(RuntimeError() <<
+            errmsg_info("PETSc error: " + string (text ? text : "unknown")));
+  }
+}
+
+/* Upper bound on the entries of a row of the staggered Stokes system: a
+ * velocity row has five Laplacian and two gradient entries, a pressure row
+ * four divergence entries. */
+static const PetscInt maxRowEntries = 7;
+
+// Set option **name** to **value** unless the user has set it.
+static void setDefaultOption (const char * name, const char * value) {
+  PetscBool set;
+  check (PetscOptionsHasName (NULL, NULL, name, &set));
+  if (!set)
+    check (PetscOptionsSetValue (NULL, name, value));
+}
+#endif
+
+PetscStokesSolver::PetscStokesSolver() :
+    tolerance (1E-10),
+    maxIterations (500),
+    iterations (0)
+  #ifdef USE_PETSC
+    ,
+    rowBegin (0),
+    rowEnd (0),
+    size (0),
+    matrix (NULL),
+    ksp (NULL),
+    velocityRows (NULL),
+    pressureRows (NULL),
+    nullSpace (NULL),
+    rhsVector (NULL),
+    solutionVector (NULL),
+    rootVector (NULL),
+    scatter (NULL)
+  #endif
+{
+}
+
+PetscStokesSolver::~PetscStokesSolver() {
+  destroy();
+}
+
+bool PetscStokesSolver::available() {
+  #ifdef USE_PETSC
+  return true;
+  #else
+  return false;
+  #endif
+}
+
+void PetscStokesSolver::setup (const double tolerance, const int maxIterations) {
+  this->tolerance     = tolerance;
+  this->maxIterations = maxIterations;
+}
+
+void PetscStokesSolver::ownedRows (const GridIndex size, GridIndex &rowBegin, GridIndex &rowEnd) {
+  #ifdef USE_PETSC
+  // Normally initialized in main(); unit tests start it here.
+  if (!PetscInitializeCalled)
+    check (PetscInitializeNoArguments());
+
+  destroy();
+
+  this->size = size;
+  check (MatCreate (PETSC_COMM_WORLD, &matrix));
+  check (MatSetSizes (matrix, PETSC_DECIDE, PETSC_DECIDE, size, size));
+  check (MatSetType (matrix, MATAIJ));
+  // The bound holds for SparseForms; other matrices only assemble slower.
+  check (MatSeqAIJSetPreallocation (matrix, maxRowEntries, NULL));
+  check (MatMPIAIJSetPreallocation (matrix, maxRowEntries, NULL, maxRowEntries, NULL));
+  check (MatSetOption (matrix, MAT_NEW_NONZERO_ALLOCATION_ERR, PETSC_FALSE));
+  check (MatGetOwnershipRange (matrix, &this->rowBegin, &this->rowEnd));
+
+  rowBegin = this->rowBegin;
+  rowEnd   = this->rowEnd;
+  #else
+  THROW_WITH_TRACE(RuntimeError() <<
+          errmsg_info("mc-mini was built without PETSc (PETSC_ENABLED)."));
+  #endif
+}
+
+void PetscStokesSolver::compute (const SparseMatrixXd &stokesRows, const GridIndex pressureSize) {
+  #ifdef USE_PETSC
+  if (!matrix || ksp)
+    THROW_WITH_TRACE(RuntimeError() <<
+            errmsg_info("The PETSc Stokes solver needs ownedRows() before each compute()."));
+  if (stokesRows.rows() != rowEnd - rowBegin || stokesRows.cols() != size)
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("The PETSc Stokes matrix must hold the rows given by ownedRows()."));
+
+  const PetscInt velocitySize = size - pressureSize;
+
+  SparseMatrix<double, RowMajor, GridIndex> rows = stokesRows;
+
+  vector<PetscInt> columns;
+  vector<PetscScalar> values;
+  for (PetscInt r = rowBegin; r < rowEnd; ++r) {
+    columns.clear();
+    values.clear();
+    for (SparseMatrix<double, RowMajor, GridIndex>::InnerIterator it (rows, r - rowBegin); it; ++it) {
+      columns.push_back (it.col());
+      values.push_back (it.value());
+    }
+    check (MatSetValues (matrix, 1, &r, columns.size(), columns.data(), values.data(), INSERT_VALUES));
+  }
+  check (MatAssemblyBegin (matrix, MAT_FINAL_ASSEMBLY));
+  check (MatAssemblyEnd (matrix, MAT_FINAL_ASSEMBLY));
+
+  // This process' velocity and pressure rows.
+  const PetscInt velocityEnd   = min (rowEnd, velocitySize);
+  const PetscInt pressureBegin = max (rowBegin, velocitySize);
+  check (ISCreateStride (PETSC_COMM_WORLD, max (velocityEnd - rowBegin, PetscInt (0)),
+                         rowBegin, 1, &velocityRows));
+  check (ISCreateStride (PETSC_COMM_WORLD, max (rowEnd - pressureBegin, PetscInt (0)),
+                         pressureBegin, 1, &pressureRows));
+
+  check (MatCreateVecs (matrix, &solutionVector, &rhsVector));
+  check (VecScatterCreateToZero (solutionVector, &scatter, &rootVector));
+
+  // The pressure is only determined up to a constant.
+  Vec constantPressure;
+  check (VecDuplicate (rhsVector, &constantPressure));
+  check (VecSet (constantPressure, 0));
+  for (PetscInt r = pressureBegin; r < rowEnd; ++r)
+    check (VecSetValue (constantPressure, r, 1, INSERT_VALUES));
+  check (VecAssemblyBegin (constantPressure));
+  check (VecAssemblyEnd (constantPressure));
+  check (VecNormalize (constantPressure, NULL));
+  check (MatNullSpaceCreate (PETSC_COMM_WORLD, PETSC_FALSE, 1, &constantPressure, &nullSpace));
+  check (MatSetNullSpace (matrix, nullSpace));
+  check (VecDestroy (&constantPressure));
+
+  MatNullSpace schurNullSpace;
+  check (MatNullSpaceCreate (PETSC_COMM_WORLD, PETSC_TRUE, 0, NULL, &schurNullSpace));
+  check (PetscObjectCompose ((PetscObject) pressureRows, "nullspace", (PetscObject) schurNullSpace));
+  check (MatNullSpaceDestroy (&schurNullSpace));
+
+  check (KSPCreate (PETSC_COMM_WORLD, &ksp));
+  check (KSPSetOptionsPrefix (ksp, "stokes_"));
+  check (KSPSetOperators (ksp, matrix, matrix));
+  check (KSPSetType (ksp, KSPFGMRES));
+  check (KSPSetTolerances (ksp, tolerance, PETSC_DEFAULT, PETSC_DEFAULT, maxIterations));
+
+  PC pc;
+  check (KSPGetPC (ksp, &pc));
+  check (PCSetType (pc, PCFIELDSPLIT));
+  check (PCFieldSplitSetIS (pc, "velocity", velocityRows));
+  check (PCFieldSplitSetIS (pc, "pressure", pressureRows));
+  check (PCFieldSplitSetType (pc, PC_COMPOSITE_SCHUR));
+  check (PCFieldSplitSetSchurFactType (pc, PC_FIELDSPLIT_SCHUR_FACT_FULL));
+  check (PCFieldSplitSetSchurPre (pc, PC_FIELDSPLIT_SCHUR_PRE_SELFP, NULL));
+  setDefaultOption ("-stokes_fieldsplit_velocity_pc_type", "gamg");
+
+  check (KSPSetFromOptions (ksp));
+  check (KSPSetUp (ksp));
+
+  #ifdef DEBUG
+    cout << "<Set up the PETSc Stokes solver on rows [" << rowBegin << ", " << rowEnd
+         << ") of " << size << ">" << endl;
+  #endif
+  #else
+  THROW_WITH_TRACE(RuntimeError() <<
+          errmsg_info("mc-mini was built without PETSc (PETSC_ENABLED)."));
+  #endif
+}
+
+void PetscStokesSolver::solve (const MatrixXd &rhs, const MatrixXd &guess, MatrixXd &solution) {
+  #ifdef USE_PETSC
+  PetscMPIInt rank;
+  MPI_Comm_rank (PETSC_COMM_WORLD, &rank);
+
+  // The columns, and whether to warm start them, are up to the first process.
+  PetscInt columns = rhs.cols();
+  int warmStart = (guess.cols() == rhs.cols() && guess.rows() == rhs.rows());
+  MPI_Bcast (&columns, 1, MPIU_INT, 0, PETSC_COMM_WORLD);
+  MPI_Bcast (&warmStart, 1, MPI_INT, 0, PETSC_COMM_WORLD);
+
+  solution.resize (rank == 0 ? size : 0, columns);
+  iterations = 0;
+  check (KSPSetInitialGuessNonzero (ksp, warmStart ? PETSC_TRUE : PETSC_FALSE));
+
+  for (PetscInt k = 0; k < columns; ++k) {
+    PetscScalar * values;
+    if (rank == 0) {
+      check (VecGetArray (rootVector, &values));
+      Map<VectorXd> (values, size) = rhs.col (k);
+      check (VecRestoreArray (rootVector, &values));
+    }
+    check (VecScatterBegin (scatter, rootVector, rhsVector, INSERT_VALUES, SCATTER_REVERSE));
+    check (VecScatterEnd (scatter, rootVector, rhsVector, INSERT_VALUES, SCATTER_REVERSE));
+
+    if (warmStart) {
+      if (rank == 0) {
+        check (VecGetArray (rootVector, &values));
+        Map<VectorXd> (values, size) = guess.col (k);
+        check (VecRestoreArray (rootVector, &values));
+      }
+      check (VecScatterBegin (scatter, rootVector, solutionVector, INSERT_VALUES, SCATTER_REVERSE));
+      check (VecScatterEnd (scatter, rootVector, solutionVector, INSERT_VALUES, SCATTER_REVERSE));
+    }
+
+    // Keep the right-hand side consistent with the singular system.
+    check (MatNullSpaceRemove (nullSpace, rhsVector));
+
+    check (KSPSolve (ksp, rhsVector, solutionVector));
+
+    KSPConvergedReason reason;
+    check (KSPGetConvergedReason (ksp, &reason));
+    if (reason < 0)
+      THROW_WITH_TRACE(RuntimeError() <<
+              errmsg_info("The PETSc Stokes solve diverged (reason " + to_string (int (reason)) + ")."));
+
+    PetscInt columnIterations;
+    check (KSPGetIterationNumber (ksp, &columnIterations));
+    iterations += columnIterations;
+
+    check (VecScatterBegin (scatter, solutionVector, rootVector, INSERT_VALUES, SCATTER_FORWARD));
+    check (VecScatterEnd (scatter, solutionVector, rootVector, INSERT_VALUES, SCATTER_FORWARD));
+
+    if (rank == 0) {
+      const PetscScalar * rootValues;
+      check (VecGetArrayRead (rootVector, &rootValues));
+      solution.col (k) = Map<const VectorXd> (rootValues, size);
+      check (VecRestoreArrayRead (rootVector, &rootValues));
+    }
+  }
+
+  #ifdef DEBUG
+    cout << "<PETSc Stokes solve took " << iterations << " iterations>" << endl;
+  #endif
+  #else
+  THROW_WITH_TRACE(RuntimeError() <<
+          errmsg_info("mc-mini was built without PETSc (PETSC_ENABLED)."));
+  #endif
+}
+
+int PetscStokesSolver::getIterations() {
+  return iterations;
+}
+
+void PetscStokesSolver::destroy() {
+  #ifdef USE_PETSC
+  // Objects cannot be released once PETSc has shut down.
+  if (!PetscInitializeCalled || PetscFinalizeCalled)
+    return;
+
+  KSPDestroy (&ksp);
+  MatNullSpaceDestroy (&nullSpace);
+  VecScatterDestroy (&scatter);
+  VecDestroy (&rootVector);
+  VecDestroy (&solutionVector);
+  VecDestroy (&rhsVector);
+  ISDestroy (&velocityRows);
+  ISDestroy (&pressureRows);
+  MatDestroy (&matrix);
+  #endif
+}
@@ -0,0 +1,142 @@
+#include <cmath>
+
+#include "solvers/rklDiffusionSolver.h"
+
+using namespace std;
+
+// RKL2 coefficient b_j = (j^2 + j - 2) / (2 j (j + 1)), with b_0 = b_1 = b_2 = 1/3
+static double legendreCoefficient (const int j) {
+  if (j < 2)
+    return 1.0 / 3;
+  return (j * j + j - 2.0) / (2.0 * j * (j + 1));
+}
+
+RKLDiffusionSolver::RKLDiffusionSolver() :
+    M (0),
+    N (0),
+    xScale (0),
+    yScale (0) {
+}
+
+void RKLDiffusionSolver::setup (const GridIndex M, const GridIndex N) {
+  this->M = M;
+  this->N = N;
+
+  initialStencil.resize (M * N);
+  stageBuffers.resize (2 * M * N);
+}
+
+GridIndex RKLDiffusionSolver::getM() {
+  return M;
+}
+
+GridIndex RKLDiffusionSolver::getN() {
+  return N;
+}
+
+int RKLDiffusionSolver::stageCount (const double ratio) {
+  int s = int (ceil ((sqrt (9 + 16 * ratio) - 1) / 2));
+  while ((s * s + s - 2) < 4 * ratio) ++s;
+  return max (s, 2);
+}
+
+int RKLDiffusionSolver::step (const double deltaT,
+                              const double diffusivity,
+                              const double hx,
+                              const double hy,
+                              const double * temperature,
+                              const double * boundary,
+                              double * result) {
+  xScale = diffusivity * deltaT / (hx * hx);
+  yScale = diffusivity * deltaT / (hy * hy);
+
+  // The forward Euler limit is dt <= 1 / (2 kappa (1 / hx^2 + 1 / hy^2)).
+  const int s = stageCount (2 * (xScale + yScale));
+  const double w1 = 4.0 / (s * s + s - 2);
+
+  // L(T^n), scaled by kappa dt
+  stage (0, temperature, 0, 0, 0, temperature, 1, 0, 0, boundary, initialStencil.data());
+
+  /* Stage j is written to buffers[(j + offset) % 3], with the offset chosen
+   * so that the final stage lands in the caller's result array.
+   */
+  double * buffers[3] = {stageBuffers.data(), stageBuffers.data() + M * N, result};
+  const int offset = (2 - s % 3 + 3) % 3;
+  const double * previous = temperature;
+  const double * beforePrevious = 0;
+
+  for (int j = 1; j <= s; ++j) {
+    double * current = buffers[(j + offset) % 3];
+
+    if (j == 1) {
+      // Y_1 = Y_0 + (b_1 w_1) dt L(Y_0)
+      stage (0, temperature, 0, 0, 1, temperature, 0, legendreCoefficient (1) * w1, initialStencil.data(), boundary, current);
+    } else {
+      double mu    = (2.0 * j - 1) / j * legendreCoefficient (j) / legendreCoefficient (j - 1);
+      double nu    = -(j - 1.0) / j * legendreCoefficient (j) / legendreCoefficient (j - 2);
+      double muT   = mu * w1;
+      double gamma = -(1 - legendreCoefficient (j - 1)) * muT;
+
+      stage (mu, previous, nu, beforePrevious, 1 - mu - nu, temperature,
+             muT, gamma, initialStencil.data(), boundary, current);
+    }
+
+    beforePrevious = previous;
+    previous = current;
+  }
+
+  return s;
+}
+
+int RKLDiffusionSolver::step (const double deltaT,
+                              const double diffusivity,
+                              const double hx,
+                              const double hy,
+                              const float * temperature,
+                              const float * boundary,
+                              float * result) {
+  workTemperature = Eigen::Map<const Eigen::VectorXf> (temperature, M * N).cast<double>();
+  workBoundary    = Eigen::Map<const Eigen::VectorXf> (boundary, 2 * N).cast<double>();
+  workResult.resize (M * N);
+
+  int s = step (deltaT, diffusivity, hx, hy, workTemperature.data(), workBoundary.data(), workResult.data());
+  Eigen::Map<Eigen::VectorXf> (result, M * N) = workResult.cast<float>();
+  return s;
+}
+
+void RKLDiffusionSolver::stage (const double a, const double * Y,
+                                const double b, const double * Z,
+                                const double c, const double * T,
+                                const double d,
+                                const double e, const double * lT,
+                                const double * boundary,
+                                double * out) {
+  const double dx = d * xScale;
+  const double dy = d * yScale;
+
+  #ifdef USE_OPENMP
+  #pragma omp parallel for schedule(static)
+  #endif
+  for (int i = 0; i < M; ++i) {
+    const double * row   = Y + i * N;
+    const double * below = (i == 0)       ? boundary     : Y + (i - 1) * N;
+    const double * above = (i == (M - 1)) ? boundary + N : Y + (i + 1) * N;
+
+    for (int j = 0; j < N; ++j) {
+      double value = c * T[i * N + j];
+      if (a != 0) value += a * row[j];
+      if (b != 0) value += b * Z[i * N + j];
+      if (e != 0) value += e * lT[i * N + j];
+
+      if (d != 0) {
+        // Insulated sides reuse the cell's own value as the ghost value.
+        double left  = (j == 0)       ? row[j] : row[j - 1];
+        double right = (j == (N - 1)) ? row[j] : row[j + 1];
+        value += dx * (left + right - 2 * row[j]) +
+                 dy * (below[j] + above[j] - 2 * row[j]);
+      }
+
+      out[i * N + j] = value;
+    }
+  }
+}
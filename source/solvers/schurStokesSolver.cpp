@@ -0,0 +1,212 @@
+#include <iostream>
+#include <cmath>
+#include <limits>
+#include <string>
+
+#include "debug/exception.h"
+#include "solvers/schurStokesSolver.h"
+
+using namespace Eigen;
+using namespace std;
+
+// Remove the constant pressure mode from **pressure**.
+static void removeMean (VectorXd &pressure) {
+  pressure.array() -= pressure.mean();
+}
+
+SchurStokesSolver::SchurStokesSolver() :
+    tolerance (1E-10),
+    maxIterations (500),
+    iterations (0),
+    symmetric (false) {
+}
+
+void SchurStokesSolver::setup (const double tolerance, const int maxIterations) {
+  if (tolerance < 0 || maxIterations < 1)
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("The Schur complement Stokes solver requires tolerance >= 0 and maxIterations >= 1."));
+
+  this->tolerance     = tolerance;
+  this->maxIterations = maxIterations;
+}
+
+void SchurStokesSolver::compute (const SparseMatrixXd &matrix, const GridIndex pressureSize) {
+  const GridIndex velocitySize = matrix.rows() - pressureSize;
+
+  velocityBlock = matrix.block (0, 0, velocitySize, velocitySize);
+  gradient      = matrix.block (0, velocitySize, velocitySize, pressureSize);
+  divergence    = matrix.block (velocitySize, 0, pressureSize, velocitySize);
+
+  SparseMatrixXd velocityTranspose = velocityBlock.transpose();
+  symmetric = (velocityBlock - velocityTranspose).norm() <=
+              std::numeric_limits<double>::epsilon() * velocityBlock.norm();
+
+  if (symmetric) {
+    choleskySolver.compute (velocityBlock);
+    if (choleskySolver.info() != Success)
+      THROW_WITH_TRACE(RuntimeError() <<
+              errmsg_info("The Cholesky factorization of the Stokes velocity block failed."));
+  } else {
+    luSolver.analyzePattern (velocityBlock);
+    luSolver.factorize (velocityBlock);
+    if (luSolver.info() != Success)
+      THROW_WITH_TRACE(RuntimeError() <<
+              errmsg_info("The LU factorization of the Stokes velocity block failed."));
+  }
+
+  /* The Schur complement behaves like the pressure mass matrix scaled by the
+   * inverse viscosity. Lumping K to its diagonal, cell i is weighted by
+   * sum_k G_ki^2 / K_kk over its faces k, which is 1 / viscosity for the
+   * interior cells of a uniform grid. */
+  pressureScaling = VectorXd::Zero (pressureSize);
+  VectorXd velocityDiagonal = velocityBlock.diagonal();
+  for (GridIndex i = 0; i < gradient.outerSize(); ++i)
+    for (SparseMatrixXd::InnerIterator it (gradient, i); it; ++it)
+      pressureScaling (it.col()) += it.value() * it.value() / velocityDiagonal (it.row());
+  pressureScaling = pressureScaling.cwiseInverse();
+
+  #ifdef DEBUG
+    cout << "<Factored the " << velocitySize << "x" << velocitySize << " Stokes velocity block with "
+         << (symmetric ? "Cholesky" : "LU") << ">" << endl;
+  #endif
+}
+
+void SchurStokesSolver::solve (const MatrixXd &rhs, const MatrixXd &guess, MatrixXd &solution) {
+  const GridIndex velocitySize = velocityBlock.rows();
+  const GridIndex pressureSize = gradient.cols();
+
+  solution.resize (rhs.rows(), rhs.cols());
+  iterations = 0;
+
+  for (int k = 0; k < rhs.cols(); ++k) {
+    VectorXd velocityRhs = rhs.col (k).head (velocitySize);
+    VectorXd pressureRhs = rhs.col (k).tail (pressureSize);
+
+    // With the divergence -G^T, the Schur complement system is
+    // G^T K^-1 G p = g - D K^-1 f.
+    VectorXd schurRhs = pressureRhs - divergence * solveVelocity (velocityRhs);
+    removeMean (schurRhs);
+
+    VectorXd pressure = VectorXd::Zero (pressureSize);
+    if (guess.cols() == rhs.cols() && guess.rows() == rhs.rows()) {
+      pressure = guess.col (k).tail (pressureSize);
+      removeMean (pressure);
+    }
+    if (symmetric)
+      conjugateGradient (schurRhs, pressure);
+    else
+      biconjugateGradientStabilized (schurRhs, pressure);
+
+    solution.col (k).head (velocitySize) = solveVelocity (velocityRhs - gradient * pressure);
+    solution.col (k).tail (pressureSize) = pressure;
+  }
+
+  #ifdef DEBUG
+    cout << "<Schur complement Stokes solve took " << iterations << " iterations>" << endl;
+  #endif
+}
+
+int SchurStokesSolver::getIterations() {
+  return iterations;
+}
+
+bool SchurStokesSolver::symmetricVelocityBlock() {
+  return symmetric;
+}
+
+VectorXd SchurStokesSolver::applySchur (const VectorXd &pressure) {
+  return -(divergence * solveVelocity (gradient * pressure));
+}
+
+VectorXd SchurStokesSolver::solveVelocity (const VectorXd &velocity) {
+  if (symmetric)
+    return choleskySolver.solve (velocity);
+  else
+    return luSolver.solve (velocity);
+}
+
+VectorXd SchurStokesSolver::precondition (const VectorXd &residual) {
+  VectorXd result = pressureScaling.cwiseProduct (residual);
+  removeMean (result);
+  return result;
+}
+
+void SchurStokesSolver::conjugateGradient (const VectorXd &rhs, VectorXd &pressure) {
+  const double target = tolerance * rhs.norm();
+
+  VectorXd residual = rhs - applySchur (pressure);
+  if (residual.norm() <= target)
+    return;
+
+  VectorXd preconditioned = precondition (residual);
+  VectorXd direction      = preconditioned;
+  double rz = residual.dot (preconditioned);
+
+  for (int iteration = 1; iteration <= maxIterations; ++iteration) {
+    VectorXd product = applySchur (direction);
+    double alpha     = rz / direction.dot (product);
+
+    pressure += alpha * direction;
+    residual -= alpha * product;
+    ++iterations;
+
+    if (residual.norm() <= target)
+      return;
+
+    preconditioned = precondition (residual);
+    double nextRz  = residual.dot (preconditioned);
+    direction      = preconditioned + (nextRz / rz) * direction;
+    rz             = nextRz;
+  }
+
+  THROW_WITH_TRACE(RuntimeError() <<
+          errmsg_info("The Schur complement Stokes solve did not converge in " +
+                      to_string (maxIterations) + " iterations."));
+}
+
+void SchurStokesSolver::biconjugateGradientStabilized (const VectorXd &rhs, VectorXd &pressure) {
+  const double target = tolerance * rhs.norm();
+
+  VectorXd residual = rhs - applySchur (pressure);
+  if (residual.norm() <= target)
+    return;
+
+  const VectorXd shadow = residual;
+  VectorXd direction = VectorXd::Zero (rhs.size());
+  VectorXd product   = VectorXd::Zero (rhs.size());
+  double rho = 1, alpha = 1, omega = 1;
+
+  for (int iteration = 1; iteration <= maxIterations; ++iteration) {
+    double nextRho = shadow.dot (residual);
+    if (nextRho == 0 || omega == 0)
+      break;
+
+    direction = residual + (nextRho / rho) * (alpha / omega) * (direction - omega * product);
+    rho = nextRho;
+
+    VectorXd preconditioned = precondition (direction);
+    product = applySchur (preconditioned);
+    alpha   = rho / shadow.dot (product);
+
+    VectorXd intermediate = residual - alpha * product;
+    ++iterations;
+    if (intermediate.norm() <= target) {
+      pressure += alpha * preconditioned;
+      return;
+    }
+
+    VectorXd stabilizer        = precondition (intermediate);
+    VectorXd stabilizerProduct = applySchur (stabilizer);
+    omega = stabilizerProduct.dot (intermediate) / stabilizerProduct.squaredNorm();
+
+    pressure += alpha * preconditioned + omega * stabilizer;
+    residual  = intermediate - omega * stabilizerProduct;
+
+    if (residual.norm() <= target)
+      return;
+  }
+
+  THROW_WITH_TRACE(RuntimeError() <<
+          errmsg_info("The Schur complement Stokes solve did not converge in " +
+                      to_string (maxIterations) + " iterations."));
+}
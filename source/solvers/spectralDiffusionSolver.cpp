@@ -0,0 +1,126 @@
+#include <cmath>
+
+#include "boost/math/constants/constants.hpp"
+
+#include "solvers/spectralDiffusionSolver.h"
+
+using namespace std;
+
+SpectralDiffusionSolver::SpectralDiffusionSolver() :
+    M (0),
+    N (0) {
+}
+
+void SpectralDiffusionSolver::setup (const GridIndex M, const GridIndex N) {
+  const double pi = boost::math::constants::pi<double>();
+
+  this->M = M;
+  this->N = N;
+
+  /* The one-dimensional second-difference operators have eigenvalues
+   *   4 sin^2 (pi k / 2N),       k = 0 .. N-1  (Neumann, DCT-II modes)
+   *   4 sin^2 (pi l / 2(M + 1)), l = 1 .. M    (Dirichlet, DST-I modes)
+   */
+  xEigenvalues.resize (N);
+  for (int k = 0; k < N; ++k)
+    xEigenvalues (k) = 4 * pow (sin (pi * k / (2.0 * N)), 2);
+
+  yEigenvalues.resize (M);
+  for (int l = 0; l < M; ++l)
+    yEigenvalues (l) = 4 * pow (sin (pi * (l + 1) / (2.0 * (M + 1))), 2);
+
+  xTwiddle.resize (N);
+  for (int k = 0; k < N; ++k)
+    xTwiddle[k] = polar (1.0, -pi * k / (2.0 * N));
+
+  xBuffer.resize (2 * N);
+  xSpectrum.resize (2 * N);
+  yBuffer.resize (2 * (M + 1));
+  ySpectrum.resize (2 * (M + 1));
+}
+
+GridIndex SpectralDiffusionSolver::getM() {
+  return M;
+}
+
+GridIndex SpectralDiffusionSolver::getN() {
+  return N;
+}
+
+void SpectralDiffusionSolver::solve (const double muX, const double muY, double * data) {
+  for (int i = 0; i < M; ++i)
+    forwardCosineTransform (data + i * N);
+
+  for (int j = 0; j < N; ++j)
+    sineTransform (data + j);
+
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N; ++j)
+      data[i * N + j] /= 1 + muX * xEigenvalues (j) + muY * yEigenvalues (i);
+
+  // The DST-I is its own inverse up to a factor of 2 / (M + 1).
+  for (int j = 0; j < N; ++j)
+    sineTransform (data + j);
+
+  const double sineScale = 2.0 / (M + 1);
+  for (int i = 0; i < M; ++i) {
+    for (int j = 0; j < N; ++j)
+      data[i * N + j] *= sineScale;
+    inverseCosineTransform (data + i * N);
+  }
+}
+
+void SpectralDiffusionSolver::solve (const double muX, const double muY, float * data) {
+  work = Eigen::Map<Eigen::VectorXf> (data, M * N).cast<double>();
+  solve (muX, muY, work.data());
+  Eigen::Map<Eigen::VectorXf> (data, M * N) = work.cast<float>();
+}
+
+/* X_k = sum_j x_j cos (pi k (j + 1/2) / N) is computed from the FFT Y of the
+ * even extension [x_0 .. x_{N-1}, x_{N-1} .. x_0] as X_k = Re (e^{-i pi k / 2N} Y_k) / 2.
+ */
+void SpectralDiffusionSolver::forwardCosineTransform (double * row) {
+  for (int j = 0; j < N; ++j) {
+    xBuffer[j]             = row[j];
+    xBuffer[2 * N - 1 - j] = row[j];
+  }
+
+  fft.fwd (xSpectrum, xBuffer);
+
+  for (int k = 0; k < N; ++k)
+    row[k] = real (xTwiddle[k] * xSpectrum[k]) / 2;
+}
+
+/* Rebuilds the spectrum of the even extension from X (Y_k = 2 e^{i pi k / 2N} X_k,
+ * Y_N = 0, Y_{2N-k} = conj (Y_k)) and inverts it.
+ */
+void SpectralDiffusionSolver::inverseCosineTransform (double * row) {
+  xSpectrum[0] = 2 * row[0];
+  xSpectrum[N] = 0;
+  for (int k = 1; k < N; ++k) {
+    xSpectrum[k]         = 2 * row[k] * conj (xTwiddle[k]);
+    xSpectrum[2 * N - k] = conj (xSpectrum[k]);
+  }
+
+  fft.inv (xBuffer, xSpectrum);
+
+  for (int j = 0; j < N; ++j)
+    row[j] = real (xBuffer[j]);
+}
+
+/* X_l = sum_i x_i sin (pi (l + 1) (i + 1) / (M + 1)) is computed from the FFT Y
+ * of the odd extension [0, x_0 .. x_{M-1}, 0, -x_{M-1} .. -x_0] as X_l = -Im (Y_{l+1}) / 2.
+ */
+void SpectralDiffusionSolver::sineTransform (double * column) {
+  yBuffer[0]     = 0;
+  yBuffer[M + 1] = 0;
+  for (int i = 0; i < M; ++i) {
+    yBuffer[i + 1]         =  column[i * N];
+    yBuffer[2 * M + 1 - i] = -column[i * N];
+  }
+
+  fft.fwd (ySpectrum, yBuffer);
+
+  for (int l = 0; l < M; ++l)
+    column[l * N] = -imag (ySpectrum[l + 1]) / 2;
+}
@@ -0,0 +1,326 @@
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include <Eigen/OrderingMethods>
+#ifdef USE_METIS
+#include <Eigen/MetisSupport>
+#endif
+
+#include "debug/exception.h"
+#include "solvers/nestedDissection.h"
+#include "solvers/petscStokesSolver.h"
+#include "solvers/schurStokesSolver.h"
+#include "solvers/stokesSolver.h"
+
+using namespace Eigen;
+using namespace std;
+
+/// Refinement stalls when a step leaves more than this fraction of the residual
+const double stallFactor = 0.5;
+
+StokesSolver::StokesSolver() :
+    precision ("double"),
+    tolerance (1E-10),
+    maxRefinements (10),
+    backend ("eigen"),
+    pressureSize (0),
+    maxIterations (0),
+    matrix (NULL),
+    orderingMethod ("colamd"),
+    gridM (0),
+    gridN (0),
+    symmetricOrdering (false),
+    cachedOrdering (false),
+    doubleFactored (false),
+    refinementIterations (0) {
+}
+
+void StokesSolver::setup (const std::string &precision,
+                          const double tolerance,
+                          const int maxRefinements) {
+  if (precision != "double" && precision != "mixed")
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("Unexpected Stokes solver precision: '" + precision + "'."));
+  if (tolerance < 0 || maxRefinements < 1)
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("Stokes refinement requires tolerance >= 0 and maxRefinements >= 1."));
+
+  this->precision      = precision;
+  this->tolerance      = tolerance;
+  this->maxRefinements = maxRefinements;
+}
+
+StokesSolver::~StokesSolver() {}
+
+void StokesSolver::setOrderingCache (const std::string &directory) {
+  cache.setDirectory (directory);
+}
+
+void StokesSolver::setOrdering (const std::string &method, const GridIndex M, const GridIndex N) {
+  if (method != "colamd" && method != "amd" && method != "metis" && method != "nestedDissection")
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("Unexpected Stokes ordering: '" + method + "'."));
+  #ifndef USE_METIS
+  if (method == "metis")
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("The metis Stokes ordering requires building with METIS_ENABLED."));
+  #endif
+
+  orderingMethod = method;
+  gridM          = M;
+  gridN          = N;
+}
+
+void StokesSolver::setBackend (const std::string &backend,
+                               const GridIndex pressureSize,
+                               const int maxIterations) {
+  if (backend != "eigen" && backend != "schur" && backend != "petsc")
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("Unexpected Stokes solver backend: '" + backend + "'."));
+  if (backend == "petsc" && !PetscStokesSolver::available())
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("The petsc Stokes solver backend requires building with PETSC_ENABLED."));
+  if (backend != "eigen" && precision != "double")
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("The " + backend + " Stokes solver backend only supports double precision."));
+
+  this->backend       = backend;
+  this->pressureSize  = pressureSize;
+  this->maxIterations = maxIterations;
+
+  schurSolver.reset();
+  petscSolver.reset();
+  if (backend == "schur") {
+    schurSolver.reset (new SchurStokesSolver());
+    schurSolver->setup (tolerance, maxIterations);
+  } else if (backend == "petsc") {
+    petscSolver.reset (new PetscStokesSolver());
+    petscSolver->setup (tolerance, maxIterations);
+  }
+}
+
+bool StokesSolver::sameSettings (const StokesSolver &other) const {
+  return precision      == other.precision &&
+         tolerance      == other.tolerance &&
+         maxRefinements == other.maxRefinements &&
+         orderingMethod == other.orderingMethod &&
+         backend        == other.backend &&
+         maxIterations  == other.maxIterations;
+}
+
+void StokesSolver::ownedRows (const GridIndex size, GridIndex &rowBegin, GridIndex &rowEnd) {
+  if (petscSolver) {
+    petscSolver->ownedRows (size, rowBegin, rowEnd);
+    return;
+  }
+
+  rowBegin = 0;
+  rowEnd   = size;
+}
+
+void StokesSolver::compute (const SparseMatrixXd &matrix) {
+  this->matrix   = &matrix;
+  doubleFactored = false;
+
+  if (schurSolver) {
+    schurSolver->compute (matrix, pressureSize);
+    return;
+  }
+  if (petscSolver) {
+    petscSolver->compute (matrix, pressureSize);
+    return;
+  }
+
+  computeOrdering();
+
+  if (precision == "double") {
+    factorDouble();
+    return;
+  }
+
+  SparseMatrix<float, ColMajor, GridIndex> singleMatrix = orderedMatrix().cast<float>();
+  singleSolver.analyzePattern (singleMatrix);
+  singleSolver.factorize (singleMatrix);
+
+  if (singleSolver.info() != Success) {
+    #ifdef DEBUG
+      cout << "<Single precision Stokes factorization failed; using double>" << endl;
+    #endif
+    factorDouble();
+  }
+
+  #ifdef DEBUG
+    cout << "<Factored the Stokes system with the " << orderingMethod << " ordering: nnz(L+U) = "
+         << factorNonZeros() << ">" << endl;
+  #endif
+}
+
+VectorXd StokesSolver::solve (const VectorXd &rhs) {
+  return solve (rhs, VectorXd());
+}
+
+void StokesSolver::solve (const MatrixXd &rhs, MatrixXd &solution) {
+  solve (rhs, MatrixXd(), solution);
+}
+
+VectorXd StokesSolver::solve (const VectorXd &rhs, const VectorXd &guess) {
+  MatrixXd solution;
+  solve (rhs, guess, solution);
+  return solution.col (0);
+}
+
+void StokesSolver::solve (const MatrixXd &rhs, const MatrixXd &guess, MatrixXd &solution) {
+  refinementIterations = 0;
+  if (schurSolver) {
+    schurSolver->solve (rhs, guess, solution);
+    return;
+  }
+  if (petscSolver) {
+    petscSolver->solve (rhs, guess, solution);
+    return;
+  }
+
+  if (doubleFactored) {
+    solution = ordering.inverse() * doubleSolver.solve (orderedRhs (rhs));
+    return;
+  }
+
+  solution = ordering.inverse() * singleSolver.solve (orderedRhs (rhs).cast<float>()).cast<double>();
+
+  // Every column is refined until its own relative residual is small enough.
+  const ArrayXd targetNorms = tolerance * rhs.colwise().norm().transpose().array();
+  MatrixXd residual         = rhs - (*matrix) * solution;
+  ArrayXd residualNorms     = residual.colwise().norm().transpose().array();
+
+  while ((residualNorms > targetNorms).any()) {
+    // Normalize the residuals so that they cannot underflow in single precision.
+    VectorXd scale = residualNorms.max (std::numeric_limits<double>::min()).matrix();
+    MatrixXf correction = singleSolver.solve
+             (orderedRhs (residual * scale.cwiseInverse().asDiagonal()).cast<float>());
+    MatrixXd scaledCorrection = correction.cast<double>() * scale.asDiagonal();
+    solution += MatrixXd (ordering.inverse() * scaledCorrection);
+    residual  = rhs - (*matrix) * solution;
+    ++refinementIterations;
+
+    ArrayXd previousNorms = residualNorms;
+    residualNorms = residual.colwise().norm().transpose().array();
+
+    if (!(residualNorms > targetNorms).any())
+      break;
+
+    if ((residualNorms > targetNorms && residualNorms > stallFactor * previousNorms).any() ||
+        refinementIterations == maxRefinements) {
+      #ifdef DEBUG
+        cout << "<Stokes refinement stalled at relative residual "
+             << (residualNorms / (targetNorms / tolerance)).maxCoeff() << "; using double>" << endl;
+      #endif
+      factorDouble();
+      solution = ordering.inverse() * doubleSolver.solve (orderedRhs (rhs));
+      return;
+    }
+  }
+
+  #ifdef DEBUG
+    cout << "<Stokes refinement converged in " << refinementIterations << " iterations>" << endl;
+  #endif
+}
+
+void StokesSolver::computeOrdering() {
+  symmetricOrdering = (orderingMethod != "colamd");
+
+  boost::uint64_t key = 0;
+  if (cache.enabled()) {
+    key = OrderingCache::key (*matrix, orderingMethod);
+    cachedOrdering = cache.load (key, matrix->cols(), ordering);
+  } else {
+    cachedOrdering = false;
+  }
+
+  #ifdef DEBUG
+    if (cachedOrdering)
+      cout << "<Loaded the Stokes ordering from the cache>" << endl;
+  #endif
+  if (cachedOrdering)
+    return;
+
+  if (orderingMethod == "colamd") {
+    COLAMDOrdering<GridIndex> colamd;
+    colamd (*matrix, ordering);
+  } else {
+    // The symmetric orderings map positions to unknowns.
+    if (orderingMethod == "amd") {
+      AMDOrdering<GridIndex> amd;
+      amd (*matrix, ordering);
+    #ifdef USE_METIS
+    } else if (orderingMethod == "metis") {
+      MetisOrdering<GridIndex> metis;
+      metis (*matrix, ordering);
+    #endif
+    } else {
+      NestedDissectionOrdering nestedDissection (gridM, gridN);
+      nestedDissection (*matrix, ordering);
+    }
+    ordering = ordering.inverse();
+  }
+
+  cache.store (key, ordering);
+}
+
+void StokesSolver::factorDouble() {
+  SparseMatrixXd permutedMatrix = orderedMatrix();
+  doubleSolver.analyzePattern (permutedMatrix);
+  doubleSolver.factorize (permutedMatrix);
+  doubleFactored = true;
+}
+
+SparseMatrixXd StokesSolver::orderedMatrix() {
+  if (symmetricOrdering)
+    return ordering * (*matrix) * ordering.inverse();
+  else
+    return (*matrix) * ordering.inverse();
+}
+
+MatrixXd StokesSolver::orderedRhs (const MatrixXd &rhs) {
+  if (symmetricOrdering)
+    return ordering * rhs;
+  else
+    return rhs;
+}
+
+const std::string &StokesSolver::getPrecision() {
+  return precision;
+}
+
+const std::string &StokesSolver::getBackend() {
+  return backend;
+}
+
+int StokesSolver::getRefinementIterations() {
+  return refinementIterations;
+}
+
+int StokesSolver::getIterations() {
+  if (schurSolver)
+    return schurSolver->getIterations();
+  if (petscSolver)
+    return petscSolver->getIterations();
+  return 0;
+}
+
+bool StokesSolver::usedFallback() {
+  return doubleFactored && precision == "mixed";
+}
+
+bool StokesSolver::orderingFromCache() {
+  return cachedOrdering;
+}
+
+long StokesSolver::factorNonZeros() {
+  if (schurSolver || petscSolver)
+    return 0;
+  if (doubleFactored)
+    return doubleSolver.nnzL() + doubleSolver.nnzU();
+  else
+    return singleSolver.nnzL() + singleSolver.nnzU();
+}
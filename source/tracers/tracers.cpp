@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "debug/exception.h"
+#include "geometry/dataWindow.h"
+#include "geometry/interpolation.h"
+#include "tracers/tracers.h"
+
+using namespace std;
+
+// Reorder the n values of data so that data[k] becomes data[order[k]].
+template<typename T>
+static void permute (T * data, const GridIndex * order, double * scratch, const GridIndex n) {
+  #ifdef USE_OPENMP
+  #pragma omp parallel for schedule(static)
+  #endif
+  for (GridIndex k = 0; k < n; ++k)
+    scratch[k] = data[order[k]];
+  copy (scratch, scratch + n, data);
+}
+
+TracerStructure::TracerStructure() :
+    M (0),
+    N (0),
+    K (0),
+    hx (0),
+    hy (0),
+    tracerCount (0),
+    sortInterval (1),
+    binsSinceSort (0) {}
+
+void TracerStructure::seed (const GridIndex M, const GridIndex N, const int K,
+                            const double hx,
+                            const double hy,
+                            const int tracersPerSide,
+                            const int sortInterval,
+                            const Real * temperature,
+                            const Real * composition) {
+  if (tracersPerSide < 1 || sortInterval < 1)
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("Tracers require tracersPerSide >= 1 and sortInterval >= 1."));
+
+  this->M = M;
+  this->N = N;
+  this->K = K;
+  this->hx = hx;
+  this->hy = hy;
+  this->sortInterval = sortInterval;
+  binsSinceSort = 0;
+
+  const int tracersPerCell = tracersPerSide * tracersPerSide;
+  tracerCount = M * N * tracersPerCell;
+
+  x.resize (tracerCount);
+  y.resize (tracerCount);
+  this->temperature.resize (tracerCount);
+  this->composition.resize (tracerCount * K);
+  cell.resize (tracerCount);
+  cellStart.resize (M * N + 1);
+  binnedOrder.resize (tracerCount);
+  scratch.resize (tracerCount);
+
+  // Tracers are seeded in cell order, so the arrays start out sorted.
+  for (GridIndex c = 0; c < M * N; ++c) {
+    const GridIndex i = c / N, j = c % N;
+    for (int a = 0; a < tracersPerSide; ++a)
+      for (int b = 0; b < tracersPerSide; ++b) {
+        const GridIndex p = c * tracersPerCell + a * tracersPerSide + b;
+        x[p] = (j + (b + 0.5) / tracersPerSide) * hx;
+        y[p] = (i + (a + 0.5) / tracersPerSide) * hy;
+        this->temperature[p] = temperature[c];
+        for (int f = 0; f < K; ++f)
+          this->composition[f * tracerCount + p] = composition[c * K + f];
+      }
+  }
+
+  projectedTemperature.assign (temperature, temperature + M * N);
+
+  bin();
+}
+
+void TracerStructure::advect (const std::string &integrator,
+                              const double deltaT,
+                              double * uVelocity,
+                              double * vVelocity,
+                              double * uVelocityBoundary,
+                              double * vVelocityBoundary) {
+  DataWindow<double> uVelocityWindow (uVelocity, N - 1, M);
+  DataWindow<double> vVelocityWindow (vVelocity, N, M - 1);
+  DataWindow<double> uVelocityBoundaryWindow (uVelocityBoundary, 2, M);
+  DataWindow<double> vVelocityBoundaryWindow (vVelocityBoundary, N, 2);
+
+  const bool fourthOrder = (integrator == "rungeKutta4");
+  if (!fourthOrder && integrator != "rungeKutta2")
+    THROW_WITH_TRACE(InvalidArgument() <<
+            errmsg_info("Unexpected tracer integrator: '" + integrator + "'."));
+
+  const double xExtent = N * hx;
+  const double yExtent = M * hy;
+
+  #ifdef USE_OPENMP
+  #pragma omp parallel for schedule(static)
+  #endif
+  for (GridIndex p = 0; p < tracerCount; ++p) {
+    const double x0 = x[p], y0 = y[p];
+
+    double u1 = interpolateUVelocity (uVelocityWindow, uVelocityBoundaryWindow, M, N, hx, hy, x0, y0);
+    double v1 = interpolateVVelocity (vVelocityWindow, vVelocityBoundaryWindow, M, N, hx, hy, x0, y0);
+    double u2 = interpolateUVelocity (uVelocityWindow, uVelocityBoundaryWindow, M, N, hx, hy,
+                                      x0 + deltaT / 2 * u1, y0 + deltaT / 2 * v1);
+    double v2 = interpolateVVelocity (vVelocityWindow, vVelocityBoundaryWindow, M, N, hx, hy,
+                                      x0 + deltaT / 2 * u1, y0 + deltaT / 2 * v1);
+
+    double uStep = u2, vStep = v2;
+    if (fourthOrder) {
+      double u3 = interpolateUVelocity (uVelocityWindow, uVelocityBoundaryWindow, M, N, hx, hy,
+                                        x0 + deltaT / 2 * u2, y0 + deltaT / 2 * v2);
+      double v3 = interpolateVVelocity (vVelocityWindow, vVelocityBoundaryWindow, M, N, hx, hy,
+                                        x0 + deltaT / 2 * u2, y0 + deltaT / 2 * v2);
+      double u4 = interpolateUVelocity (uVelocityWindow, uVelocityBoundaryWindow, M, N, hx, hy,
+                                        x0 + deltaT * u3, y0 + deltaT * v3);
+      double v4 = interpolateVVelocity (vVelocityWindow, vVelocityBoundaryWindow, M, N, hx, hy,
+                                        x0 + deltaT * u3, y0 + deltaT * v3);
+      uStep = (u1 + 2 * u2 + 2 * u3 + u4) / 6;
+      vStep = (v1 + 2 * v2 + 2 * v3 + v4) / 6;
+    }
+
+    x[p] = max (0.0, min (xExtent, x0 + deltaT * uStep));
+    y[p] = max (0.0, min (yExtent, y0 + deltaT * vStep));
+  }
+}
+
+void TracerStructure::bin() {
+  // Counting sort of the tracer indices by cell.
+  fill (cellStart.begin(), cellStart.end(), 0);
+  for (GridIndex p = 0; p < tracerCount; ++p) {
+    cell[p] = cellIndex (x[p], y[p]);
+    ++cellStart[cell[p] + 1];
+  }
+  for (GridIndex c = 0; c < M * N; ++c)
+    cellStart[c + 1] += cellStart[c];
+
+  vector<GridIndex> nextSlot (cellStart.begin(), cellStart.end() - 1);
+  for (GridIndex p = 0; p < tracerCount; ++p)
+    binnedOrder[nextSlot[cell[p]]++] = p;
+
+  if (++binsSinceSort < sortInterval)
+    return;
+  binsSinceSort = 0;
+
+  // Permute every tracer array into cell order.
+  permute (x.data(), binnedOrder.data(), scratch.data(), tracerCount);
+  permute (y.data(), binnedOrder.data(), scratch.data(), tracerCount);
+  permute (temperature.data(), binnedOrder.data(), scratch.data(), tracerCount);
+  for (int f = 0; f < K; ++f)
+    permute (composition.data() + f * tracerCount, binnedOrder.data(), scratch.data(), tracerCount);
+
+  for (GridIndex c = 0; c < M * N; ++c)
+    for (GridIndex k = cellStart[c]; k < cellStart[c + 1]; ++k) {
+      cell[k] = c;
+      binnedOrder[k] = k;
+    }
+}
+
+void TracerStructure::applyGridChange (const Real * temperature) {
+  #ifdef USE_OPENMP
+  #pragma omp parallel for schedule(static)
+  #endif
+  for (GridIndex p = 0; p < tracerCount; ++p)
+    this->temperature[p] += temperature[cell[p]] - projectedTemperature[cell[p]];
+}
+
+void TracerStructure::project (Real * temperature, Real * composition) {
+  #ifdef USE_OPENMP
+  #pragma omp parallel for schedule(static)
+  #endif
+  for (GridIndex c = 0; c < M * N; ++c) {
+    const GridIndex begin = cellStart[c], end = cellStart[c + 1];
+    if (begin == end)
+      continue;
+
+    double sum = 0;
+    for (GridIndex k = begin; k < end; ++k)
+      sum += this->temperature[binnedOrder[k]];
+    temperature[c] = sum / (end - begin);
+
+    for (int f = 0; f < K; ++f) {
+      const Real * field = this->composition.data() + f * tracerCount;
+      sum = 0;
+      for (GridIndex k = begin; k < end; ++k)
+        sum += field[binnedOrder[k]];
+      composition[c * K + f] = sum / (end - begin);
+    }
+  }
+
+  projectedTemperature.assign (temperature, temperature + M * N);
+}
+
+GridIndex TracerStructure::cellIndex (const double x, const double y) {
+  const GridIndex j = max<GridIndex> (0, min<GridIndex> (N - 1, GridIndex (x / hx)));
+  const GridIndex i = max<GridIndex> (0, min<GridIndex> (M - 1, GridIndex (y / hy)));
+  return i * N + j;
+}
+
+GridIndex TracerStructure::getTracerCount() {
+  return tracerCount;
+}
+
+const double * TracerStructure::getXData() {
+  return x.data();
+}
+
+const double * TracerStructure::getYData() {
+  return y.data();
+}
+
+const Real * TracerStructure::getTemperatureData() {
+  return temperature.data();
+}
+
+const Real * TracerStructure::getCompositionData (const int f) {
+  return composition.data() + f * tracerCount;
+}
+
+const GridIndex * TracerStructure::getCellStartData() {
+  return cellStart.data();
+}
@@ -0,0 +1,35 @@
+#include <vector>
+#include <cstdlib>
+
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+
+#include "solvers/adiDiffusionSolver.h"
+
+TEST(ADIDiffusionSolverTest, batched_thomas_should_solve_every_line) {
+  // Three interleaved systems of length 6 with insulated ends.
+  const int n = 6, lines = 3;
+  const double mu = 0.7;
+
+  Eigen::VectorXd diagonal = Eigen::VectorXd::Constant(n, 1 + 2 * mu);
+  diagonal(0) -= mu;
+  diagonal(n - 1) -= mu;
+
+  std::vector<double> rhs(n * lines), solution(n * lines);
+  std::srand(5);
+  for (int k = 0; k < n * lines; ++k)
+    rhs[k] = solution[k] = double(std::rand()) / RAND_MAX;
+
+  Eigen::VectorXd inverseDiagonal, upper;
+  ADIDiffusionSolver::factor(mu, diagonal, inverseDiagonal, upper);
+  ADIDiffusionSolver::solveLines(mu, inverseDiagonal, upper, solution.data(), n, lines);
+
+  for (int l = 0; l < lines; ++l)
+    for (int k = 0; k < n; ++k) {
+      double value = diagonal(k) * solution[k * lines + l];
+      if (k > 0)     value -= mu * solution[(k - 1) * lines + l];
+      if (k < n - 1) value -= mu * solution[(k + 1) * lines + l];
+
+      EXPECT_NEAR(rhs[k * lines + l], value, 1E-12);
+    }
+}
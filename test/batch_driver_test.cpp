@@ -0,0 +1,60 @@
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+#include "debug/exception.h"
+#include "driver/batchDriver.h"
+
+TEST(BatchDriverTest, should_expand_value_lists) {
+  std::vector<std::string> values = BatchDriver::expandValues("4,8,16");
+
+  ASSERT_EQ(3u, values.size());
+  EXPECT_EQ("4", values[0]);
+  EXPECT_EQ("16", values[2]);
+}
+
+TEST(BatchDriverTest, should_expand_value_ranges) {
+  std::vector<std::string> values = BatchDriver::expandValues("0.1:0.5:0.1");
+
+  ASSERT_EQ(5u, values.size());
+  EXPECT_EQ("0.1", values[0]);
+  EXPECT_EQ("0.3", values[2]);
+  EXPECT_EQ("0.5", values[4]);
+}
+
+TEST(BatchDriverTest, cant_expand_empty_ranges) {
+  EXPECT_THROW(BatchDriver::expandValues("4:1:1"), InvalidArgument);
+  EXPECT_THROW(BatchDriver::expandValues("1:4:0"), InvalidArgument);
+}
+
+TEST(BatchDriverTest, should_parse_manifests) {
+  std::stringstream manifest;
+  manifest <<
+      "# A comment" << std::endl <<
+      "paramFiles/tauBenchmark/tauBenchmark01" << std::endl <<
+      std::endl <<
+      "sweep exampleParameters geometryParams/M=4,8 geometryParams/N=8,16" << std::endl;
+
+  BatchDriver batch(1);
+  batch.parse(manifest);
+
+  const std::vector<BatchDriver::BatchRun> &runs = batch.getRuns();
+  ASSERT_EQ(3u, runs.size());
+
+  EXPECT_EQ("paramFiles/tauBenchmark/tauBenchmark01", runs[0].paramFile);
+  EXPECT_TRUE(runs[0].overrides.empty());
+
+  EXPECT_EQ("exampleParameters", runs[2].paramFile);
+  ASSERT_EQ(2u, runs[2].overrides.size());
+  EXPECT_EQ("geometryParams/N", runs[2].overrides[1].first);
+  EXPECT_EQ("16", runs[2].overrides[1].second);
+  EXPECT_EQ("M-8_N-16", runs[2].label);
+}
+
+TEST(BatchDriverTest, cant_parse_mismatched_sweeps) {
+  std::stringstream manifest;
+  manifest << "sweep exampleParameters geometryParams/M=4,8 geometryParams/N=8" << std::endl;
+
+  BatchDriver batch(1);
+  EXPECT_THROW(batch.parse(manifest), InvalidArgument);
+}
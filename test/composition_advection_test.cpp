@@ -0,0 +1,129 @@
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include <gtest/gtest.h>
+
+#include "smallProblem.h"
+
+const int size = 32;
+// Round-off allowed in a few dozen updates of values of order one.
+const double tolerance = 100 * std::numeric_limits<Real>::epsilon();
+
+// A step of field 0 from 1 to 0 at x = 0.25, and field 1 half of it.
+static void setStep(SmallProblem &small) {
+  Real * composition = small.geometry.getCompositionData();
+  for (int i = 0; i < size; ++i)
+    for (int j = 0; j < size; ++j) {
+      composition[(i * size + j) * 2]     = ((j + 0.5) / size < 0.25) ? 1.0 : 0.0;
+      composition[(i * size + j) * 2 + 1] = 0.5 * composition[(i * size + j) * 2];
+    }
+}
+
+TEST(CompositionAdvectionTest, upwind_fields_should_follow_the_temperature) {
+  SmallProblem small({{"advectionMethod", "upwindMethod"},
+                      {"diffusionMethod", "none"}}, size, 2);
+  small.setUniformVelocity(1.0);
+
+  // Both fields start as the temperature; the upwind sweep moves them with
+  // the same fluxes as upwindMethod() moves the temperature.
+  Real * temperature = small.geometry.getTemperatureData();
+  Real * composition = small.geometry.getCompositionData();
+  for (int c = 0; c < size * size; ++c)
+    composition[2 * c] = composition[2 * c + 1] = temperature[c];
+
+  for (int step = 0; step < 4; ++step) {
+    small.problem.recalculateTimestep();
+    small.problem.solveAdvectionDiffusion();
+    small.problem.advanceTimestep();
+  }
+
+  temperature = small.geometry.getTemperatureData();
+  composition = small.geometry.getCompositionData();
+  for (int c = 0; c < size * size; ++c) {
+    EXPECT_NEAR(temperature[c], composition[2 * c], tolerance);
+    EXPECT_EQ(composition[2 * c], composition[2 * c + 1]);
+  }
+}
+
+TEST(CompositionAdvectionTest, fromm_fields_should_be_sharper_than_upwind) {
+  SmallProblem upwind({{"advectionMethod", "upwindMethod"},
+                       {"diffusionMethod", "none"}}, size, 2);
+  SmallProblem fromm({{"advectionMethod", "upwindMethod"},
+                      {"diffusionMethod", "none"},
+                      {"advectionParams/fluxLimiter", "minmod"}}, size, 2);
+  upwind.setUniformVelocity(1.0);
+  fromm.setUniformVelocity(1.0);
+  setStep(upwind);
+  setStep(fromm);
+
+  // Move the step by 8 cells at a Courant number of 0.5. Nothing flows in
+  // through the left wall, so the fields leave an empty band behind them.
+  upwind.problem.recalculateTimestep();
+  fromm.problem.recalculateTimestep();
+  ASSERT_DOUBLE_EQ(0.5 / size, fromm.problem.getDeltaT());
+  for (int step = 0; step < 16; ++step) {
+    upwind.problem.upwindComposition();
+    fromm.problem.frommComposition(fromm.geometry.getUVelocityData(), fromm.geometry.getVVelocityData());
+  }
+
+  double upwindError = 0, frommError = 0;
+  const Real * upwindComposition = upwind.geometry.getCompositionData();
+  const Real * frommComposition  = fromm.geometry.getCompositionData();
+  for (int i = 0; i < size; ++i)
+    for (int j = 0; j < size; ++j) {
+      const double x = (j + 0.5) / size;
+      const double exact = (x > 0.25 && x < 0.5) ? 1.0 : 0.0;
+      const int c = i * size + j;
+      upwindError += std::abs(upwindComposition[2 * c] - exact);
+      frommError  += std::abs(frommComposition[2 * c] - exact);
+
+      // The limited fluxes make no new extrema, and are linear in the field.
+      EXPECT_GE(frommComposition[2 * c], -tolerance);
+      EXPECT_LE(frommComposition[2 * c], 1 + tolerance);
+      EXPECT_NEAR(0.5 * frommComposition[2 * c], frommComposition[2 * c + 1], tolerance);
+    }
+
+  // About two thirds of the upwind error, the minmod limiter clipping the
+  // second order fluxes at the edges of the band.
+  EXPECT_LT(frommError, 0.7 * upwindError);
+}
+
+TEST(CompositionAdvectionTest, fromm_fields_should_pile_up_at_the_walls_of_a_corner_flow) {
+  SmallProblem small({{"advectionMethod", "upwindMethod"},
+                      {"diffusionMethod", "none"},
+                      {"advectionParams/fluxLimiter", "minmod"}}, size, 2);
+  // Flow towards the bottom left corner, through the wall faces of the
+  // first row and column.
+  small.setUniformVelocity(-1.0);
+  std::fill(small.geometry.getVVelocityData(), small.geometry.getVVelocityData() + (size - 1) * size, -1.0);
+
+  Real * composition = small.geometry.getCompositionData();
+  for (int i = 0; i < size; ++i)
+    for (int j = 0; j < size; ++j) {
+      composition[(i * size + j) * 2]     = 1.0 + 0.5 * std::sin(0.7 * i + 1.3 * j);
+      composition[(i * size + j) * 2 + 1] = 0.5 * composition[(i * size + j) * 2];
+    }
+
+  double startTotal = 0;
+  for (int c = 0; c < size * size; ++c)
+    startTotal += composition[2 * c];
+
+  small.problem.recalculateTimestep();
+  for (int step = 0; step < 16; ++step)
+    small.problem.frommComposition(small.geometry.getUVelocityData(), small.geometry.getVVelocityData());
+
+  // Nothing leaves through the walls: the fields pile up against them,
+  // finite and positive, and linear in the field.
+  composition = small.geometry.getCompositionData();
+  double total = 0;
+  for (int c = 0; c < size * size; ++c) {
+    ASSERT_TRUE(std::isfinite(composition[2 * c]));
+    EXPECT_GT(composition[2 * c], 0.0);
+    EXPECT_NEAR(0.5 * composition[2 * c], composition[2 * c + 1], tolerance);
+    total += composition[2 * c];
+  }
+  EXPECT_NEAR(startTotal, total, size * size * tolerance);
+  EXPECT_GT(composition[0], 1.5);
+}
@@ -0,0 +1,71 @@
+#include <vector>
+#include <cmath>
+#include <fstream>
+
+#include <gtest/gtest.h>
+#include <boost/filesystem.hpp>
+
+#include "debug/exception.h"
+#include "driver/convergenceStudy.h"
+
+TEST(ConvergenceStudyTest, error_norms_should_be_area_weighted) {
+  double values[4]    = {1, 2, 3, 4};
+  double reference[4] = {1, 1, 1, 1};
+
+  ConvergenceStudy::ErrorNorms norms =
+      ConvergenceStudy::errorNorms(values, reference, 4, 0.25);
+
+  EXPECT_DOUBLE_EQ(1.5, norms.l1);
+  EXPECT_DOUBLE_EQ(std::sqrt(3.5), norms.l2);
+  EXPECT_DOUBLE_EQ(3, norms.lInf);
+}
+
+TEST(ConvergenceStudyTest, restriction_should_preserve_linear_fields) {
+  // Sample f(x, y) = x + 2y at the cell centers and edges of a 4x6 fine grid
+  // with unit spacing and restrict it onto the 2x3 coarse grid.
+  const int M = 2, N = 3;
+  std::vector<double> fineCell(4 * M * N), fineU(2 * M * (2 * N - 1)), fineV((2 * M - 1) * 2 * N);
+  for (int i = 0; i < 2 * M; ++i)
+    for (int j = 0; j < 2 * N; ++j) {
+      fineCell[i * 2 * N + j] = (j + 0.5) + 2 * (i + 0.5);
+      if (j < 2 * N - 1)
+        fineU[i * (2 * N - 1) + j] = (j + 1) + 2 * (i + 0.5);
+      if (i < 2 * M - 1)
+        fineV[i * 2 * N + j] = (j + 0.5) + 2 * (i + 1);
+    }
+
+  std::vector<double> coarseCell(M * N), coarseU(M * (N - 1)), coarseV((M - 1) * N);
+  ConvergenceStudy::restrictCellField(fineCell.data(), coarseCell.data(), M, N);
+  ConvergenceStudy::restrictUField(fineU.data(), coarseU.data(), M, N);
+  ConvergenceStudy::restrictVField(fineV.data(), coarseV.data(), M, N);
+
+  // Coarse spacing is 2
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N; ++j) {
+      EXPECT_DOUBLE_EQ(2 * (j + 0.5) + 4 * (i + 0.5), coarseCell[i * N + j]);
+      if (j < N - 1) {
+        EXPECT_DOUBLE_EQ(2 * (j + 1) + 4 * (i + 0.5), coarseU[i * (N - 1) + j]);
+      }
+      if (i < M - 1) {
+        EXPECT_DOUBLE_EQ(2 * (j + 0.5) + 4 * (i + 1), coarseV[i * N + j]);
+      }
+    }
+}
+
+TEST(ConvergenceStudyTest, cant_study_without_common_end_time) {
+  // The levels take different time steps, so a step count alone would
+  // compare them at different times.
+  const boost::filesystem::path paramFile =
+      boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  {
+    std::ofstream params(paramFile.string());
+    params << "enter problemParams" << std::endl
+           << "  set endStep=10" << std::endl
+           << "leave" << std::endl
+           << "enter outputParams" << std::endl
+           << "leave" << std::endl;
+  }
+
+  EXPECT_THROW(ConvergenceStudy study(paramFile.string()), InvalidArgument);
+  boost::filesystem::remove(paramFile);
+}
@@ -0,0 +1,75 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "geometry/decomposition.h"
+
+TEST(DecompositionTest, block_ranges_should_tile_the_grid) {
+  const int n = 37;
+  for (int blocks = 1; blocks <= 8; ++blocks) {
+    GridIndex previousEnd = 0;
+    for (int block = 0; block < blocks; ++block) {
+      GridIndex begin, end;
+      Decomposition::blockRange(n, blocks, block, begin, end);
+
+      EXPECT_EQ(previousEnd, begin);
+      // Blocks differ in size by at most one row or column.
+      EXPECT_GE(end - begin, n / blocks);
+      EXPECT_LE(end - begin, n / blocks + 1);
+      previousEnd = end;
+    }
+    EXPECT_EQ(n, previousEnd);
+  }
+}
+
+TEST(DecompositionTest, single_process_should_own_the_whole_grid) {
+  const int M = 6, N = 5;
+  Decomposition decomposition;
+  decomposition.setup(M, N);
+
+  EXPECT_FALSE(decomposition.isDistributed());
+  EXPECT_TRUE(Decomposition::isRootProcess());
+  EXPECT_EQ(0, decomposition.getRowBegin());
+  EXPECT_EQ(M, decomposition.getRowEnd());
+  EXPECT_EQ(0, decomposition.getColBegin());
+  EXPECT_EQ(N, decomposition.getColEnd());
+
+  // Without a halo the block storage is laid out like the global arrays.
+  EXPECT_EQ(M * N, decomposition.getCellCount());
+  EXPECT_EQ(M * (N - 1), decomposition.getUFaceCount());
+  EXPECT_EQ((M - 1) * N, decomposition.getVFaceCount());
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N; ++j)
+      EXPECT_EQ(i * N + j, decomposition.cell(i, j));
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N - 1; ++j)
+      EXPECT_EQ(i * (N - 1) + j, decomposition.uFace(i, j));
+  for (int i = 0; i < M - 1; ++i)
+    for (int j = 0; j < N; ++j)
+      EXPECT_EQ(i * N + j, decomposition.vFace(i, j));
+
+  // With no neighbors no cell reads a halo, and communication only copies.
+  std::vector<Real> block(M * N), field(M * N, -1);
+  for (int k = 0; k < M * N; ++k)
+    block[k] = k;
+
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N; ++j)
+      EXPECT_FALSE(decomposition.onBlockEdge(i, j));
+
+  decomposition.beginHaloExchange(block.data());
+  decomposition.endHaloExchange(block.data());
+  decomposition.gather(block.data(), field.data());
+  for (int k = 0; k < M * N; ++k)
+    EXPECT_EQ(Real(k), field[k]);
+
+  std::vector<double> u(M * (N - 1), 1.5), v((M - 1) * N, -2.5), blockU(u.size()), blockV(v.size());
+  decomposition.scatterFaces(u.data(), v.data(), blockU.data(), blockV.data());
+  EXPECT_EQ(u, blockU);
+  EXPECT_EQ(v, blockV);
+
+  int value = 3;
+  decomposition.broadcast(value);
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(2.5, decomposition.maxAll(2.5));
+}
@@ -10,7 +10,7 @@ TEST(DenseForms, makeLaplacianXBlock) {
   }
 
   Eigen::MatrixXd actual_matrix = Eigen::MatrixXd::Zero(6, 6);
-  DenseForms::makeLaplacianXBlock(actual_matrix, 3, 3, 1, viscosity_data);
+  DenseForms::makeLaplacianXBlock(actual_matrix, 3, 3, 1, 1, viscosity_data);
 
   // clean up after the viscosity data
   delete[] viscosity_data;
@@ -26,6 +26,29 @@ TEST(DenseForms, makeLaplacianXBlock) {
   ASSERT_EQ(expected_matrix, actual_matrix);
 }
 
+TEST(DenseForms, makeLaplacianXBlockOnRectangularCells) {
+  double *viscosity_data = new double[16];
+  for (int i = 0; i < 16; ++i) {
+    viscosity_data[i] = 1.0;
+  }
+
+  // Cells twice as tall as they are wide weigh the vertical neighbors by 1/4
+  Eigen::MatrixXd actual_matrix = Eigen::MatrixXd::Zero(6, 6);
+  DenseForms::makeLaplacianXBlock(actual_matrix, 3, 3, 1, 2, viscosity_data);
+
+  delete[] viscosity_data;
+
+  Eigen::MatrixXd expected_matrix(6, 6);
+  expected_matrix << 2.75,-1,   -0.25, 0,     0,     0,
+                    -1,    2.75, 0,   -0.25,  0,     0,
+                    -0.25, 0,    2.5, -1,    -0.25,  0,
+                     0,   -0.25,-1,    2.5,   0,    -0.25,
+                     0,    0,   -0.25, 0,     2.75, -1,
+                     0,    0,    0,   -0.25, -1,     2.75;
+
+  ASSERT_EQ(expected_matrix, actual_matrix);
+}
+
 TEST(DenseForms, makeLaplacianYBlock) {
   // instntiate test viscosity data
   double *viscosity_data = new double[16];
@@ -34,7 +57,7 @@ TEST(DenseForms, makeLaplacianYBlock) {
   }
 
   Eigen::MatrixXd actual_matrix = Eigen::MatrixXd::Zero(6, 6);
-  DenseForms::makeLaplacianYBlock(actual_matrix, 3, 3, 1, viscosity_data);
+  DenseForms::makeLaplacianYBlock(actual_matrix, 3, 3, 1, 1, viscosity_data);
 
   // clean up after the viscosity data
   delete[] viscosity_data;
@@ -0,0 +1,125 @@
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include <gtest/gtest.h>
+#include <boost/math/constants/constants.hpp>
+
+#include "debug/exception.h"
+#include "solvers/multirateUpwind.h"
+
+// Round-off of one update of values of order one.
+const double epsilon = std::numeric_limits<Real>::epsilon();
+
+// Discretely divergence-free staggered velocity of a slow rotation with a
+// fast jet along the middle row, from the stream function
+// sin(pi x) sin(pi y) (1 + 30 exp(-((x - 1/2)^2 + (y - 1/2)^2) / 0.01)).
+static void jetFlow(const int M, const int N, std::vector<double> &u, std::vector<double> &v) {
+  const double pi = boost::math::constants::pi<double>();
+  const double hx = 1.0 / N, hy = 1.0 / M;
+  auto psi = [&](const int i, const int j) {
+    const double x = j * hx, y = i * hy;
+    return sin(pi * x) * sin(pi * y) *
+           (1 + 30 * exp(-((x - 0.5) * (x - 0.5) + (y - 0.5) * (y - 0.5)) / 0.01));
+  };
+
+  u.assign((N - 1) * M, 0.0);
+  v.assign(N * (M - 1), 0.0);
+  for (int i = 0; i < M; ++i)
+    for (int j = 1; j < N; ++j)
+      u[i * (N - 1) + j - 1] = (psi(i + 1, j) - psi(i, j)) / hy;
+  for (int i = 1; i < M; ++i)
+    for (int j = 0; j < N; ++j)
+      v[(i - 1) * N + j] = -(psi(i, j + 1) - psi(i, j)) / hx;
+}
+
+// The largest stable global upwind step for the CFL number 'cfl'.
+static double globalStep(const int M, const int N, const std::vector<double> &u,
+                         const std::vector<double> &v, const double cfl) {
+  double maxCourantSum = 0;
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N; ++j) {
+      const double left   = (j > 0)     ? std::abs(u[i * (N - 1) + j - 1]) : 0;
+      const double right  = (j < N - 1) ? std::abs(u[i * (N - 1) + j])     : 0;
+      const double bottom = (i > 0)     ? std::abs(v[(i - 1) * N + j])     : 0;
+      const double top    = (i < M - 1) ? std::abs(v[i * N + j])           : 0;
+      maxCourantSum = std::max(maxCourantSum, std::max(left, right) * N + std::max(bottom, top) * M);
+    }
+  return cfl / maxCourantSum;
+}
+
+TEST(MultirateUpwindTest, uniform_levels_should_match_global_substeps) {
+  // With every cell on the finest level, one multirate step is 2^(levels - 1)
+  // upwind steps.
+  const int M = 8, N = 10;
+  std::vector<double> dx(N, 1.0 / N), dy(M, 1.0 / M);
+  std::vector<double> u((N - 1) * M, 0.3), v(N * (M - 1), -0.2);
+
+  std::vector<Real> temperature(M * N), reference;
+  for (int c = 0; c < M * N; ++c)
+    temperature[c] = (c * 7) % 5;
+  reference = temperature;
+
+  MultirateUpwind single, multirate;
+  single.setup(M, N, dx.data(), dy.data(), 1);
+  multirate.setup(M, N, dx.data(), dy.data(), 3);
+
+  const double deltaT = 4 * globalStep(M, N, u, v, 0.5);
+  for (int step = 0; step < 4; ++step)
+    single.step(deltaT / 4, 0.5, u.data(), v.data(), reference.data(), NULL, 0);
+  multirate.step(deltaT, 0.5, u.data(), v.data(), temperature.data(), NULL, 0);
+
+  for (int c = 0; c < M * N; ++c) {
+    EXPECT_EQ(2, multirate.getLevelData()[c]);
+    EXPECT_NEAR(reference[c], temperature[c], 100 * epsilon);
+  }
+}
+
+TEST(MultirateUpwindTest, local_steps_should_conserve_and_save_updates) {
+  const int M = 48, N = 48, K = 2, levels = 5;
+  std::vector<double> dx(N, 1.0 / N), dy(M, 1.0 / M), u, v;
+  jetFlow(M, N, u, v);
+
+  std::vector<Real> temperature(M * N), composition(M * N * K);
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N; ++j) {
+      temperature[i * N + j] = (j < N / 3) ? 1.0 : 0.0;
+      composition[(i * N + j) * K]     = (i < M / 4) ? 1.0 : 0.0;
+      composition[(i * N + j) * K + 1] = 2.0;
+    }
+
+  double heat = 0;
+  for (int c = 0; c < M * N; ++c)
+    heat += temperature[c];
+
+  MultirateUpwind multirate;
+  multirate.setup(M, N, dx.data(), dy.data(), levels);
+  const double deltaT = (1 << (levels - 1)) * globalStep(M, N, u, v, 0.5);
+  for (int step = 0; step < 10; ++step) {
+    multirate.step(deltaT, 0.5, u.data(), v.data(), temperature.data(), composition.data(), K);
+
+    // The jet is on the finest level, and most cells take far fewer updates
+    // than the M N 2^(levels - 1) of a global step.
+    EXPECT_EQ(levels - 1, *std::max_element(multirate.getLevelData(), multirate.getLevelData() + M * N));
+    EXPECT_LT(multirate.getCellUpdates(), M * N * (1 << (levels - 1)) / 4);
+  }
+
+  double newHeat = 0;
+  for (int c = 0; c < M * N; ++c) {
+    newHeat += temperature[c];
+    EXPECT_GE(temperature[c], -100 * epsilon);
+    EXPECT_LE(temperature[c], 1 + 100 * epsilon);
+    EXPECT_NEAR(2.0, composition[c * K + 1], 100 * epsilon);
+  }
+  // Each of the at most 2^(levels - 1) substeps of a step may round every
+  // cell's heat.
+  EXPECT_NEAR(heat, newHeat, 10 * (1 << (levels - 1)) * M * N * epsilon);
+}
+
+TEST(MultirateUpwindTest, invalid_levels_should_throw) {
+  std::vector<double> dx(4, 0.25), dy(4, 0.25);
+  MultirateUpwind multirate;
+  EXPECT_THROW(multirate.setup(4, 4, dx.data(), dy.data(), 0), InvalidArgument);
+  EXPECT_THROW(multirate.setup(4, 4, dx.data(), dy.data(), 17), InvalidArgument);
+}
@@ -0,0 +1,93 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "smallProblem.h"
+
+// Scale the temperature, and so (but for the hydrostatic part) the buoyancy
+// driven velocity, by 'factor'.
+static void scaleTemperature(SmallProblem &small, const double factor) {
+  Real * temperature = small.geometry.getTemperatureData();
+  for (int c = 0; c < small.geometry.getM() * small.geometry.getN(); ++c)
+    temperature[c] *= factor;
+}
+
+TEST(OperatorSplittingTest, fixed_subcycling_should_reuse_the_velocity) {
+  SmallProblem small({{"subcyclingParams/mode", "fixed"},
+                      {"subcyclingParams/substeps", "3"}});
+
+  EXPECT_TRUE(small.problem.stokesSolveRequired());
+  for (int solve = 0; solve < 2; ++solve) {
+    small.problem.updateForcingTerms();
+    small.problem.solveStokes();
+    for (int step = 0; step < 3; ++step) {
+      EXPECT_FALSE(small.problem.stokesSolveRequired());
+      small.problem.advanceTimestep();
+    }
+    EXPECT_TRUE(small.problem.stokesSolveRequired());
+    EXPECT_EQ(3, small.problem.getStokesSubsteps());
+  }
+}
+
+TEST(OperatorSplittingTest, adaptive_subcycling_should_follow_the_velocity_change) {
+  SmallProblem small({{"subcyclingParams/mode", "adaptive"},
+                      {"subcyclingParams/substeps", "2"},
+                      {"subcyclingParams/maxSubsteps", "16"},
+                      {"subcyclingParams/velocityTolerance", "0.05"}});
+
+  small.problem.updateForcingTerms();
+  small.problem.solveStokes();
+  EXPECT_EQ(2, small.problem.getStokesSubsteps());
+
+  // After each interval of 'steps' steps, the velocity has changed by a
+  // relative 1 - 1 / factor.
+  auto solveAfter = [&small](const int steps, const double factor) {
+    for (int step = 0; step < steps; ++step)
+      small.problem.advanceTimestep();
+    scaleTemperature(small, factor);
+    ASSERT_TRUE(small.problem.stokesSolveRequired());
+    small.problem.updateForcingTerms();
+    small.problem.solveStokes();
+  };
+
+  // A change of 1/101 over 2 steps allows 10 steps, but the interval at most
+  // doubles each solve.
+  solveAfter(2, 1.01);
+  EXPECT_EQ(4, small.problem.getStokesSubsteps());
+  solveAfter(4, 1.01);
+  EXPECT_EQ(8, small.problem.getStokesSubsteps());
+  // 1/3 over 8 steps allows a single step; shrinking is not limited.
+  solveAfter(8, 1.5);
+  EXPECT_EQ(1, small.problem.getStokesSubsteps());
+}
+
+TEST(OperatorSplittingTest, strang_half_steps_should_make_a_full_step) {
+  // Without advection, one Strang step of the linear explicit diffusion is
+  // two diffusion steps of half the length: the Lie split problem at half
+  // the CFL number takes exactly those.
+  SmallProblem strang({{"advectionMethod", "none"},
+                       {"diffusionMethod", "forwardEuler"},
+                       {"diffusivity", "1.0"},
+                       {"splittingMethod", "strang"}});
+  SmallProblem lie({{"advectionMethod", "none"},
+                    {"diffusionMethod", "forwardEuler"},
+                    {"diffusivity", "1.0"},
+                    {"splittingMethod", "lie"},
+                    {"cfl", "0.25"}});
+
+  strang.problem.recalculateTimestep();
+  lie.problem.recalculateTimestep();
+  ASSERT_DOUBLE_EQ(strang.problem.getDeltaT(), 2 * lie.problem.getDeltaT());
+
+  strang.problem.solveAdvectionDiffusion();
+  strang.problem.advanceTimestep();
+  for (int step = 0; step < 2; ++step) {
+    lie.problem.solveAdvectionDiffusion();
+    lie.problem.advanceTimestep();
+  }
+
+  // The full step is restored after the half steps.
+  EXPECT_DOUBLE_EQ(lie.problem.getTime(), strang.problem.getTime());
+  for (int c = 0; c < 8 * 8; ++c)
+    EXPECT_NEAR(lie.geometry.getTemperatureData()[c], strang.geometry.getTemperatureData()[c], 1E-12);
+}
@@ -67,3 +67,24 @@ TEST_F(ParamsTest, can_get_double_params) {
 
   EXPECT_DOUBLE_EQ(3.14159, expectedValue);
 }
+
+TEST_F(ParamsTest, can_override_params) {
+  treeBase->addParam("testKey", "42");
+  setParam<int>("testKey", 13);
+
+  int expectedValue;
+  getParam<int>("testKey", expectedValue);
+
+  EXPECT_EQ(13, expectedValue);
+}
+
+TEST_F(ParamsTest, can_try_push_long_missing_section) {
+  // Section keys too long for the small-string optimization must still be
+  // removed from the tree when the temporary section is popped.
+  EXPECT_NO_THROW(tryPush("aVeryLongBogusSectionName"));
+  EXPECT_NO_THROW(pop());
+
+  EXPECT_THROW(
+          push("aVeryLongBogusSectionName"),
+          KeyNotFoundException);
+}
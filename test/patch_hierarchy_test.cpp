@@ -0,0 +1,149 @@
+#include <vector>
+#include <cmath>
+#include <limits>
+
+#include <gtest/gtest.h>
+#include <boost/math/constants/constants.hpp>
+
+#include "debug/exception.h"
+#include "refinement/patchHierarchy.h"
+
+const double pi = boost::math::constants::pi<double>();
+// Round-off of one update of values of order one.
+const double epsilon = std::numeric_limits<Real>::epsilon();
+
+// Discretely divergence-free staggered velocity of the stream function
+// sin(pi x) sin(pi y) on the unit square, with no flow through the walls.
+struct RotatingFlow {
+  RotatingFlow(const int M, const int N) :
+      u((N - 1) * M), v(N * (M - 1)), uBoundary(2 * M, 0.0), vBoundary(2 * N, 0.0) {
+    const double hx = 1.0 / N, hy = 1.0 / M;
+    auto psi = [&](const int i, const int j) { return sin(pi * j * hx) * sin(pi * i * hy); };
+    for (int i = 0; i < M; ++i)
+      for (int j = 1; j < N; ++j)
+        u[i * (N - 1) + j - 1] = (psi(i + 1, j) - psi(i, j)) / hy;
+    for (int i = 1; i < M; ++i)
+      for (int j = 0; j < N; ++j)
+        v[(i - 1) * N + j] = -(psi(i, j + 1) - psi(i, j)) / hx;
+  }
+
+  std::vector<double> u, v, uBoundary, vBoundary;
+};
+
+// A disc of temperature 1 in a background of 0.
+static std::vector<Real> disc(const int M, const int N) {
+  std::vector<Real> temperature(M * N);
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N; ++j) {
+      const double x = (j + 0.5) / N - 0.3, y = (i + 0.5) / M - 0.5;
+      temperature[i * N + j] = (x * x + y * y < 0.15 * 0.15) ? 1.0 : 0.0;
+    }
+  return temperature;
+}
+
+TEST(PatchHierarchyTest, refinement_should_conserve_heat_and_follow_features) {
+  const int M = 32, N = 32;
+  RotatingFlow flow(M, N);
+  std::vector<Real> temperature = disc(M, N);
+
+  PatchHierarchy hierarchy;
+  hierarchy.setup(M, N, 1.0 / N, 1.0 / M, 3, 8, 2, 0.05, "fromm", "minmod", temperature.data());
+
+  // The patches cover the disc edge, but not the whole domain.
+  for (int l = 1; l < 3; ++l) {
+    EXPECT_GT(hierarchy.getPatchCount(l), 0);
+    EXPECT_LT(hierarchy.getPatchCount(l) * 64, (M << l) * (N << l));
+  }
+
+  double initialHeat = 0;
+  for (int c = 0; c < M * N; ++c)
+    initialHeat += temperature[c];
+
+  for (int step = 0; step < 40; ++step) {
+    hierarchy.advance(0.2 / (pi * M), flow.u.data(), flow.v.data(),
+                      flow.uBoundary.data(), flow.vBoundary.data());
+    EXPECT_GT(hierarchy.getCellUpdates(), M * N);
+  }
+  hierarchy.project(temperature.data());
+
+  double heat = 0;
+  for (int c = 0; c < M * N; ++c)
+    heat += temperature[c];
+  // Each step may round every cell's heat.
+  EXPECT_NEAR(initialHeat, heat, 40 * M * N * epsilon);
+
+  // The disc has moved down, and level 1 with its edge.
+  double yCenter = 0;
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N; ++j) {
+      yCenter += temperature[i * N + j] * (i + 0.5) / M;
+      if (temperature[i * N + j] > 0.2 && temperature[i * N + j] < 0.8) {
+        EXPECT_TRUE(hierarchy.covers(1, 2 * i, 2 * j));
+      }
+    }
+  EXPECT_LT(yCenter / heat, 0.45);
+}
+
+TEST(PatchHierarchyTest, constant_temperature_should_stay_constant) {
+  const int M = 16, N = 24;
+  RotatingFlow flow(M, N);
+  std::vector<Real> temperature(M * N, 2.0);
+
+  // A negative threshold refines everywhere proper nesting allows.
+  PatchHierarchy hierarchy;
+  hierarchy.setup(M, N, 1.0 / N, 1.0 / M, 3, 4, 1, -1.0, "fromm", "none", temperature.data());
+  ASSERT_GT(hierarchy.getPatchCount(2), 0);
+
+  for (int step = 0; step < 10; ++step)
+    hierarchy.advance(0.2 / (pi * N), flow.u.data(), flow.v.data(),
+                      flow.uBoundary.data(), flow.vBoundary.data());
+
+  for (int l = 0; l < 3; ++l)
+    for (int i = 0; i < (M << l); ++i)
+      for (int j = 0; j < (N << l); ++j)
+        if (hierarchy.covers(l, i, j)) {
+          EXPECT_NEAR(2.0, hierarchy.getValue(l, i, j), 100 * epsilon);
+        }
+}
+
+TEST(PatchHierarchyTest, refinement_should_reduce_numerical_diffusion) {
+  const int M = 32, N = 32;
+  RotatingFlow flow(M, N);
+  const std::vector<Real> initial = disc(M, N);
+
+  // Half a revolution and back again: the exact solution is the initial disc.
+  double error[2];
+  for (int levels = 1; levels <= 2; ++levels) {
+    std::vector<Real> temperature = initial;
+    PatchHierarchy hierarchy;
+    hierarchy.setup(M, N, 1.0 / N, 1.0 / M, levels, 8, 2, 0.05, "upwind", "none", temperature.data());
+
+    std::vector<double> uBack(flow.u.size()), vBack(flow.v.size());
+    for (size_t k = 0; k < uBack.size(); ++k) uBack[k] = -flow.u[k];
+    for (size_t k = 0; k < vBack.size(); ++k) vBack[k] = -flow.v[k];
+
+    for (int step = 0; step < 40; ++step)
+      hierarchy.advance(0.2 / (pi * M), flow.u.data(), flow.v.data(),
+                        flow.uBoundary.data(), flow.vBoundary.data());
+    for (int step = 0; step < 40; ++step)
+      hierarchy.advance(0.2 / (pi * M), uBack.data(), vBack.data(),
+                        flow.uBoundary.data(), flow.vBoundary.data());
+    hierarchy.project(temperature.data());
+
+    error[levels - 1] = 0;
+    for (int c = 0; c < M * N; ++c)
+      error[levels - 1] += std::abs(temperature[c] - initial[c]);
+  }
+  EXPECT_LT(error[1], 0.75 * error[0]);
+}
+
+TEST(PatchHierarchyTest, invalid_settings_should_throw) {
+  std::vector<Real> temperature(16, 0.0);
+  PatchHierarchy hierarchy;
+  EXPECT_THROW(hierarchy.setup(4, 4, 1, 1, 2, 5, 1, 0.1, "upwind", "none", temperature.data()),
+               InvalidArgument);
+  EXPECT_THROW(hierarchy.setup(4, 4, 1, 1, 2, 4, 1, 0.1, "laxWendroff", "none", temperature.data()),
+               InvalidArgument);
+  EXPECT_THROW(hierarchy.setup(4, 4, 1, 1, 2, 4, 1, 0.1, "fromm", "koren", temperature.data()),
+               InvalidArgument);
+}
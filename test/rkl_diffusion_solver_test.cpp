@@ -0,0 +1,40 @@
+#include <vector>
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "solvers/rklDiffusionSolver.h"
+
+TEST(RKLDiffusionSolverTest, stage_count_should_cover_the_step) {
+  EXPECT_EQ(2, RKLDiffusionSolver::stageCount(0.5));
+  EXPECT_EQ(2, RKLDiffusionSolver::stageCount(1));
+  EXPECT_EQ(3, RKLDiffusionSolver::stageCount(2.5));
+  for (double ratio = 1; ratio < 1000; ratio *= 1.7) {
+    int s = RKLDiffusionSolver::stageCount(ratio);
+    EXPECT_GE(s * s + s - 2, 4 * ratio);
+    EXPECT_LT((s - 1) * (s - 1) + (s - 1) - 2, 4 * ratio);
+  }
+}
+
+TEST(RKLDiffusionSolverTest, long_steps_should_damp_the_stiffest_mode) {
+  // A checkerboard is the fastest-decaying mode; forward Euler with fifty
+  // times its stable step would amplify it by ~200 per step.
+  const int M = 8, N = 8;
+  const double h = 1.0 / N, diffusivity = 1.0;
+  const double deltaT = 50 * h * h / (4 * diffusivity);
+
+  std::vector<double> temperature(M * N), result(M * N), boundary(2 * N, 0.0);
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N; ++j)
+      temperature[i * N + j] = ((i + j) % 2) ? 1 : -1;
+
+  RKLDiffusionSolver solver;
+  solver.setup(M, N);
+  for (int step = 0; step < 10; ++step) {
+    solver.step(deltaT, diffusivity, h, h, temperature.data(), boundary.data(), result.data());
+    temperature.swap(result);
+  }
+
+  for (int k = 0; k < M * N; ++k)
+    EXPECT_LT(std::abs(temperature[k]), 1.0);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "geometry/geometry.h"
+#include "problem/problem.h"
+#include "params/paramParser.h"
+#include "params.h"
+
+/* The example problem on an 8x8 (or 'size' x 'size') grid of the unit
+ * square, with the given problemParams overrides and 'compositionFields'
+ * compositional fields, initialized and ready to step. The velocity is left
+ * to the test (see setUniformVelocity()). */
+struct SmallProblem {
+  typedef std::vector<std::pair<std::string, std::string> > Overrides;
+
+  SmallProblem(const Overrides &overrides, const int size = 8, const int compositionFields = 0) :
+      params(load(overrides, size, compositionFields)), geometry(params), problem(params, geometry) {
+    problem.initializeProblem();
+  }
+
+  // A uniform rightward flow of speed 'u' through the interior faces.
+  void setUniformVelocity(const double u) {
+    const int M = geometry.getM(), N = geometry.getN();
+    std::fill(geometry.getUVelocityData(), geometry.getUVelocityData() + M * (N - 1), u);
+    std::fill(geometry.getVVelocityData(), geometry.getVVelocityData() + (M - 1) * N, 0.0);
+  }
+
+  static Params &load(const Overrides &overrides, const int size, const int compositionFields) {
+    ParamParser pp;
+    pp.load("exampleParameters");
+    Params &params = pp.getParams();
+
+    params.push("geometryParams");
+    params.setParam<int>("M", size);
+    params.setParam<int>("N", size);
+    params.setParam<int>("compositionFields", compositionFields);
+    params.pop();
+
+    params.push("problemParams");
+    params.setParam<double>("endTime", 100.0);
+    for (auto &entry : overrides) {
+      // 'subsection/key' overrides go one level further down.
+      size_t slash = entry.first.find('/');
+      if (slash != std::string::npos) {
+        params.tryPush(entry.first.substr(0, slash));
+        params.setParam<std::string>(entry.first.substr(slash + 1), entry.second);
+        params.pop();
+      } else {
+        params.setParam<std::string>(entry.first, entry.second);
+      }
+    }
+    params.pop();
+
+    return params;
+  }
+
+  Params &params;
+  GeometryStructure geometry;
+  ProblemStructure problem;
+};
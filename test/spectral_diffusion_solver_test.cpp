@@ -0,0 +1,57 @@
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+#include <gtest/gtest.h>
+
+#include "solvers/spectralDiffusionSolver.h"
+
+TEST(SpectralDiffusionSolverTest, solution_should_satisfy_the_diffusion_stencil) {
+  // Insulated left/right boundaries and zero lower/upper boundaries, on a
+  // non-square grid so that both transforms are exercised with different sizes,
+  // of cells wider than they are tall.
+  const int M = 5, N = 7;
+  const double muX = 0.8, muY = 2.1;
+
+  std::vector<double> rhs(M * N), solution(M * N);
+  std::srand(17);
+  for (int k = 0; k < M * N; ++k)
+    rhs[k] = solution[k] = double(std::rand()) / RAND_MAX - 0.5;
+
+  SpectralDiffusionSolver solver;
+  solver.setup(M, N);
+  solver.solve(muX, muY, solution.data());
+
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N; ++j) {
+      double xDiagonal = ((j == 0) || (j == N - 1)) ? 1 : 2;
+      double value = (1 + xDiagonal * muX + 2 * muY) * solution[i * N + j];
+      if (j > 0)     value -= muX * solution[i * N + (j - 1)];
+      if (j < N - 1) value -= muX * solution[i * N + (j + 1)];
+      if (i > 0)     value -= muY * solution[(i - 1) * N + j];
+      if (i < M - 1) value -= muY * solution[(i + 1) * N + j];
+
+      EXPECT_NEAR(rhs[i * N + j], value, 1E-12);
+    }
+}
+
+TEST(SpectralDiffusionSolverTest, single_precision_solve_should_round_the_double_solution) {
+  const int M = 6, N = 4;
+  const double mu = 2.5;
+
+  std::vector<float> single(M * N);
+  std::vector<double> reference(M * N);
+  std::srand(5);
+  for (int k = 0; k < M * N; ++k) {
+    single[k] = float(std::rand()) / RAND_MAX;
+    reference[k] = single[k];
+  }
+
+  SpectralDiffusionSolver solver;
+  solver.setup(M, N);
+  solver.solve(mu, mu, reference.data());
+  solver.solve(mu, mu, single.data());
+
+  for (int k = 0; k < M * N; ++k)
+    EXPECT_EQ(float(reference[k]), single[k]);
+}
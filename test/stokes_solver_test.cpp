@@ -0,0 +1,327 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <boost/filesystem.hpp>
+#include <Eigen/Sparse>
+#include <Eigen/Dense>
+
+#include "debug/exception.h"
+#include "matrixForms/sparseForms.h"
+#include "solvers/stokesSolver.h"
+#include "smallProblem.h"
+
+// Stokes system for an MxN unit square with viscosity contrast 'contrast'
+// between the left and right halves.
+static SparseMatrixXd stokesSystem(const int M, const int N, const double contrast) {
+  std::vector<double> viscosity((M + 1) * (N + 1));
+  for (int i = 0; i <= M; ++i)
+    for (int j = 0; j <= N; ++j)
+      viscosity[i * (N + 1) + j] = (2 * j < N) ? 1.0 : contrast;
+
+  std::vector<double> widths(N, 1.0 / N), heights(M, 1.0 / M);
+
+  SparseMatrixXd matrix(3 * M * N - M - N, 3 * M * N - M - N);
+  SparseForms::makeStokesMatrix(matrix, M, N, widths.data(), heights.data(), viscosity.data());
+  matrix.makeCompressed();
+  return matrix;
+}
+
+TEST(StokesSolverTest, mixed_precision_should_refine_to_tolerance) {
+  const int M = 12, N = 12;
+  SparseMatrixXd matrix = stokesSystem(M, N, 10.0);
+
+  // A right-hand side in the range of the (pressure-singular) system.
+  Eigen::VectorXd rhs = matrix * Eigen::VectorXd::Random(matrix.cols());
+
+  StokesSolver solver;
+  solver.setup("mixed", 1E-12, 10);
+  solver.compute(matrix);
+  Eigen::VectorXd solution = solver.solve(rhs);
+
+  EXPECT_FALSE(solver.usedFallback());
+  EXPECT_GT(solver.getRefinementIterations(), 0);
+  EXPECT_LT((rhs - matrix * solution).norm(), 1E-12 * rhs.norm());
+}
+
+TEST(StokesSolverTest, stalled_refinement_should_fall_back_to_double) {
+  const int M = 12, N = 12;
+  SparseMatrixXd matrix = stokesSystem(M, N, 10.0);
+  Eigen::VectorXd rhs = matrix * Eigen::VectorXd::Random(matrix.cols());
+
+  StokesSolver doubleSolver;
+  doubleSolver.compute(matrix);
+  Eigen::VectorXd expected = doubleSolver.solve(rhs);
+
+  // A zero tolerance cannot be met, so refinement has to give up.
+  StokesSolver solver;
+  solver.setup("mixed", 0, 10);
+  solver.compute(matrix);
+  Eigen::VectorXd solution = solver.solve(rhs);
+
+  EXPECT_TRUE(solver.usedFallback());
+  EXPECT_LT((rhs - matrix * solution).norm(), 1E-10 * rhs.norm());
+  EXPECT_LT((rhs - matrix * expected).norm(), 1E-10 * rhs.norm());
+}
+
+TEST(StokesSolverTest, later_solvers_should_load_the_cached_ordering) {
+  const int M = 8, N = 8;
+  SparseMatrixXd matrix = stokesSystem(M, N, 10.0);
+  Eigen::VectorXd rhs = matrix * Eigen::VectorXd::Random(matrix.cols());
+
+  boost::filesystem::path directory =
+      boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+  StokesSolver first;
+  first.setOrderingCache(directory.string());
+  first.compute(matrix);
+  Eigen::VectorXd expected = first.solve(rhs);
+  EXPECT_FALSE(first.orderingFromCache());
+
+  StokesSolver second;
+  second.setOrderingCache(directory.string());
+  second.compute(matrix);
+  Eigen::VectorXd solution = second.solve(rhs);
+  EXPECT_TRUE(second.orderingFromCache());
+  EXPECT_EQ(0, (expected - solution).cwiseAbs().maxCoeff());
+
+  // The ordering only depends on the sparsity pattern: a different
+  // viscosity field shares the entry, a different grid does not.
+  SparseMatrixXd viscous = stokesSystem(M, N, 100.0);
+  StokesSolver third;
+  third.setOrderingCache(directory.string());
+  third.compute(viscous);
+  EXPECT_TRUE(third.orderingFromCache());
+  Eigen::VectorXd viscousRhs = viscous * Eigen::VectorXd::Random(viscous.cols());
+  EXPECT_LT((viscous * third.solve(viscousRhs) - viscousRhs).norm(), 1E-10 * viscousRhs.norm());
+
+  SparseMatrixXd larger = stokesSystem(2 * M, N, 10.0);
+  StokesSolver fourth;
+  fourth.setOrderingCache(directory.string());
+  fourth.compute(larger);
+  EXPECT_FALSE(fourth.orderingFromCache());
+
+  boost::filesystem::remove_all(directory);
+}
+
+TEST(StokesSolverTest, failed_cache_writes_should_be_ignored) {
+  SparseMatrixXd matrix = stokesSystem(8, 8, 10.0);
+  Eigen::VectorXd rhs = matrix * Eigen::VectorXd::Random(matrix.cols());
+
+  boost::filesystem::path directory =
+      boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+  // The directory disappears before the entry is stored.
+  StokesSolver solver;
+  solver.setOrderingCache(directory.string());
+  boost::filesystem::remove_all(directory);
+  EXPECT_NO_THROW(solver.compute(matrix));
+  EXPECT_FALSE(solver.orderingFromCache());
+  EXPECT_LT((rhs - matrix * solver.solve(rhs)).norm(), 1E-10 * rhs.norm());
+}
+
+TEST(StokesSolverTest, multiple_right_hand_sides_should_match_single_solves) {
+  const int M = 8, N = 8;
+  SparseMatrixXd matrix = stokesSystem(M, N, 10.0);
+  Eigen::MatrixXd rhs = matrix * Eigen::MatrixXd::Random(matrix.cols(), 3);
+
+  const char * precisions[] = {"double", "mixed"};
+  for (const char * precision : precisions) {
+    StokesSolver solver;
+    solver.setup(precision, 1E-12, 10);
+    solver.compute(matrix);
+
+    Eigen::MatrixXd solution;
+    solver.solve(rhs, solution);
+
+    for (int k = 0; k < rhs.cols(); ++k) {
+      Eigen::VectorXd column = solver.solve(Eigen::VectorXd(rhs.col(k)));
+      EXPECT_LT((rhs.col(k) - matrix * solution.col(k)).norm(), 1E-12 * rhs.col(k).norm());
+      EXPECT_LT((solution.col(k) - column).norm(), 1E-10 * column.norm());
+    }
+  }
+}
+
+TEST(StokesSolverTest, every_ordering_should_solve_the_system) {
+  const int M = 12, N = 16;
+  SparseMatrixXd matrix = stokesSystem(M, N, 10.0);
+  Eigen::VectorXd rhs = matrix * Eigen::VectorXd::Random(matrix.cols());
+
+  std::vector<std::string> methods = {"colamd", "amd", "nestedDissection"};
+#ifdef USE_METIS
+  methods.push_back("metis");
+#endif
+  for (const std::string &method : methods) {
+    for (const std::string precision : {"double", "mixed"}) {
+      StokesSolver solver;
+      solver.setup(precision, 1E-12, 10);
+      solver.setOrdering(method, M, N);
+      solver.compute(matrix);
+      Eigen::VectorXd solution = solver.solve(rhs);
+
+      EXPECT_GT(solver.factorNonZeros(), matrix.nonZeros()) << method;
+      EXPECT_LT((rhs - matrix * solution).norm(), 1E-10 * rhs.norm()) << method << " " << precision;
+    }
+  }
+}
+
+TEST(StokesSolverTest, unknown_orderings_should_throw) {
+  StokesSolver solver;
+  EXPECT_THROW(solver.setOrdering("rcm", 8, 8), InvalidArgument);
+#ifndef USE_METIS
+  EXPECT_THROW(solver.setOrdering("metis", 8, 8), InvalidArgument);
+#endif
+}
+
+TEST(StokesSolverTest, schur_backend_should_match_sparse_lu) {
+  const int M = 12, N = 12;
+  const double contrasts[] = {1.0, 10.0};
+  for (double contrast : contrasts) {
+    SparseMatrixXd matrix = stokesSystem(M, N, contrast);
+    Eigen::VectorXd rhs = matrix * Eigen::VectorXd::Random(matrix.cols());
+
+    StokesSolver luSolver;
+    luSolver.compute(matrix);
+    Eigen::VectorXd expected = luSolver.solve(rhs);
+
+    StokesSolver solver;
+    solver.setup("double", 1E-10, 10);
+    solver.setBackend("schur", M * N, 500);
+    solver.compute(matrix);
+    Eigen::VectorXd solution = solver.solve(rhs);
+
+    EXPECT_LT((rhs - matrix * solution).norm(), 1E-8 * rhs.norm());
+
+    // The pressures may differ by a constant.
+    const int velocitySize = matrix.cols() - M * N;
+    Eigen::VectorXd difference = solution - expected;
+    difference.tail(M * N).array() -= difference.tail(M * N).mean();
+    EXPECT_LT(difference.norm(), 1E-6 * expected.norm());
+    EXPECT_LT(difference.head(velocitySize).norm(), 1E-6 * expected.head(velocitySize).norm());
+  }
+}
+
+TEST(StokesSolverTest, schur_backend_should_converge_faster_from_a_nearby_guess) {
+  const int M = 12, N = 12;
+  SparseMatrixXd matrix = stokesSystem(M, N, 10.0);
+  Eigen::VectorXd rhs = matrix * Eigen::VectorXd::Random(matrix.cols());
+
+  StokesSolver solver;
+  solver.setup("double", 1E-10, 10);
+  solver.setBackend("schur", M * N, 500);
+  solver.compute(matrix);
+  Eigen::VectorXd previous = solver.solve(rhs);
+  const int coldIterations = solver.getIterations();
+
+  Eigen::VectorXd nextRhs = rhs + 1E-3 * (matrix * Eigen::VectorXd::Random(matrix.cols()));
+  Eigen::VectorXd solution = solver.solve(nextRhs, previous);
+
+  EXPECT_LT((nextRhs - matrix * solution).norm(), 1E-8 * nextRhs.norm());
+  EXPECT_LT(solver.getIterations(), coldIterations);
+}
+
+TEST(StokesSolverTest, stretched_grid_should_be_exact_for_linear_fields) {
+  const int M = 10, N = 8;
+  std::vector<double> viscosity((M + 1) * (N + 1), 1.0);
+  std::vector<double> widths(N), heights(M), x(N + 1, 0.0), y(M + 1, 0.0);
+  for (int j = 0; j < N; ++j) {
+    widths[j] = 1.0 + j;
+    x[j + 1] = x[j] + widths[j];
+  }
+  for (int i = 0; i < M; ++i) {
+    heights[i] = 0.5 + (i % 3);
+    y[i + 1] = y[i] + heights[i];
+  }
+
+  const int uSize = M * (N - 1), vSize = (M - 1) * N, size = 3 * M * N - M - N;
+  SparseMatrixXd matrix(size, size);
+  SparseForms::makeStokesMatrix(matrix, M, N, widths.data(), heights.data(), viscosity.data());
+
+  // p = x + 2y at the cell centers: the gradient rows must all be equal.
+  Eigen::VectorXd pressure = Eigen::VectorXd::Zero(size);
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N; ++j)
+      pressure(uSize + vSize + i * N + j) = (x[j] + x[j + 1]) / 2 + (y[i] + y[i + 1]);
+  Eigen::VectorXd gradient = matrix * pressure;
+  for (int k = 0; k < uSize; ++k)
+    EXPECT_NEAR(gradient(k), gradient(0), 1E-12);
+  for (int k = uSize; k < uSize + vSize; ++k)
+    EXPECT_NEAR(gradient(k), 2 * gradient(0), 1E-12);
+
+  // u = x on the interior faces, with the wall faces at x = 0 and x = xExtent
+  // left out of the matrix: the continuity rows of the interior cells match.
+  Eigen::VectorXd velocity = Eigen::VectorXd::Zero(size);
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N - 1; ++j)
+      velocity(i * (N - 1) + j) = x[j + 1];
+  Eigen::VectorXd divergence = matrix * velocity;
+  const double interior = divergence(uSize + vSize + 1);
+  EXPECT_NE(interior, 0.0);
+  for (int i = 0; i < M; ++i)
+    for (int j = 1; j < N - 1; ++j)
+      EXPECT_NEAR(divergence(uSize + vSize + i * N + j), interior, 1E-12);
+}
+
+TEST(StokesSolverTest, row_ranges_should_assemble_the_matching_rows) {
+  const int M = 7, N = 9, size = 3 * M * N - M - N;
+  std::vector<double> viscosity((M + 1) * (N + 1));
+  for (size_t k = 0; k < viscosity.size(); ++k)
+    viscosity[k] = 1.0 + k % 5;
+  std::vector<double> widths(N), heights(M);
+  for (int j = 0; j < N; ++j)
+    widths[j] = 1.0 + j;
+  for (int i = 0; i < M; ++i)
+    heights[i] = 0.5 + (i % 3);
+
+  SparseMatrixXd matrix(size, size);
+  SparseForms::makeStokesMatrix(matrix, M, N, widths.data(), heights.data(), viscosity.data());
+
+  // Ranges splitting rows of the grid and the blocks of the system.
+  const int bounds[] = {0, 5, M * (N - 1) + 3, 2 * M * N - M - N + N + 1, size - 2, size};
+  for (int k = 0; k + 1 < 6; ++k) {
+    const int begin = bounds[k], end = bounds[k + 1];
+    SparseMatrixXd rows(end - begin, size);
+    SparseForms::makeStokesMatrix(rows, M, N, widths.data(), heights.data(), viscosity.data(),
+                                  SparseForms::RowRange(begin, end));
+
+    SparseMatrixXd expected = matrix.middleRows(begin, end - begin);
+    EXPECT_EQ(expected.nonZeros(), rows.nonZeros());
+    EXPECT_EQ(0.0, (Eigen::MatrixXd(expected) - Eigen::MatrixXd(rows)).norm());
+  }
+}
+
+#ifdef USE_PETSC
+TEST(StokesSolverTest, petsc_backend_should_match_sparse_lu) {
+  const int M = 8, N = 8;
+  SparseMatrixXd matrix = stokesSystem(M, N, 10.0);
+  Eigen::VectorXd rhs = matrix * Eigen::VectorXd::Random(matrix.cols());
+
+  StokesSolver solver;
+  solver.setup("double", 1E-10, 10);
+  solver.setBackend("petsc", M * N, 500);
+  // A single process owns every row.
+  GridIndex rowBegin, rowEnd;
+  solver.ownedRows(matrix.rows(), rowBegin, rowEnd);
+  ASSERT_EQ(0, rowBegin);
+  ASSERT_EQ(matrix.rows(), rowEnd);
+  solver.compute(matrix);
+  Eigen::VectorXd solution = solver.solve(rhs);
+
+  EXPECT_LT((rhs - matrix * solution).norm(), 1E-8 * rhs.norm());
+}
+#else
+TEST(StokesSolverTest, petsc_backend_should_require_petsc) {
+  StokesSolver solver;
+  EXPECT_THROW(solver.setBackend("petsc", 64, 500), InvalidArgument);
+  EXPECT_THROW(solver.setBackend("umfpack", 64, 500), InvalidArgument);
+}
+#endif
+
+TEST(StokesSolverTest, shared_systems_should_require_the_same_settings) {
+  SmallProblem first({{"stokesSolverParams/precision", "double"}}, 8);
+  SmallProblem same({{"stokesSolverParams/orderingCache", ""}}, 8);
+  SmallProblem mixed({{"stokesSolverParams/precision", "mixed"}}, 8);
+
+  EXPECT_NO_THROW(same.problem.shareStokesSystem(first.problem));
+  EXPECT_THROW(mixed.problem.shareStokesSystem(first.problem), InvalidArgument);
+}
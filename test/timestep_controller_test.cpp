@@ -0,0 +1,116 @@
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+#include "smallProblem.h"
+
+// On the 8x8 unit square h = 1/8, and the example cfl is 0.5.
+const double h = 0.125, cfl = 0.5;
+
+TEST(TimestepControllerTest, explicit_limits_should_bound_the_step) {
+  SmallProblem small({{"advectionMethod", "upwindMethod"},
+                      {"diffusionMethod", "forwardEuler"},
+                      {"diffusivity", "0.001"}});
+
+  // A fast flow is held to the CFL limit of the upwind scheme...
+  small.setUniformVelocity(1.0);
+  small.problem.recalculateTimestep();
+  EXPECT_DOUBLE_EQ(cfl * h / 1.0, small.problem.getDeltaT());
+
+  // ... and a slow one to the h^2 limit of the explicit diffusion.
+  small.setUniformVelocity(0.01);
+  small.problem.recalculateTimestep();
+  EXPECT_DOUBLE_EQ(cfl / (2 * 0.001 * 2 / (h * h)), small.problem.getDeltaT());
+}
+
+TEST(TimestepControllerTest, implicit_diffusion_should_only_limit_accuracy) {
+  SmallProblem small({{"advectionMethod", "upwindMethod"},
+                      {"diffusionMethod", "backwardEuler"},
+                      {"diffusivity", "1.0"}});
+  small.setUniformVelocity(0.0);
+
+  small.problem.recalculateTimestep();
+  EXPECT_DOUBLE_EQ(cfl * h / 1.0, small.problem.getDeltaT());
+
+  // Fromm's half-time predictor diffuses explicitly, whatever the method.
+  SmallProblem fromm({{"advectionMethod", "frommMethod"},
+                      {"diffusionMethod", "backwardEuler"},
+                      {"diffusivity", "1.0"}});
+  fromm.setUniformVelocity(0.0);
+
+  fromm.problem.recalculateTimestep();
+  EXPECT_DOUBLE_EQ(cfl / (2 * 1.0 * 2 / (h * h)), fromm.problem.getDeltaT());
+}
+
+TEST(TimestepControllerTest, controller_growth_should_be_clamped) {
+  // Nothing changes the temperature, so the step grows by maxGrowth.
+  SmallProblem small({{"advectionMethod", "none"},
+                      {"diffusionMethod", "none"},
+                      {"diffusivity", "1.0"},
+                      {"timestepController", "pi"},
+                      {"timestepParams/maxGrowth", "1.5"}});
+
+  small.problem.recalculateTimestep();
+  const double deltaT = small.problem.getDeltaT();
+  for (int step = 1; step <= 3; ++step) {
+    small.problem.solveAdvectionDiffusion();
+    small.problem.recalculateTimestep();
+    EXPECT_DOUBLE_EQ(deltaT * std::pow(1.5, step), small.problem.getDeltaT());
+  }
+}
+
+TEST(TimestepControllerTest, controller_shrink_should_be_clamped) {
+  // The disc's edge moves by half a cell, far past the tolerance; without
+  // rejection the next step shrinks by no more than minShrink.
+  SmallProblem small({{"advectionMethod", "upwindMethod"},
+                      {"diffusionMethod", "none"},
+                      {"timestepController", "pi"},
+                      {"timestepParams/tolerance", "1E-06"},
+                      {"timestepParams/rejectionRatio", "1E+09"}});
+  small.setUniformVelocity(1.0);
+
+  small.problem.recalculateTimestep();
+  const double deltaT = small.problem.getDeltaT();
+  EXPECT_DOUBLE_EQ(cfl * h, deltaT);
+
+  small.problem.solveAdvectionDiffusion();
+  EXPECT_EQ(0, small.problem.getRejectedSteps());
+  EXPECT_DOUBLE_EQ(deltaT, small.problem.getDeltaT());
+
+  small.problem.recalculateTimestep();
+  EXPECT_DOUBLE_EQ(0.2 * deltaT, small.problem.getDeltaT());
+}
+
+TEST(TimestepControllerTest, overshooting_steps_should_be_retried) {
+  SmallProblem small({{"advectionMethod", "upwindMethod"},
+                      {"diffusionMethod", "none"},
+                      {"timestepController", "pi"},
+                      {"timestepParams/tolerance", "1E-02"},
+                      {"timestepParams/rejectionRatio", "2.0"}});
+  small.setUniformVelocity(1.0);
+
+  const int size = 8 * 8;
+  const std::vector<Real> start(small.geometry.getTemperatureData(),
+                                small.geometry.getTemperatureData() + size);
+
+  small.problem.recalculateTimestep();
+  const double deltaT = small.problem.getDeltaT();
+  small.problem.solveAdvectionDiffusion();
+
+  // The accepted step is shorter, and within the rejection threshold.
+  EXPECT_GT(small.problem.getRejectedSteps(), 0);
+  EXPECT_LT(small.problem.getDeltaT(), deltaT);
+
+  double change = 0, scale = 0;
+  for (int c = 0; c < size; ++c) {
+    change = std::max(change, std::abs(double(small.geometry.getTemperatureData()[c] - start[c])));
+    scale = std::max(scale, std::abs(double(small.geometry.getTemperatureData()[c])));
+  }
+  EXPECT_LE(change / scale, 2 * 1E-02);
+
+  // The retried step is the one taken.
+  small.problem.advanceTimestep();
+  EXPECT_DOUBLE_EQ(small.problem.getDeltaT(), small.problem.getTime());
+}
@@ -0,0 +1,65 @@
+#include <vector>
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+#include "tracers/tracers.h"
+
+TEST(TracerStructureTest, binning_should_group_tracers_by_cell) {
+  const int M = 4, N = 5;
+  std::vector<Real> temperature(M * N);
+  for (int c = 0; c < M * N; ++c)
+    temperature[c] = c;
+
+  // Cells twice as wide as they are tall.
+  TracerStructure tracers;
+  tracers.seed(M, N, 0, 0.5, 0.25, 2, 1, temperature.data(), NULL);
+
+  ASSERT_EQ(M * N * 4, tracers.getTracerCount());
+  const GridIndex * cellStart = tracers.getCellStartData();
+  for (int c = 0; c < M * N; ++c) {
+    EXPECT_EQ(4, cellStart[c + 1] - cellStart[c]);
+    for (int k = cellStart[c]; k < cellStart[c + 1]; ++k) {
+      EXPECT_EQ(c % N, int(tracers.getXData()[k] / 0.5));
+      EXPECT_EQ(c / N, int(tracers.getYData()[k] / 0.25));
+    }
+  }
+}
+
+TEST(TracerStructureTest, uniform_flow_should_translate_tracers_and_fields) {
+  // A uniform rightward flow of one cell per step moves each column of
+  // tracers into the next cell; the insulated right wall collects them.
+  const int M = 3, N = 4, K = 2;
+  const double h = 1.0;
+  std::vector<double> uVelocity((N - 1) * M, 1.0), uBoundary(2 * M, 1.0);
+  std::vector<double> vVelocity(N * (M - 1), 0.0), vBoundary(2 * N, 0.0);
+
+  std::vector<Real> temperature(M * N), composition(M * N * K);
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N; ++j) {
+      temperature[i * N + j] = j;
+      composition[(i * N + j) * K]     = (j == 0) ? 1.0 : 0.0;
+      composition[(i * N + j) * K + 1] = i;
+    }
+
+  TracerStructure tracers;
+  tracers.seed(M, N, K, h, h, 2, 3, temperature.data(), composition.data());
+
+  for (int step = 0; step < 2; ++step) {
+    tracers.advect("rungeKutta4", 1.0, uVelocity.data(), vVelocity.data(),
+                   uBoundary.data(), vBoundary.data());
+    tracers.bin();
+    tracers.project(temperature.data(), composition.data());
+  }
+
+  // Columns 0 and 1 are now empty; column 3 holds the tracers of columns
+  // 1 to 3 in equal numbers.
+  for (int i = 0; i < M; ++i) {
+    EXPECT_DOUBLE_EQ(0.0, temperature[i * N + 2]);
+    EXPECT_DOUBLE_EQ(2.0, temperature[i * N + 3]);
+    EXPECT_DOUBLE_EQ(1.0, composition[(i * N + 2) * K]);
+    EXPECT_DOUBLE_EQ(0.0, composition[(i * N + 3) * K]);
+    EXPECT_DOUBLE_EQ(i, composition[(i * N + 2) * K + 1]);
+    EXPECT_DOUBLE_EQ(i, composition[(i * N + 3) * K + 1]);
+  }
+}